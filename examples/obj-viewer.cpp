@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <limits>
 
 #include "sre/Texture.hpp"
 #include "sre/Renderer.hpp"
@@ -37,9 +38,9 @@ public:
         auto material = Shader::getStandardBlinnPhong()->createMaterial();
         material->setColor({1.0f,1.0f,1.0f,1.0f});
         material->setSpecularity(Color(1,1,1,20.0f));
-        materials.push_back(material);
+        materials.push_back({material});
 
-        mesh = Mesh::create().withCube().build();
+        meshes.push_back(Mesh::create().withCube().build());
         worldLights.addLight(Light::create().build());
         worldLights.addLight(Light::create().build());
         worldLights.addLight(Light::create().build());
@@ -119,11 +120,25 @@ public:
         auto path = file.substr(0,pos);
         auto filename = file.substr(pos);
 
-        materials.clear();
-        mesh = ModelImporter::importObj(path, filename, materials);
+        // a mesh per object/group allows the parts outside the view to be culled (parts with more than 65536 vertices are split)
+        auto parts = ModelImporter::importObjParts(path, filename);
+        if (parts.empty()){
+            return;
+        }
+        std::vector<std::shared_ptr<Mesh>> loadedMeshes;
+        std::vector<std::vector<std::shared_ptr<Material>>> loadedMaterials;
+        glm::vec3 bounds[2] = {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max())};
+        for (auto& part : parts){
+            auto meshBounds = part.mesh->getBoundsMinMax();
+            bounds[0] = glm::min(bounds[0], meshBounds[0]);
+            bounds[1] = glm::max(bounds[1], meshBounds[1]);
+            loadedMeshes.push_back(part.mesh);
+            loadedMaterials.push_back(part.materials);
+        }
+        meshes = loadedMeshes;
+        materials = loadedMaterials;
 
-        std::cout<<materials.size()<< " "<<mesh->getIndexSets()<<std::endl;
-        auto bounds = mesh->getBoundsMinMax();
+        std::cout<<meshes.size()<< " meshes"<<std::endl;
         auto center = glm::mix(bounds[1] , bounds[0],0.5f);
         offset = -center;
 
@@ -138,9 +153,13 @@ public:
                 .withCamera(camera)
                 .withWorldLights(&worldLights)
                 .withClearColor(true, {0, 0, 0, 1})
+                .withFrustumCulling()
                 .build();
 
-        renderPass.draw(mesh, glm::scale(glm::vec3(0.5f))*glm::eulerAngleY(glm::radians((float)i))*glm::translate(offset), materials);
+        auto modelTransform = glm::scale(glm::vec3(0.5f))*glm::eulerAngleY(glm::radians((float)i))*glm::translate(offset);
+        for (int j=0;j<meshes.size();j++){
+            renderPass.draw(meshes[j], modelTransform, materials[j]);
+        }
 
         lightGUI();
 
@@ -224,8 +243,8 @@ private:
     SDLRenderer r;
     Camera camera;
     WorldLights worldLights;
-    std::shared_ptr<Mesh> mesh;
-    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::vector<std::shared_ptr<Material>>> materials;
     int i=0;
     glm::vec3 offset{0};
     float farPlane = 100;
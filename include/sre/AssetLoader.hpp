@@ -0,0 +1,123 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <condition_variable>
+#endif
+
+#include "sre/impl/Export.hpp"
+#include "sre/Texture.hpp"
+
+namespace sre {
+    class Mesh;
+    class Material;
+    class SpriteAtlas;
+
+    // Mesh and materials of an obj file loaded by AssetLoader::loadObj()
+    struct ObjAsset {
+        std::shared_ptr<Mesh> mesh;
+        std::vector<std::shared_ptr<Material>> materials;
+    };
+
+    // Result of an asynchronous load. The asset is available when isDone() returns true (get() returns nullptr if the
+    // load failed)
+    template<typename T>
+    class AssetHandle {
+    public:
+        AssetHandle() = default;
+
+        bool isDone() const {
+            return state && state->done;
+        }
+        bool isFailed() const {
+            return isDone() && state->asset == nullptr;
+        }
+        std::shared_ptr<T> get() const {
+            return isDone() ? state->asset : nullptr;
+        }
+    private:
+        struct State {
+            std::atomic<bool> done{false};
+            std::shared_ptr<T> asset;
+        };
+        std::shared_ptr<State> state;
+        friend class AssetLoader;
+    };
+
+    /**
+     * Loads textures, obj models and sprite atlases in the background.
+     *
+     * File reading and decoding runs on worker threads. The OpenGL upload runs on the render thread in update(),
+     * which processes uploads until the per frame time budget is used (at least one upload step is processed each
+     * frame). SDLRenderer calls update() each frame before frameUpdate.
+     *
+     * Example:
+     * auto texture = AssetLoader::loadTexture("test_data/gamma-test.png");
+     * ...
+     * if (texture.isDone()) material->setTexture(texture.get());
+     *
+     * Textures (including the textures of obj materials) are shared with ResourceCache.
+     * On Emscripten (no threads) the loading also runs in update() within the time budget.
+     */
+    class DllExport AssetLoader {
+    public:
+        static AssetHandle<Texture> loadTexture(const std::string& filename, bool generateMipmaps = false,
+                                                std::function<void(std::shared_ptr<Texture>)> onLoaded = {});
+        static AssetHandle<ObjAsset> loadObj(const std::string& path, const std::string& filename,
+                                             std::function<void(std::shared_ptr<ObjAsset>)> onLoaded = {});
+        static AssetHandle<SpriteAtlas> loadAtlas(const std::string& jsonFile, const std::string& imageFile, bool flipAnchorY = true,
+                                                  std::function<void(std::shared_ptr<SpriteAtlas>)> onLoaded = {});
+                                                            // onLoaded is invoked on the render thread when the asset is
+                                                            // uploaded (with nullptr if the load failed)
+
+        static void update();                               // Upload loaded assets within the time budget (render thread)
+        static void finish();                               // Block until all pending assets are loaded and uploaded
+        static void setUploadBudget(float milliseconds);    // Time used for uploads per frame (default 4 ms)
+        static float getUploadBudget();
+        static int getPendingCount();                       // Number of assets not yet uploaded
+        ~AssetLoader();
+    private:
+        struct Job {
+            std::function<void()> load;                     // worker thread: file io and decoding
+            std::function<bool()> upload;                   // render thread: upload a single step. Returns true when done
+        };
+
+        AssetLoader() = default;
+        static AssetLoader* instance();
+        void enqueue(std::shared_ptr<Job> job);
+        void workerLoop();
+        bool processUpload();                               // returns false if no upload is ready
+        static bool isDecoded(Texture::TextureBuilder& builder);
+        template<typename T>
+        static AssetHandle<T> createHandle();
+        template<typename T>
+        static void complete(AssetHandle<T>& handle, std::shared_ptr<T> asset, const std::function<void(std::shared_ptr<T>)>& onLoaded);
+
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Job>> loadQueue;
+        std::deque<std::shared_ptr<Job>> uploadQueue;
+        std::atomic<int> pending{0};
+        float uploadBudget = 4;
+#ifndef EMSCRIPTEN
+        std::condition_variable loadCondition;
+        std::condition_variable uploadCondition;            // used by finish()
+        std::vector<std::thread> workers;
+        bool stopWorkers = false;
+#endif
+        friend class Renderer;
+    };
+}
@@ -0,0 +1,84 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include "sre/Sprite.hpp"
+#include "sre/impl/Export.hpp"
+
+//
+// Dynamic atlases pack images added at runtime into shared atlas pages (textures), using the skyline packer from
+// stb_rect_pack.h. Each image is copied into a page using Texture::updateRegion() (or copied from the texture of a sprite on
+// the GPU) and is returned as a Sprite referencing the page. Since SpriteBatch starts a new draw call when the texture
+// changes, sprites from the same page (e.g. UI icons, avatars or decals loaded one by one) are rendered in a single
+// draw call.
+//
+// A new page is created when an image does not fit in the existing pages. Images are never removed from a page.
+// When the sprite is rendered its dynamic atlas must still exist.
+//
+// Example:
+// auto atlas = DynamicAtlas::create().withPageSize(1024).build();
+// Sprite icon = atlas->addFile("icon", "test_data/icon.png");
+//
+namespace sre{
+class Texture;
+
+class DllExport DynamicAtlas {
+public:
+    class DllExport DynamicAtlasBuilder {
+    public:
+        DynamicAtlasBuilder& withPageSize(int size);                            // Width and height of the atlas pages (default 1024)
+        DynamicAtlasBuilder& withPadding(int padding);                          // Pixels around each image filled with its edge pixels (default 1).
+                                                                                // Prevents neighbour images from bleeding when filter sampling
+        DynamicAtlasBuilder& withFilterSampling(bool enable);                   // Filter sampling of the atlas pages (default true)
+        DynamicAtlasBuilder& withName(const std::string& name);
+        std::shared_ptr<DynamicAtlas> build();
+    private:
+        DynamicAtlasBuilder() = default;
+        int pageSize = 1024;
+        int padding = 1;
+        bool filterSampling = true;
+        std::string name = "Dynamic atlas";
+        friend class DynamicAtlas;
+    };
+
+    ~DynamicAtlas();
+    static DynamicAtlasBuilder create();
+
+    Sprite add(const std::string& name, const char* rgbaData, int width, int height, // Add an RGBA image (first row is the bottom row, like
+               glm::vec2 pivot = {0.5f,0.5f});                                  // Texture::TextureBuilder::withRGBAData()). Returns the sprite
+    Sprite addFile(const std::string& name, const std::string& filename,         // Add a PNG or JPEG file
+                   glm::vec2 pivot = {0.5f,0.5f});
+    Sprite add(const std::string& name, const Sprite& sprite);                  // Copy the pixels of a sprite from another texture on the GPU (must
+                                                                                // be an uncompressed RGBA texture). Keeps the pivot and trim of the sprite
+    bool contains(const std::string& name);
+    Sprite get(const std::string& name);                                        // Return a copy of a Sprite object
+
+    std::vector<std::string> getNames();                                        // Returns a list of sprite names in the atlas
+    const std::string& getName();
+
+    int getPageCount();
+    std::shared_ptr<Texture> getTexture(int page);                              // Return the texture of an atlas page
+    float getPageUsage(int page);                                               // Fraction of the page area used by images (including padding)
+private:
+    struct Page;
+    DynamicAtlas(DynamicAtlasBuilder& builder);
+    Page* allocate(int width, int height, glm::ivec2& pos);                     // Find space for width x height pixels (including padding)
+    Sprite insert(const std::string& name, Sprite sprite);
+
+    int pageSize;
+    int padding;
+    bool filterSampling;
+    std::string name;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::map<std::string, Sprite> sprites;
+};
+}
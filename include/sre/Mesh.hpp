@@ -18,11 +18,14 @@
 #include "sre/impl/Export.hpp"
 #include "Shader.hpp"
 #include "RenderStats.hpp"
+#include "MeshOptimizer.hpp"
 
 namespace sre {
     // forward declaration
     class Shader;
     class Inspector;
+    class GeometryArena;
+    struct VertexAttributePointer;
 
     /**
      * Represents a Mesh object.
@@ -69,11 +72,29 @@ namespace sre {
 
             // other
             MeshBuilder& withName(const std::string& name);                                       // Defines the name of the mesh
+            MeshBuilder& withKeepCPUData(bool enable);                                            // If false the vertex attributes and indices are released from
+                                                                                                  // memory after the upload to the GPU (default true)
+            MeshBuilder& withOptimize(bool enable = true);                                        // Reorder triangles and vertices for vertex cache, overdraw and vertex fetch
+                                                                                                  // efficiency on build (see MeshOptimizer). Non-indexed triangle meshes are indexed.
+            MeshBuilder& withLODs(const std::vector<float>& ratios = {0.5f, 0.25f, 0.125f});      // Generate level of details for triangle index sets using mesh simplification.
+                                                                                                  // Each ratio defines the triangle count relative to the full mesh.
+                                                                                                  // RenderPass selects the LOD based on the projected size of the mesh bounds.
+            MeshBuilder& withMeshlets(int maxVertices = 64, int maxTriangles = 124);              // Split triangle index sets into meshlets with bounds. RenderPass culls back-facing
+                                                                                                  // and off-frustum meshlets. Imported meshes can use mesh->update().withMeshlets().build()
+            MeshBuilder& withWeld(float epsilon = 0);                                             // Merge duplicate vertices on build. Vertex attributes are compared exactly, except positions
+                                                                                                  // which are quantized to a grid of size epsilon (if > 0). Non-indexed triangle meshes are indexed.
+            MeshBuilder& withGeometryArena(bool enable = true);                                   // Store the mesh in a vertex/index buffer shared by meshes with the same vertex layout.
+                                                                                                  // Reduces buffer binds when drawing many small static meshes. Requires OpenGL 3.2
+                                                                                                  // (ignored if not supported)
 
             std::shared_ptr<Mesh> build();
         private:
             MeshBuilder() = default;
             MeshBuilder(const MeshBuilder&) = default;
+            int getVertexCount();
+            void remapVertices(const std::vector<uint16_t>& remap, int newVertexCount);
+            void weldVertices(float epsilon);
+            void applyOptimization();
             std::map<std::string,std::vector<float>> attributesFloat;
             std::map<std::string,std::vector<glm::vec2>> attributesVec2;
             std::map<std::string,std::vector<glm::vec3>> attributesVec3;
@@ -83,12 +104,26 @@ namespace sre {
             std::vector<std::vector<uint16_t>> indices;
             Mesh *updateMesh = nullptr;
             std::string name;
+            bool keepCPUData = true;
+            bool optimizeMesh = false;
+            std::vector<float> lodRatios;
+            int meshletMaxVertices = 0;
+            int meshletMaxTriangles = 0;
+            bool useGeometryArena = false;
+            float weldEpsilon = -1;                                 // negative: no welding
             friend class Mesh;
         };
         ~Mesh();
 
         static MeshBuilder create();                                // Create Mesh using the builder pattern. (Must end with build()).
         MeshBuilder update();                                       // Update the mesh using the builder pattern. (Must end with build()).
+        void weld(float epsilon = 0);                               // Merge duplicate vertices (see MeshBuilder::withWeld())
+
+        static std::shared_ptr<Mesh> loadBinary(const std::string& filename); // Load a mesh saved with saveBinary(). The file is memory mapped and uploaded
+                                                                    // without parsing. The CPU data is not kept. Returns nullptr if the file cannot be loaded.
+        bool saveBinary(const std::string& filename,                // Save the mesh as a binary .sremesh file (interleaved vertex data, index sets, level of details,
+                        bool compress = false);                     // topology, attribute layout and bounds). Returns false if the file cannot be written.
+                                                                    // If compress is true the vertex and index data is encoded using MeshCodec (lossless).
 
         int getVertexCount();                                       // Number of vertices in mesh
 
@@ -98,14 +133,23 @@ namespace sre {
         std::vector<glm::vec4> getColors();                         // Get color vertex attribute
         std::vector<glm::vec4> getTangents();                       // Get tangent vertex attribute (the w component contains the orientation of bitangent: -1 or 1)
         std::vector<float> getParticleSizes();                      // Get particle size vertex attribute
+                                                                    // Note: if the CPU data has been released, the attribute getters read back the data from the GPU
 
         int getIndexSets();                                         // Return the number of index sets
         MeshTopology getMeshTopology(int indexSet=0);               // Mesh topology used
-        const std::vector<uint16_t>& getIndices(int indexSet=0);    // Indices used in the mesh
+        const std::vector<uint16_t>& getIndices(int indexSet=0);    // Indices used in the mesh (empty if the CPU data has been released)
         int getIndicesSize(int indexSet=0);                         // Return the size of the index set
 
+        int getLODCount();                                          // Number of level of details (excluding the full mesh)
+        int getLODIndicesSize(int lod, int indexSet=0);             // Return the size of the index set of a level of detail
+        float getLODScreenSize(int lod);                            // LOD is used when the projected bounds are smaller than the screen size (relative to the viewport height)
+        int getMeshletCount(int indexSet=0);                        // Number of meshlets in index set (0 if meshlets are not used)
+
         template<typename T>
         inline T get(std::string attributeName);                    // Get the vertex attribute of a given type. Type must be float,glm::vec2,glm::vec3,glm::vec4,glm::i32vec4
+                                                                    // (empty if the CPU data has been released)
+
+        bool isKeepCPUData();                                       // Return false if vertex attributes and indices has been released after upload to the GPU
 
         std::pair<int,int> getType(const std::string& name);        // return element type, element count
 
@@ -117,6 +161,7 @@ namespace sre {
         const std::string& getName();                               // Return the mesh name
 
         int getDataSize();                                          // get size of the mesh in bytes on GPU
+        bool isInGeometryArena();                                   // Return true if the mesh is stored in a shared geometry arena
     private:
         struct Attribute {
             int offset;
@@ -127,25 +172,45 @@ namespace sre {
             int disabledAttributes[10];
         };
 
-        Mesh       (std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
-        void update(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
+        Mesh       (std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats, bool keepCPUData, std::vector<float> lodRatios, bool useGeometryArena);
+        Mesh();                                                     // used by createFromInterleavedData()
+        void update(std::map<std::string,std::vector<float>>&& attributesFloat, std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string, std::vector<glm::vec3>>&& attributesVec3, std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats, bool keepCPUData, std::vector<float> lodRatios, bool useGeometryArena);
 
-        std::vector<float> getInterleavedData();
+        std::vector<float> getInterleavedData();                    // Interleaved vertex data (read back from the GPU if the CPU data has been released)
+        std::vector<float> readInterleavedData();                   // Read back the interleaved vertex data from the GPU
+        std::vector<uint16_t> readIndices(int indexSet);            // Read back an index set from the GPU
+        std::vector<uint16_t> getElementBufferData();               // Index sets and level of details as stored in the element buffer
+        void upload(const void* vertexData, const uint16_t* indexData, int indexCount, bool useGeometryArena);
+        template<typename T>
+        std::vector<T> readAttribute(const std::string& name, std::map<std::string,std::vector<T>>& attributes);
+        bool checkCPUData(const std::string& name);                 // Log an error and return false if the CPU data has been released
 
         int totalBytesPerVertex = 0;
         static uint16_t meshIdCount;
         uint16_t meshId;
 
-        void setVertexAttributePointers(Shader* shader);
+        void setVertexAttributePointers(Shader* shader, std::vector<VertexAttributePointer>* pointers = nullptr); // pointers returns the enabled attributes
         std::vector<MeshTopology> meshTopology;
         unsigned int vertexBufferId;
-        struct VAOBinding {
-            long shaderId;
-            unsigned int vaoID;
-        };
-        std::map<unsigned int, VAOBinding> shaderToVertexArrayObject;
+        int layoutId = -1;                                          // vertex array objects are shared between meshes with the same layout
         unsigned int elementBufferId = 0;
         std::vector<std::pair<int,int>> elementBufferOffsetCount;
+        struct LOD {
+            float ratio;
+            float screenSize;
+            std::vector<std::pair<int,int>> elementBufferOffsetCount; // offset and count for each index set
+        };
+        std::vector<LOD> lods;
+        static std::shared_ptr<Mesh> createFromInterleavedData(const std::string& name, const void* vertexData, int vertexCount, int bytesPerVertex,
+                                                               std::map<std::string,Attribute>&& attributes, std::vector<MeshTopology>&& meshTopology,
+                                                               const uint16_t* elementData, int elementCount, std::vector<std::pair<int,int>>&& elementBufferOffsetCount,
+                                                               std::vector<LOD>&& lods, const std::array<glm::vec3,2>& bounds);
+                                                                    // Upload vertex data in the given layout without conversion (CPU data is not kept)
+        std::vector<std::vector<MeshOptimizer::Meshlet>> meshlets;  // meshlets for each index set
+        int meshletMaxVertices = 0;
+        int meshletMaxTriangles = 0;
+        int selectLOD(float projectedSize);                         // returns -1 for the full mesh
+        std::vector<std::vector<std::vector<uint16_t>>> generateLODs(const std::vector<float>& lodRatios); // LOD index sets (empty if an index set is not simplified)
         int vertexCount;
         int dataSize;
         std::string name;
@@ -157,40 +222,57 @@ namespace sre {
         std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
 
         std::vector<std::vector<uint16_t>> indices;
+        bool keepCPUData = true;
 
         std::array<glm::vec3,2> boundsMinMax;
 
+        std::shared_ptr<GeometryArena> geometryArena;
+        int arenaVertexOffset = 0;                                  // first vertex in the arena vertex buffer (base vertex)
+        int arenaIndexOffset = 0;                                   // first index in the arena element buffer
+        int arenaIndexCount = 0;
+        std::string getLayoutKey();
+        int64_t getBindKey();                                       // meshes with the same bind key share vertex array object
+        int getIndexByteOffset();                                   // offset of the mesh indices in the bound element buffer
+
         void bind(Shader* shader);
         void bindIndexSet();
 
         friend class RenderPass;
         friend class Inspector;
+        friend class GeometryArena;
+        friend class VertexArrayCache;
+        friend class ModelImporter;
 
         bool hasAttribute(std::string name);
     };
 
     template<>
     inline const std::vector<float>& Mesh::get(std::string uniformName) {
+        checkCPUData(uniformName);
         return attributesFloat[uniformName];
     }
 
     template<>
     inline const std::vector<glm::vec2>& Mesh::get(std::string uniformName) {
+        checkCPUData(uniformName);
         return attributesVec2[uniformName];
     }
 
     template<>
     inline const std::vector<glm::vec3>& Mesh::get(std::string uniformName) {
+        checkCPUData(uniformName);
         return attributesVec3[uniformName];
     }
 
     template<>
     inline const std::vector<glm::vec4>& Mesh::get(std::string uniformName) {
+        checkCPUData(uniformName);
         return attributesVec4[uniformName];
     }
 
     template<>
     inline const std::vector<glm::i32vec4>& Mesh::get(std::string uniformName) {
+        checkCPUData(uniformName);
         return attributesIVec4[uniformName];
     }
 }
\ No newline at end of file
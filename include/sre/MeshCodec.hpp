@@ -0,0 +1,39 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Lossless compression of vertex and index buffers. Used by Mesh::saveBinary() when compression is enabled.
+     *
+     * Vertex buffers are encoded in independent blocks of up to 256 vertices. Each byte of the vertex is delta
+     * encoded against the same byte of the previous vertex, and the deltas are stored transposed (one byte plane per
+     * vertex byte) in groups of 16 bytes using 0, 2, 4 or 8 bits per byte. Works best on vertex fetch optimized
+     * meshes (see MeshOptimizer), where neighbour vertices are similar. Blocks are decoded in parallel, using SSE2
+     * when the vertex size is a multiple of 16 bytes (which is the case for the interleaved layout of Mesh).
+     *
+     * Index buffers are encoded as the difference to the previous index (zigzag encoded variable length integers).
+     * The index order is preserved.
+     */
+    class DllExport MeshCodec {
+    public:
+        static std::vector<uint8_t> encodeVertexBuffer(const void* vertices, int vertexCount, int vertexSize);
+        static bool decodeVertexBuffer(void* destination, int vertexCount, int vertexSize,                  // Returns false if the data is invalid
+                                       const uint8_t* data, size_t size);
+
+        static std::vector<uint8_t> encodeIndexBuffer(const uint16_t* indices, int indexCount);
+        static bool decodeIndexBuffer(uint16_t* destination, int indexCount,                                // Returns false if the data is invalid
+                                      const uint8_t* data, size_t size);
+    };
+}
@@ -0,0 +1,81 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include "glm/glm.hpp"
+#include <vector>
+#include <cstdint>
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    /**
+     * Reorders triangle lists for better GPU performance. Used by Mesh::MeshBuilder::withOptimize(), but the
+     * functions can also be used directly on index data.
+     *
+     * The optimization is done in three steps:
+     * - optimizeVertexCache() reorders triangles for post-transform vertex cache reuse (Forsyth's algorithm)
+     * - optimizeOverdraw() reorders clusters of triangles to reduce overdraw (without significantly reducing the
+     *   vertex cache efficiency)
+     * - optimizeVertexFetch() computes a vertex remap, which stores vertices in the order they are first used
+     *
+     * analyzeVertexCache() can be used to measure the result of the optimization.
+     *
+     * buildMeshlets() splits an index set into small clusters (meshlets) with bounds used for culling. Used by
+     * Mesh::MeshBuilder::withMeshlets().
+     *
+     * simplify() reduces the triangle count using quadric error edge collapse. Used by
+     * Mesh::MeshBuilder::withLODs() to generate level of details.
+     */
+    class DllExport MeshOptimizer {
+    public:
+        struct Meshlet {
+            int indexOffset;    // first index of the meshlet (relative to the index set)
+            int indexCount;     // number of indices in the meshlet
+            glm::vec3 center;   // bounding sphere center
+            float radius;       // bounding sphere radius
+            glm::vec3 coneAxis; // average triangle normal
+            float coneCutoff;   // sine of the normal cone angle. 1 if the cone is too wide to be used for back-face culling
+        };
+
+        struct VertexCacheStats {
+            float acmr = 0;     // average cache miss ratio (transformed vertices per triangle). Between 0.5 (best) and 3.0 (worst)
+            float atvr = 0;     // average transformed vertex ratio (transformed vertices per vertex). 1.0 is optimal
+        };
+
+        static VertexCacheStats analyzeVertexCache(const std::vector<uint16_t>& indices,    // Simulates a FIFO post-transform cache
+                                                   int vertexCount,
+                                                   int cacheSize = 16);
+
+        static std::vector<uint16_t> optimizeVertexCache(const std::vector<uint16_t>& indices, // Reorder triangles for vertex cache reuse
+                                                         int vertexCount);
+
+        static std::vector<uint16_t> optimizeOverdraw(const std::vector<uint16_t>& indices,   // Reorder triangle clusters to reduce overdraw.
+                                                      const std::vector<glm::vec3>& positions,// Indices should be vertex cache optimized.
+                                                      float threshold = 1.05f);             // threshold is the allowed ACMR degradation.
+
+        static std::vector<uint16_t> optimizeVertexFetch(const std::vector<std::vector<uint16_t>>& indexSets,
+                                                         int vertexCount);                  // Returns vertex remap (old index to new index).
+                                                                                            // Vertices are ordered by first use. Unused vertices are placed last.
+
+        static std::vector<Meshlet> buildMeshlets(const std::vector<uint16_t>& indices,       // Split indices into meshlets (contiguous index ranges in the existing
+                                                  const std::vector<glm::vec3>& positions,  // triangle order) and return the meshlet bounds. Indices are not changed
+                                                                                            // and should be vertex cache optimized.
+                                                  int maxVertices = 64,
+                                                  int maxTriangles = 124);
+
+        static bool isMeshletCulled(const Meshlet& meshlet,                                 // Returns true if the meshlet is back-facing (seen from cameraPosition)
+                                    glm::vec3 cameraPosition,                               // or outside the six frustum planes (xyz is the normal pointing inwards).
+                                    const glm::vec4* frustumPlanes,                         // Positions and planes must be in the mesh coordinate space.
+                                    bool backFaceCulling = true);
+
+        static std::vector<uint16_t> simplify(const std::vector<uint16_t>& indices,           // Collapse edges (using quadric error metric) until the index
+                                              const std::vector<glm::vec3>& positions,      // count is below targetIndexCount or no more edges can be collapsed.
+                                              int targetIndexCount);                        // Vertices on borders and attribute seams are not moved.
+    };
+}
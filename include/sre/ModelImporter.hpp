@@ -8,6 +8,7 @@
 #pragma once
 
 #include <vector>
+#include <functional>
 #include "sre/Material.hpp"
 
 namespace sre{
@@ -16,15 +17,57 @@ namespace sre{
 class Mesh;
 
 /**
- * Wavefront OBJ file importer.
+ * Wavefront OBJ and glTF 2.0 file importer.
  * Both the geometry and materials are loaded (including textures).
  * Only triangular meshes with a vertex count under 65.536 vertices are supported. 
+ * Larger files can be imported using importObjStreaming, which emits the model as multiple meshes.
  */
 class ModelImporter {
 public:
+    struct ObjPart {
+        std::string name;                               // name of the object (o) or group (g)
+        std::shared_ptr<Mesh> mesh;                     // mesh->getBoundsMinMax() returns the bounds of the part
+        std::vector<std::shared_ptr<Material>> materials; // material of each index set (shared between the parts)
+    };
+
     static std::shared_ptr<Mesh> importObj(std::string path, std::string filename);
     static std::shared_ptr<Mesh> importObj(std::string path, std::string filename, std::vector<std::shared_ptr<Material>>& outModelMaterials);
                                                         // Load an Obj mesh, materials will be defined in the last parameter.
                                                         // Note that only diffuse color and texture and specular exponent are read from the file
+    static bool importObjStreaming(std::string path, std::string filename,
+                                   std::function<void(std::shared_ptr<Mesh> mesh, std::vector<std::shared_ptr<Material>>& materials)> onMesh,
+                                   int vertexBudget = 65536, bool splitAtGroups = false);
+                                                        // Load an Obj file as a sequence of meshes. Each mesh is passed to
+                                                        // onMesh as soon as it is complete. A new mesh is started when the
+                                                        // vertex budget is reached (max 65536) or at each object/group (if
+                                                        // splitAtGroups). The vertexBudget only bounds the size of each mesh:
+                                                        // all parsed v/vt/vn attributes of the file are kept until the end
+                                                        // (faces may reference any earlier vertex), so memory still grows with
+                                                        // the attribute count of the file. Returns false if the file cannot be read
+    static std::shared_ptr<Mesh> importGltf(std::string path, std::string filename);
+    static std::shared_ptr<Mesh> importGltf(std::string path, std::string filename, std::vector<std::shared_ptr<Material>>& outModelMaterials);
+                                                        // Load a glTF 2.0 file (.gltf or .glb). The meshes of the default scene are merged into
+                                                        // a single mesh (node transforms applied) with an index set and a material per primitive.
+                                                        // Materials use Shader::getStandardPBR() (metallic-roughness, normal, occlusion and
+                                                        // emissive maps). If the scene is a single untransformed mesh with float vertex attributes
+                                                        // interleaved in one buffer view, the vertex data is uploaded directly from the (memory
+                                                        // mapped) file and the CPU data is not kept. Skinning, morph targets and sparse
+                                                        // accessors are not supported
+    static std::vector<ObjPart> importObjParts(std::string path, std::string filename, int vertexBudget = 65536);
+                                                        // Load an Obj file as a mesh per object/group (parts larger than the vertex
+                                                        // budget are split). The meshes are stored in a geometry arena (shared
+                                                        // buffers). Draw using a RenderPass with frustum culling enabled to skip the
+                                                        // parts outside the view (see RenderPassBuilder::withFrustumCulling())
+private:
+    static bool streamObj(std::string path, std::string filename,
+                          std::function<void(const std::string& name, std::shared_ptr<Mesh> mesh, std::vector<std::shared_ptr<Material>>& materials)> onMesh,
+                          int vertexBudget, bool splitAtGroups, bool useGeometryArena);
+    struct ObjModel;
+    static std::shared_ptr<ObjModel> parseObj(std::string path, std::string filename); // parse and index the file (no OpenGL calls)
+    static std::vector<std::string> getTextureFiles(ObjModel& model);                  // diffuse textures used by the model
+    static std::shared_ptr<Mesh> buildObj(ObjModel& model, std::vector<std::shared_ptr<Material>>& outModelMaterials);
+    struct GltfModel;
+    static std::shared_ptr<Mesh> uploadGltfInterleaved(GltfModel& model, int mesh); // nullptr if the vertex layout cannot be used directly
+    friend class AssetLoader;
 };
 }
\ No newline at end of file
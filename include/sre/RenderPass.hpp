@@ -53,6 +53,11 @@ namespace sre {
                                                                                                    // calls ImGui::Render() in the end of the renderpass
 
             RenderPassBuilder& withFramebuffer(std::shared_ptr<Framebuffer> framebuffer);
+
+            RenderPassBuilder& withLODBias(float bias = 1);                                         // Scales the projected size used for selecting mesh level of details.
+                                                                                                   // Values larger than 1 keeps more details. Default 1
+            RenderPassBuilder& withFrustumCulling(bool enabled = true);                            // Skip draws where the mesh bounds are outside the camera frustum
+                                                                                                   // (counted in RenderStats::meshesCulled). Default disabled
             RenderPass build();
         private:
             RenderPassBuilder() = default;
@@ -74,6 +79,8 @@ namespace sre {
             std::shared_ptr<Skybox> skybox;
 
             bool gui = true;
+            float lodBias = 1;
+            bool frustumCulling = false;
 
             explicit RenderPassBuilder(RenderStats* renderStats);
             friend class RenderPass;
@@ -159,6 +166,12 @@ namespace sre {
         void setupShaderRenderPass(const GlobalUniforms& globalUniforms);
         void setupGlobalShaderUniforms();
         void setupShader(const glm::mat4 &modelTransform, Shader *shader);
+        float projectedSize(Mesh* mesh, const glm::mat4 &modelTransform);   // projected size of the mesh bounds relative to the viewport height
+        void drawMeshlets(Mesh* mesh, const glm::mat4 &modelTransform, int subMesh); // draw the visible meshlets as compacted index ranges
+        void getFrustumPlanes(const glm::mat4 &modelTransform, glm::vec4* planes);   // normalized frustum planes in mesh space (normals pointing inwards)
+        bool isCulled(Mesh* mesh, const glm::mat4 &modelTransform);         // true if frustum culling is enabled and the mesh bounds are outside the frustum
+        void requestTextureMips(Mesh* mesh, const glm::mat4 &modelTransform, Material* material); // request mip levels of streamed textures from the screen size
+        void drawElements(Mesh* mesh, unsigned int topology, int indexCount, int byteOffset); // byteOffset is relative to the mesh indices
 
         Shader* lastBoundShader = nullptr;
         Material* lastBoundMaterial = nullptr;
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include "sre/impl/Export.hpp"
 
 namespace sre {
@@ -14,17 +15,30 @@ namespace sre {
     struct DllExport RenderStats {
         int frame=0;                                          // The frameid the render stat is captured
         int meshCount=0;                                      // Number of allocated meshes
-        int meshBytes=0;                                      // Size of allocated meshes in bytes
-        int meshBytesAllocated=0;                             // Size of allocated meshes in bytes this frame
-        int meshBytesDeallocated=0;                           // Size of deallocated meshes in bytes this frame
+        int64_t meshBytes=0;                                  // Size of allocated meshes in bytes
+        int64_t meshBytesAllocated=0;                         // Size of allocated meshes in bytes this frame
+        int64_t meshBytesDeallocated=0;                       // Size of deallocated meshes in bytes this frame
         int textureCount=0;                                   // Number of allocated textures
-        int textureBytes=0;                                   // Size of allocated textures in bytes
-        int textureBytesAllocated=0;                          // Size of allocated textures in bytes this frame
-        int textureBytesDeallocated=0;                        // Size of deallocated textures in bytes this frame
+        int64_t textureBytes=0;                               // Size of allocated textures in bytes
+        int64_t textureBytesAllocated=0;                      // Size of allocated textures in bytes this frame
+        int64_t textureBytesDeallocated=0;                    // Size of deallocated textures in bytes this frame
+        int64_t textureBytesUpdated=0;                        // Size of texture data uploaded by Texture::updateRegion() this frame
+        int64_t textureBudget=0;                              // Texture memory budget in bytes (0 = no budget). Budget pressure is textureBytes/textureBudget
+        int textureStreamingCount=0;                          // Number of streamed textures (see TextureStreamer)
+        int textureStreamingPending=0;                        // Number of streamed textures used this frame with fewer resident mip levels than requested
+        int textureStreamingMissingMips=0;                    // Sum of requested mip levels not resident (for streamed textures used this frame)
+        int textureStreamingUploads=0;                        // Number of mip levels uploaded this frame by the streamer
+        int textureStreamingEvictions=0;                      // Number of mip levels evicted this frame by the streamer
+        int textureUnloadedCount=0;                           // Number of textures unloaded by the streamer (reloaded from file when used)
+        int textureUnloads=0;                                 // Number of textures unloaded this frame by the streamer
+        int textureReloads=0;                                 // Number of unloaded textures reloaded this frame
         int shaderCount=0;                                    // Number of allocated shaders
         int drawCalls=0;                                      // Number of drawCalls per frame
         int stateChangesShader=0;                             // Number of state changes for shaders
         int stateChangesMaterial=0;                           // Number of state changes for materials
         int stateChangesMesh=0;                               // Number of state changes for meshes
+        int triangles=0;                                      // Number of triangles submitted per frame
+        int meshletsCulled=0;                                 // Number of meshlets culled per frame
+        int meshesCulled=0;                                   // Number of mesh draws culled per frame (see RenderPassBuilder::withFrustumCulling())
     };
 }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <list>
 #include <SDL_video.h>
 #include "glm/glm.hpp"
 #include "sre/Light.hpp"
@@ -28,10 +29,19 @@ namespace sre {
     class Shader;
     class Shader;
 	class VR;
+    class GeometryArena;
+    class VertexArrayCache;
+    class ResourceCache;
+    class AssetLoader;
+    class TextureStreamer;
 
     struct RenderInfo{
         bool useFramebufferSRGB = false;
         bool supportTextureSamplerSRGB = false;
+        bool supportTextureCompressionS3TC = false;   // BC1 and BC3
+        bool supportTextureCompressionRGTC = false;   // BC5
+        bool supportTextureCompressionBPTC = false;   // BC7
+        bool supportTextureCompressionETC2 = false;
         int graphicsAPIVersionMajor;            // For WebGL uses OpenGL ES api version (WebGL 1.0 = OpenGL ES 2.0)
         int graphicsAPIVersionMinor;
         bool graphicsAPIVersionES;
@@ -104,10 +114,16 @@ namespace sre {
         std::vector<Framebuffer*> framebufferObjects;
         std::vector<Mesh*> meshes;
         std::vector<Shader*> shaders;
-        std::vector<Texture*> textures;
+        std::list<Texture*> textures;                                          // least recently used first (see Texture::markUsed())
         std::vector<SpriteAtlas*> spriteAtlases;
+        std::map<std::string, std::shared_ptr<GeometryArena>> geometryArenas; // geometry arena per vertex layout
+        std::unique_ptr<VertexArrayCache> vertexArrayCache;                   // vertex array objects shared per vertex layout
+        std::unique_ptr<ResourceCache> resourceCache;
+        std::unique_ptr<AssetLoader> assetLoader;
+        std::unique_ptr<TextureStreamer> textureStreamer;
 
         void initGlobalUniformBuffer();
+        void initTextureCompressionSupport();
         GLuint globalUniformBuffer = 0;
         GLuint globalUniformBufferSize = 0;
 
@@ -124,6 +140,11 @@ namespace sre {
         friend class Inspector;
         friend class SpriteAtlas;
 		friend class VR;
+        friend class GeometryArena;
+        friend class VertexArrayCache;
+        friend class ResourceCache;
+        friend class AssetLoader;
+        friend class TextureStreamer;
         friend class RenderPass::RenderPassBuilder;
     };
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <map>
+#include <list>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Texture;
+    class Mesh;
+
+    /**
+     * Shares textures and meshes loaded from the same file or generated with the same parameters.
+     *
+     * Resources are held weakly: a resource is released when it is no longer used outside the cache. A budget can be
+     * set to retain the most recently used resources (up to the given number of bytes on GPU), which avoids reloading
+     * resources that are used again shortly after being released. purge() releases all retained resources.
+     *
+     * Example:
+     * auto texture = ResourceCache::getTexture("test_data/gamma-test.png", true);
+     * auto sphere = ResourceCache::getSphere();
+     *
+     * Resources returned by the cache are shared and should not be updated.
+     */
+    class DllExport ResourceCache {
+    public:
+        static std::shared_ptr<Texture> getTexture(const std::string& filename, bool generateMipmaps = false); // Load texture from file (or return the cached texture)
+        static std::vector<std::shared_ptr<Texture>> getTextures(const std::vector<std::string>& filenames, // Load textures from files (or return the cached textures).
+                                                                 bool generateMipmaps = false);         // Files not in the cache are decoded in parallel
+
+        static std::shared_ptr<Mesh> getSphere(int stacks = 16, int slices = 32, float radius = 1); // Shared primitives. See Mesh::MeshBuilder
+        static std::shared_ptr<Mesh> getCube(float length = 1);
+        static std::shared_ptr<Mesh> getQuad(float size = 1);
+        static std::shared_ptr<Mesh> getTorus(int segmentsC = 24, int segmentsA = 24, float radiusC = 1, float radiusA = .25);
+
+        static std::shared_ptr<Texture> getTexture(const std::string& key, std::function<std::shared_ptr<Texture>()> create); // Cache textures using a custom key
+        static std::shared_ptr<Mesh> getMesh(const std::string& key, std::function<std::shared_ptr<Mesh>()> create);          // Cache meshes using a custom key
+
+        static void setBudget(int64_t bytes);               // Size of recently used resources retained by the cache (default 0 - only hold resources weakly)
+        static int64_t getBudget();
+        static int64_t getRetainedBytes();                  // Size of resources retained by the cache
+        static void purge();                                // Release all retained resources (resources still in use are kept in the cache)
+        static void clear();                                // Purge, forget all resources and reset the statistics
+
+        static int getHits();
+        static int getMisses();
+        static int getEntryCount();                         // Resources in the cache that are still alive
+    private:
+        struct Entry {
+            std::weak_ptr<void> resource;
+            std::shared_ptr<void> retained;                 // strong reference while within the budget
+            std::list<std::string>::iterator lru;           // position in the retained list
+            int64_t size = 0;
+        };
+
+        ResourceCache() = default;
+        static ResourceCache* instance();
+
+        static std::shared_ptr<Texture> getTextureFile(const std::string& filename, bool generateMipmaps, std::function<std::shared_ptr<Texture>()> create);
+        std::shared_ptr<void> get(const std::string& key, const std::function<std::shared_ptr<void>(int64_t& size)>& create);
+        void retain(const std::string& key, Entry& entry, const std::shared_ptr<void>& resource);
+        void release(Entry& entry);
+        void removeExpired();
+        void removeExpiredAmortized();                      // removeExpired() when the number of entries has doubled since the last prune
+
+        std::map<std::string, Entry> entries;
+        std::list<std::string> retainedList;                // most recently used first
+        int64_t budget = 0;
+        int64_t retainedBytes = 0;
+        size_t pruneThreshold = 64;                         // entry count triggering the next prune of expired entries
+        int hits = 0;
+        int misses = 0;
+
+        friend class Renderer;
+        friend class AssetLoader;
+    };
+}
@@ -295,6 +295,7 @@ namespace sre {
         friend class Material;
         friend class RenderPass;
         friend class Inspector;
+        friend class VertexArrayCache;
 
         int uniformLocationModel;
         int uniformLocationView;
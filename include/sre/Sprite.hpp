@@ -75,6 +75,7 @@ private:
     glm::vec2  spriteAnchor;
     Texture* texture;
     friend class SpriteAtlas;
+    friend class DynamicAtlas;
     friend class SpriteBatch;
     friend class Inspector;
 };
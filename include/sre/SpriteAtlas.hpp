@@ -72,6 +72,9 @@ public:
     std::shared_ptr<Texture> getTexture();                  // Return sprite texture
 private:
     SpriteAtlas(std::map<std::string, Sprite>&& sprites, std::shared_ptr<Texture> texture, std::string atlasName);
+    static bool readJSON(const std::string& jsonFile, std::string& json);
+    static std::shared_ptr<SpriteAtlas> createFromJSON(const std::string& json, std::string jsonFile, std::shared_ptr<Texture> texture, bool flipAnchorY);
+    friend class AssetLoader;
     std::string atlasName;
     std::map<std::string, Sprite> sprites;
     std::shared_ptr<Texture> texture;
@@ -9,8 +9,10 @@
 
 #include <cstdint>
 #include <vector>
+#include <list>
 #include <string>
 #include <map>
+#include <memory>
 
 #include "sre/impl/Export.hpp"
 #include "sre/Framebuffer.hpp"
@@ -32,6 +34,13 @@ namespace sre{
      *
      * Textures can be created from files (png or jpeg). Alternative textures can be created using memory representation
      * of the texture in RGBA (one byte per color channel).
+     * Block compressed textures (BC1, BC3, BC5, BC7 and ETC2) including pre-built mipmaps can be loaded from KTX, KTX2
+     * and DDS files. If the GPU does not support the format, the texture is decompressed on load (except BC7).
+     * Streamed textures (see TextureBuilder::withStreaming()) keep their mip levels in CPU memory and only the mip levels
+     * needed on screen are resident on the GPU (see TextureStreamer).
+     * Textures loaded from files may be unloaded from the GPU by the TextureStreamer when the texture memory exceeds the
+     * budget. Unloaded textures are reloaded from the file when used again.
+     * The pixels of uncompressed 2D textures can be replaced using updateRegion() (e.g. for video frames or canvases).
      * The Texture class also provides a white texture using the Texture::getWhiteTexture()
      *
      * A texture object has the following properties:
@@ -73,20 +82,45 @@ public:
         Mirror
     };
 
+    enum class MipmapFilter {
+        Box,                // Average of 2x2 pixels. Default behavior
+        Kaiser              // Kaiser windowed sinc. Sharper mipmaps (slower to generate)
+    };
+
+    enum class Compression {
+        None,
+        BC1,                // RGB (DXT1). 4 bits per pixel
+        BC3,                // RGBA (DXT5). 8 bits per pixel
+        BC5,                // RG (two channels, e.g. normal maps). 8 bits per pixel
+        BC7,                // RGBA (high quality). 8 bits per pixel
+        ETC2_RGB,           // RGB (OpenGL ES 3.0). 4 bits per pixel
+        ETC2_RGBA           // RGBA (OpenGL ES 3.0). 8 bits per pixel
+    };
+
     class DllExport TextureBuilder {
     public:
         ~TextureBuilder();
         TextureBuilder& withGenerateMipmaps(bool enable);
+        TextureBuilder& withMipmapFilter(MipmapFilter filter);                              // Filter used for mipmaps generated on the CPU (sRGB textures are filtered in linear space)
         TextureBuilder& withFilterSampling(bool enable);                                    // if true texture sampling is filtered (bi-linear or tri-linear sampling) otherwise use point sampling.
         DEPRECATED("Use with WrapUV")
         TextureBuilder& withWrappedTextureCoordinates(bool enable);
         TextureBuilder& withWrapUV(Wrap wrap);                                              // Define how texture coordinates are sampled outside the [0.0,1.0] range
-        TextureBuilder& withFileCubemap(std::string filename, CubemapSide side);            // Must define a cubemap for each side
-        TextureBuilder& withFile(std::string filename);                                     // Currently only PNG files supported
+        TextureBuilder& withFileCubemap(std::string filename, CubemapSide side);            // Must define a cubemap for each side. The sides are decoded in parallel when built
+        TextureBuilder& withFile(std::string filename);                                     // PNG or JPEG files. KTX, KTX2 and DDS files with block compressed data
+        TextureBuilder& withFileData(const char* data, int size, bool flipY = true);        // Decode an image file in memory (same formats as withFile). If flipY the first row
+                                                                                            // of the image is stored last (matching the texture coordinates of withFile).
+                                                                                            // Only BC1, BC3 and BC5 textures can be flipped
         TextureBuilder& withRGBData(const char* data, int width, int height);               // data may be null (for a uninitialized texture)
         TextureBuilder& withRGBAData(const char* data, int width, int height);              // data may be null (for a uninitialized texture)
         TextureBuilder& withWhiteData(int width=2, int height=2);
         TextureBuilder& withSamplerColorspace(SamplerColorspace samplerColorspace);
+        TextureBuilder& withCompression(Compression compression);                           // Compress RGB(A) data on the CPU when built (BC1, BC3, BC5, ETC2_RGB or ETC2_RGBA).
+                                                                                            // Ignored if the GPU does not support the format. See setCompressionCacheDirectory()
+        TextureBuilder& withStreaming(bool enable = true);                                   // Upload only the smallest mip levels when built. Larger mip levels are uploaded
+                                                                                            // when needed on screen (see TextureStreamer). Enables mipmaps (2D textures only)
+        TextureBuilder& withPixelBuffers(bool enable = true);                                // updateRegion() copies the data to one of two alternating pixel buffer objects,
+                                                                                            // which are uploaded to the texture asynchronously (OpenGL 3.x / OpenGL ES 3.x)
         TextureBuilder& withWhiteCubemapData(int width=2, int height=2);
         TextureBuilder& withDepth(int width, int height, DepthPrecision precision=DepthPrecision::I16); // Creates a depth texture.
         TextureBuilder& withName(const std::string& name);
@@ -95,6 +129,7 @@ public:
     private:
         TextureBuilder();
         TextureBuilder(const TextureBuilder&) = default;
+        TextureBuilder& withContainerData(const char* data, int size, bool flipY);           // KTX, KTX2 or DDS file
 
         struct TextureDefinition {
             int width = -1;
@@ -104,23 +139,40 @@ public:
             uint32_t format;
             std::string resourcename;
             std::vector<char> data;
+            Compression compression = Compression::None;                                    // format of data and mipLevels
+            std::vector<std::vector<char>> mipLevels;                                       // pre-built mip levels 1..n (optional)
             void dumpDebug();
         };
         DepthPrecision depthPrecision = DepthPrecision::None;
         std::string name;
 		bool transparent;
         bool generateMipmaps = false;
+        MipmapFilter mipmapFilter = MipmapFilter::Box;
         bool filterSampling = true;                                                         // true = linear/trilinear sampling, false = point sampling
         Wrap wrapUV = Wrap::Repeat;
         bool dumpDebug = false;
         SamplerColorspace samplerColorspace = SamplerColorspace::Linear;
+        Compression compression = Compression::None;
+        bool streaming = false;
+        bool pixelBuffers = false;
         uint32_t target = 0;
         unsigned int textureId = 0;
+        bool built = false;
+        std::string sourceFile;                                                             // file the texture can be reloaded from
 
         std::map<uint32_t, TextureDefinition> textureTypeData;
+        std::map<uint32_t, std::string> cubemapFiles;                                       // cubemap side files (decoded by build())
+
+        void decodeCubemapFiles();                                                          // decode the cubemap sides in parallel
+        void compress(TextureDefinition& textureDef);                                       // encode textureDef (including mipmaps) using compression
+        void generateMipLevels(TextureDefinition& textureDef);                              // generate mip levels 1..n of textureDef.data on the CPU
+        void prepareMipmaps();                                                              // generate the mip levels before build() (e.g. on a worker thread)
 
         friend class Texture;
         friend class RenderPass;
+        friend class AssetLoader;
+        friend class ModelImporter;
+        friend class ResourceCache;
     };
 
     virtual ~Texture();
@@ -128,6 +180,12 @@ public:
     // Create a new texture using the builder pattern
     static TextureBuilder create();
 
+    static bool isCompressionSupported(Compression compression);                           // returns true if the GPU supports the compression format
+    static void setCompressionCacheDirectory(const std::string& directory);                 // Store textures compressed by TextureBuilder::withCompression() as KTX files
+                                                                                            // in directory (keyed by a hash of the source data). Empty string disables
+                                                                                            // the cache (default)
+    static const std::string& getCompressionCacheDirectory();
+
     static std::shared_ptr<Texture> getWhiteTexture();
     static std::shared_ptr<Texture> getSphereTexture();
     static std::shared_ptr<Texture> getDefaultCubemapTexture();
@@ -143,28 +201,72 @@ public:
     bool isMipmapped();                                                                     // has texture mipmapped enabled
 	bool isTransparent();																	// Does texture has alpha channel
     SamplerColorspace getSamplerColorSpace();
+    Compression getCompression();                                                           // compression format on the GPU
     const std::string& getName();                                                           // name of the string
 
     int getDataSize();                                                                      // get size of the texture in bytes on GPU
+    bool isStreaming();                                                                     // texture residency is controlled by the TextureStreamer
+    int getResidentMipLevel();                                                              // largest mip level on the GPU (0 = full size). Always 0 if not streamed
+    int getRequestedMipLevel();                                                             // mip level last requested by a RenderPass. Always 0 if not streamed
+    bool isLoaded();                                                                        // false if unloaded by the TextureStreamer (reloaded from file when used)
+    int getLastUsedFrame();                                                                 // frame the texture was last bound for rendering (-1 if never used)
+    unsigned int getNativeTextureId();                                                      // OpenGL texture id for sampling outside sre (e.g. ImGui::Image()). Marks the
+                                                                                            // texture used this frame (reloads unloaded textures and updates mipmaps)
     bool isDepthTexture();
     DepthPrecision getDepthPrecision();
+
+    void updateRegion(int x, int y, int width, int height, const char* data, int mipLevel = 0); // Replace the pixels of a region using glTexSubImage2D. Data uses the format of
+                                                                                            // the texture (RGB or RGBA) and the first row is the bottom row (y=0). Only
+                                                                                            // uncompressed 2D textures (not streamed) can be updated. Mipmaps are regenerated
+                                                                                            // when bound, if mipLevel is 0
 private:
-    Texture(unsigned int textureId, int width, int height, uint32_t target, std::string string);
+    struct StreamingState {
+        std::vector<std::vector<char>> levels;                                              // all mip levels (level 0 is the full size image)
+        uint32_t internalFormat;                                                            // GL format of uncompressed levels
+        uint32_t format;
+        int tailMip;                                                                        // smallest resident mip level (uploaded when built)
+        int residentMip;                                                                    // levels residentMip..n are on the GPU
+        int requestedMip;
+        int lastRequestFrame = -1;
+    };
+    Texture(unsigned int textureId, int width, int height, uint32_t target, std::string string, int dataSize);
     void updateTextureSampler(bool filterSampling, Wrap wrapTextureCoordinates);
     void invokeGenerateMipmap();
+    void updateMipmaps();                                                                   // regenerate mipmaps of render targets (if changed since last update)
+    void setResidentMip(int mip);                                                           // upload mip levels mip..n of a streamed texture (as GL levels 0..n-mip)
+    void requestMip(float screenSize);                                                      // request the mip level for screenSize pixels this frame
+    int streamingDataSize(int mip);                                                         // size on GPU when mip is the resident mip level
+    void markUsed();                                                                        // called when bound. Reloads unloaded textures
+    bool isReloadable();                                                                    // can be unloaded and reloaded from file
+    void unload();
+    void reload();
+    void disableReload();                                                                   // keep the texture loaded (the content is changed on the GPU)
     static GLenum getFormat(SDL_Surface *image);
     static std::vector<char> loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY = true);
     int width;
     int height;
     uint32_t target;
     bool generateMipmap;
+    bool mipmapsDirty = false;                                                              // render target changed since mipmaps were generated
 	bool transparent;
     DepthPrecision depthPrecision = DepthPrecision::None;
+    Compression compression = Compression::None;
     std::string name;
     SamplerColorspace samplerColorspace;
     bool filterSampling = true; // true = linear/trilinear sampling, false = point sampling
     Wrap wrapUV;
     unsigned int textureId;
+    int dataSize;
+    std::unique_ptr<StreamingState> streaming;
+    MipmapFilter mipmapFilter = MipmapFilter::Box;
+    std::string sourceFile;                                                                 // file the texture is reloaded from (empty if not reloadable)
+    int lastUsedFrame = -1;
+    std::list<Texture*>::iterator lruEntry;                                                 // position in Renderer::textures (least recently used first)
+    uint32_t pixelFormat = 0;                                                               // GL_RGB or GL_RGBA (0 if the texture cannot be updated)
+    bool usePixelBuffers = false;
+    unsigned int pixelBuffers[2] = {0, 0};
+    int pixelBufferIndex = 0;                                                               // buffer used by the last update
+    int pixelBufferSize = 0;
     friend class Shader;
     friend class Material;
     friend class Framebuffer;
@@ -173,6 +275,8 @@ private:
     friend class VR;
     friend class Sprite;
     friend class UniformSet;
+    friend class TextureStreamer;
+    friend class DynamicAtlas;
 };
 
 
@@ -0,0 +1,56 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+    class Texture;
+
+    /**
+     * Controls the GPU residency of streamed textures (see TextureBuilder::withStreaming()) and textures loaded from files.
+     *
+     * A streamed texture keeps its mip levels in CPU memory and is built with only the smallest mip levels on the GPU.
+     * During rendering RenderPass requests the mip level matching the screen size of each mesh using the texture.
+     * Once per frame (in Renderer::swapWindow()) the streamer uploads one more mip level of the most recently used
+     * textures that need more detail (limited by the upload limit), and drops the largest mip level of the least
+     * recently used textures while the texture memory exceeds the budget.
+     *
+     * Textures are evicted in least recently used order (the last used frame is recorded when a texture is bound). Streamed
+     * textures drop their largest mip levels, while textures loaded from files (see TextureBuilder::withFile()) are
+     * unloaded and reloaded from the file when bound again. Other textures (e.g. render targets or textures created from
+     * memory) are never evicted, but count toward the budget (see RenderStats::textureBytes).
+     * Textures used in the current frame are never unloaded or evicted below their requested mip level.
+     */
+    class DllExport TextureStreamer {
+    public:
+        static void setBudget(int64_t bytes);               // Texture memory budget in bytes (default 0 - no budget)
+        static int64_t getBudget();
+        static void setUploadLimit(int64_t bytes);          // Max bytes uploaded per frame (default 16 MB). At least one mip level
+        static int64_t getUploadLimit();                    // is uploaded per frame
+        static void setMipBias(float bias);                 // Added to the requested mip levels (positive values reduce the texture memory)
+        static float getMipBias();
+        static void evictAll();                             // Drop all streamed textures to their smallest resident mip levels and
+                                                            // unload the textures loaded from files
+    private:
+        TextureStreamer() = default;
+        static TextureStreamer* instance();
+
+        void update();                                      // called once per frame by the Renderer
+        int64_t evict(const std::vector<Texture*>& leastRecentlyUsed, int64_t bytes, int frame, Texture* exclude); // returns the number of bytes released
+
+        int64_t budget = 0;
+        int64_t uploadLimit = 16*1000*1000;
+        float mipBias = 0;
+
+        friend class Renderer;
+        friend class Texture;
+    };
+}
@@ -0,0 +1,44 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include "sre/Texture.hpp"
+
+namespace sre {
+    /**
+     * Helpers for block compressed texture data (4x4 pixel blocks, stored row by row).
+     *
+     * Decoding to RGBA is used when the GPU does not support a compressed format. BC7 is not decoded (the format
+     * requires a GPU with BPTC support, which all OpenGL 4.2 GPUs have).
+     *
+     * Encoding (used by TextureBuilder::withCompression()) runs in parallel over the block rows. BC1 endpoints are
+     * found along the principal axis of the block colors followed by a least squares refinement (the index selection
+     * uses SSE2 when available). ETC2 is encoded using the ETC1 compatible individual and differential modes. BC7
+     * is not encoded.
+     */
+    class BlockCompression {
+    public:
+        static int blockSize(Texture::Compression compression);                         // bytes per 4x4 block
+        static size_t levelSize(Texture::Compression compression, int width, int height); // bytes of a compressed image
+        static bool isTransparent(Texture::Compression compression);
+
+        static bool canDecode(Texture::Compression compression);
+        static std::vector<char> decode(Texture::Compression compression,               // Decode to RGBA (one byte per channel).
+                                        const char* data, int width, int height);       // Returns an empty vector if not supported
+
+        static bool canEncode(Texture::Compression compression);
+        static std::vector<char> encode(Texture::Compression compression,               // Encode RGB or RGBA data (bytesPerPixel 3 or 4).
+                                        const char* data, int width, int height,        // BC1 and ETC2 RGB ignore alpha
+                                        int bytesPerPixel);
+
+        static bool canFlipY(Texture::Compression compression, int height);
+        static bool flipY(Texture::Compression compression, char* data, int width, int height); // Flip image rows in place (returns false
+                                                                                        // if not supported by the format)
+    };
+}
@@ -39,11 +39,7 @@ void  checkGLError(const char* title) {
 }
 
 bool hasExtension(std::string extensionName){
-    std::string exts = (char*)glGetString(GL_EXTENSIONS);
-    std::stringstream ss(exts);
-    std::string item;
-    std::vector<std::string> elems;
-    while (std::getline(ss, item, ' ')) {
+    for (auto& item : listExtension()){
         if (item == extensionName){
             return true;
         }
@@ -53,10 +49,20 @@ bool hasExtension(std::string extensionName){
 }
 
 std::vector<std::string> listExtension(){
-    std::string exts = (char*)glGetString(GL_EXTENSIONS);
+    std::vector<std::string> elems;
+    auto exts = (const char*)glGetString(GL_EXTENSIONS);
+    if (exts == nullptr){
+        // core profile: GL_EXTENSIONS is not a valid glGetString parameter
+        while (glGetError() != GL_NO_ERROR){}
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++){
+            elems.emplace_back((const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        }
+        return elems;
+    }
     std::stringstream ss(exts);
     std::string item;
-    std::vector<std::string> elems;
     while (std::getline(ss, item, ' ')) {
         elems.push_back(std::move(item));
     }
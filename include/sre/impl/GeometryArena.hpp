@@ -0,0 +1,81 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace sre {
+    class Mesh;
+
+    /**
+     * Sub-allocates static meshes with the same vertex layout from a shared vertex buffer and a shared index buffer.
+     * Meshes in an arena are drawn using base vertex offsets, which allows RenderPass to skip rebinding buffers
+     * between meshes in the same arena.
+     *
+     * Allocation uses a first-fit free-list (adjacent free blocks are merged). When an allocation does not fit, the
+     * arena grows and defragments by copying the live meshes into new buffers.
+     *
+     * Arenas are shared per vertex layout and created by Mesh::MeshBuilder::withGeometryArena().
+     * Requires OpenGL 3.2 (glDrawElementsBaseVertex).
+     */
+    class GeometryArena {
+    public:
+        ~GeometryArena();
+
+        static bool isSupported();                                  // Returns true if base vertex drawing is supported
+
+        const std::string& getLayoutKey();
+        int getBytesPerVertex();
+        int getVertexCapacity();
+        int getVerticesUsed();
+        int getIndexCapacity();
+        int getIndicesUsed();
+        int getMeshCount();
+        int getDataSize();                                          // size of the arena buffers in bytes on GPU
+
+        void defragment();                                          // Compact the meshes (removes holes left by deallocated meshes)
+    private:
+        GeometryArena(const std::string& layoutKey, int bytesPerVertex);
+        static std::shared_ptr<GeometryArena> get(const std::string& layoutKey, int bytesPerVertex);
+
+        void allocate(Mesh* mesh, const void* vertexData, int vertexCount, const uint16_t* indexData, int indexCount);
+        void free(Mesh* mesh);
+        void resize(int vertexCapacity, int indexCapacity);         // copy the live meshes packed into new buffers
+
+        class FreeList {
+        public:
+            void reset(int capacity, int used);
+            int allocate(int size);                                 // returns offset or -1 if no free block is large enough
+            void free(int offset, int size);
+            int capacity = 0;
+            int used = 0;
+        private:
+            std::map<int,int> freeBlocks;                           // offset to size
+        };
+
+        std::string layoutKey;
+        int bytesPerVertex;
+        int id;
+        static int arenaIdCount;
+
+        unsigned int vertexBufferId = 0;
+        unsigned int elementBufferId = 0;
+        FreeList vertices;
+        FreeList indices;
+        std::vector<Mesh*> meshes;
+
+        friend class Mesh;
+        friend class Renderer;
+        friend class Inspector;
+        friend class VertexArrayCache;
+    };
+}
@@ -0,0 +1,41 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace sre {
+    /**
+     * Read-only memory mapped file. Uses mmap (or MapViewOfFile on Windows).
+     * On platforms without memory mapping (Emscripten) the file is read into memory.
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& filename);                     // returns false if the file cannot be opened
+        void close();
+        void discard(size_t offset, size_t size);                   // hint that the range is no longer needed (releases the pages)
+
+        const char* data() const;
+        size_t size() const;
+    private:
+        const char* ptr = nullptr;
+        size_t length = 0;
+        std::vector<char> buffer;                                   // used when memory mapping is not supported
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,27 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include "sre/Texture.hpp"
+
+namespace sre {
+    /**
+     * Generates mipmaps on the CPU (used by TextureBuilder instead of glGenerateMipmap, whose filter quality and sRGB
+     * handling depend on the driver).
+     *
+     * Each level is computed from the previous 8 bit level, in parallel over the destination rows. Pixels are converted
+     * to linear float using lookup tables while filtering (one SSE2 vector per RGBA pixel when available), so no float
+     * copy of the image is made. sRGB textures are filtered in linear space (alpha is always linear).
+     */
+    class MipmapGenerator {
+    public:
+        static std::vector<std::vector<char>> generate(const char* data, int width, int height, int bytesPerPixel,   // Returns mip levels 1..n (down to 1x1)
+                                                       bool srgb, Texture::MipmapFilter filter);                       // using the format of data (RGB or RGBA)
+    };
+}
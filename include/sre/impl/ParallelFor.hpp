@@ -0,0 +1,22 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <functional>
+#include <cstddef>
+
+namespace sre {
+    // Splits [0;count) into blocks of at least minBlockSize elements and invokes fn(begin, end) for each block using
+    // a pool of worker threads (created once and reused). Returns when all blocks are processed. Runs on the calling
+    // thread if count is less than two blocks, when called from a worker thread (nested) or if threads are not
+    // supported (Emscripten).
+    void parallelFor(size_t count, size_t minBlockSize, const std::function<void(size_t begin, size_t end)>& fn);
+
+    // Number of threads used by parallelFor
+    int parallelForThreadCount();
+}
@@ -0,0 +1,32 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include "sre/Texture.hpp"
+
+namespace sre {
+    /**
+     * Reads block compressed 2D textures (including pre-built mipmaps) from KTX, KTX2 and DDS files and writes KTX files.
+     * Supports BC1, BC3, BC5, BC7 and ETC2 (ETC1 is read as ETC2 RGB). Cubemaps, arrays, 3D textures and
+     * supercompressed KTX2 files are not supported.
+     */
+    struct TextureContainer {
+        static bool isContainer(const char* data, size_t size);        // Returns true if data starts with a KTX, KTX2 or DDS header
+
+        bool load(const char* data, size_t size, const std::string& name); // Returns false (and logs an error) if the file is invalid
+                                                                        // or not supported
+        std::vector<char> saveKTX() const;                              // KTX file (rows are stored bottom-up, topDown is ignored)
+        int width = 0;
+        int height = 0;
+        Texture::Compression compression = Texture::Compression::None;
+        bool topDown = false;                                           // true if the first row of the image is the top row
+        std::vector<std::vector<char>> levels;                          // mip levels (level 0 is the full size image)
+    };
+}
@@ -43,6 +43,7 @@ namespace sre {
         std::map<int,float> floatValues;
 
         friend class Material;
+        friend class RenderPass;
     };
 
     template<>
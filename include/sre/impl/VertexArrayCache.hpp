@@ -0,0 +1,62 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace sre {
+    class Mesh;
+    class Shader;
+
+    struct VertexAttributePointer {
+        unsigned int location;
+        int elementCount;
+        int dataType;
+        bool integer;
+        int offset;
+    };
+
+    /**
+     * Shares vertex array objects between meshes with identical vertex layouts.
+     *
+     * A vertex array object is created per (vertex layout, shader) and only the vertex buffer and element buffer
+     * are swapped when another mesh with the same layout is bound. On OpenGL 4.3 the vertex format is separated from
+     * the buffer (glVertexAttribFormat and glBindVertexBuffer). On older contexts the attribute pointers of the
+     * enabled attributes are respecified for the new vertex buffer.
+     *
+     * Owned by the Renderer. Used by Mesh::bind() when vertex array objects are supported (OpenGL 3.0 / WebGL 2).
+     */
+    class VertexArrayCache {
+    public:
+        ~VertexArrayCache();
+
+        static bool isVertexAttribBindingSupported();               // Returns true if glBindVertexBuffer is supported (OpenGL 4.3)
+
+        int getLayoutId(const std::string& layoutKey);              // Returns a unique id for the vertex layout
+        void bind(Mesh* mesh, Shader* shader);
+        void removeShader(long shaderUniqueId);                     // Delete vertex array objects created for the shader
+        void clear();
+
+        int getVertexArrayCount();
+        int getLayoutCount();
+    private:
+        struct VertexArray {
+            unsigned int vaoID;
+            int stride;
+            std::vector<VertexAttributePointer> pointers;           // enabled attributes
+        };
+        void create(VertexArray& vertexArray, Mesh* mesh, Shader* shader, unsigned int vertexBuffer);
+
+        std::map<std::string, int> layoutIds;
+        std::map<std::pair<int,long>, VertexArray> vertexArrays;    // (layout id, shader unique id) to vertex array
+        int vertexAttribBinding = -1;                               // -1 = unknown
+    };
+}
@@ -0,0 +1,38 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace sre {
+    /**
+     * Assigns a unique index to each distinct vertex key. Keys are fixed size arrays of 32 bit words, stored
+     * contiguously and looked up in a flat open addressing table (linear probing, kept at most half full).
+     *
+     * Used to weld duplicate vertices (Mesh::MeshBuilder::withWeld()) and to deduplicate vertices when importing models.
+     */
+    class VertexWelder {
+    public:
+        explicit VertexWelder(int keyWords, int expectedCount = 0); // keyWords is the number of 32 bit words in each key
+
+        int insert(const uint32_t* key);                            // Returns the index of an equal key or the index of the new key
+        int size() const;                                           // Number of unique keys
+        const uint32_t* getKey(int index) const;
+        void clear();
+    private:
+        void grow();
+        uint64_t hash(const uint32_t* key) const;
+
+        int keyWords;
+        int count = 0;
+        std::vector<uint32_t> keys;
+        std::vector<int32_t> table;                                 // index of key or -1 if empty
+        uint64_t mask = 0;
+    };
+}
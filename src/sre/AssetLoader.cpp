@@ -0,0 +1,272 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/AssetLoader.hpp"
+
+#include <chrono>
+#include <algorithm>
+#include "sre/Texture.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/SpriteAtlas.hpp"
+#include "sre/ModelImporter.hpp"
+#include "sre/ResourceCache.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/ParallelFor.hpp"
+
+namespace sre {
+    namespace {
+        const int maxWorkerThreads = 4;
+    }
+
+    AssetLoader *AssetLoader::instance() {
+        if (Renderer::instance == nullptr){
+            LOG_FATAL("Cannot use sre::AssetLoader before sre::Renderer is created.");
+        }
+        return Renderer::instance->assetLoader.get();
+    }
+
+    AssetLoader::~AssetLoader() {
+#ifndef EMSCRIPTEN
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopWorkers = true;
+        }
+        loadCondition.notify_all();
+        for (auto& worker : workers){
+            worker.join();
+        }
+#endif
+    }
+
+    template<typename T>
+    AssetHandle<T> AssetLoader::createHandle() {
+        AssetHandle<T> handle;
+        handle.state = std::make_shared<typename AssetHandle<T>::State>();
+        return handle;
+    }
+
+    template<typename T>
+    void AssetLoader::complete(AssetHandle<T> &handle, std::shared_ptr<T> asset, const std::function<void(std::shared_ptr<T>)> &onLoaded) {
+        handle.state->asset = asset;
+        handle.state->done = true;
+        if (onLoaded){
+            onLoaded(asset);
+        }
+    }
+
+    void AssetLoader::enqueue(std::shared_ptr<Job> job) {
+        pending++;
+        std::lock_guard<std::mutex> lock(mutex);
+        loadQueue.push_back(job);
+#ifndef EMSCRIPTEN
+        int threadCount = std::max(1, std::min(maxWorkerThreads, parallelForThreadCount() - 1));
+        if ((int)workers.size() < threadCount && workers.size() < loadQueue.size()){
+            workers.emplace_back(&AssetLoader::workerLoop, this);
+        }
+        loadCondition.notify_one();
+#endif
+    }
+
+    void AssetLoader::workerLoop() {
+#ifndef EMSCRIPTEN
+        while (true){
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                loadCondition.wait(lock, [&](){ return stopWorkers || !loadQueue.empty(); });
+                if (stopWorkers){
+                    return;
+                }
+                job = loadQueue.front();
+                loadQueue.pop_front();
+            }
+            job->load();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                uploadQueue.push_back(job);
+            }
+            uploadCondition.notify_all();
+        }
+#endif
+    }
+
+    bool AssetLoader::processUpload() {
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+#ifdef EMSCRIPTEN
+            // no worker threads: load on the render thread
+            if (uploadQueue.empty() && !loadQueue.empty()){
+                job = loadQueue.front();
+                loadQueue.pop_front();
+                job->load();
+                uploadQueue.push_back(job);
+                return true;
+            }
+#endif
+            if (uploadQueue.empty()){
+                return false;
+            }
+            job = uploadQueue.front();
+        }
+        // jobs are only removed from the upload queue on the render thread
+        if (job->upload()){
+            std::lock_guard<std::mutex> lock(mutex);
+            uploadQueue.pop_front();
+            pending--;
+        }
+        return true;
+    }
+
+    void AssetLoader::update() {
+        auto loader = instance();
+        if (loader->pending == 0){
+            return;
+        }
+        using Clock = std::chrono::high_resolution_clock;
+        auto start = Clock::now();
+        do {
+            if (!loader->processUpload()){
+                break;
+            }
+        } while (std::chrono::duration<float, std::milli>(Clock::now() - start).count() < loader->uploadBudget);
+    }
+
+    void AssetLoader::finish() {
+        auto loader = instance();
+        while (loader->pending > 0){
+            if (!loader->processUpload()){
+#ifndef EMSCRIPTEN
+                std::unique_lock<std::mutex> lock(loader->mutex);
+                loader->uploadCondition.wait_for(lock, std::chrono::milliseconds(1), [&](){ return !loader->uploadQueue.empty(); });
+#endif
+            }
+        }
+    }
+
+    void AssetLoader::setUploadBudget(float milliseconds) {
+        instance()->uploadBudget = milliseconds;
+    }
+
+    float AssetLoader::getUploadBudget() {
+        return instance()->uploadBudget;
+    }
+
+    int AssetLoader::getPendingCount() {
+        return instance()->pending;
+    }
+
+    AssetHandle<Texture> AssetLoader::loadTexture(const std::string &filename, bool generateMipmaps, std::function<void(std::shared_ptr<Texture>)> onLoaded) {
+        auto handle = createHandle<Texture>();
+        auto builder = std::shared_ptr<Texture::TextureBuilder>(new Texture::TextureBuilder());
+        auto job = std::make_shared<Job>();
+        job->load = [=](){
+            builder->withFile(filename).withGenerateMipmaps(generateMipmaps);
+            builder->prepareMipmaps();                      // keep the mipmap generation out of the upload step
+        };
+        job->upload = [=]() mutable {
+            std::shared_ptr<Texture> texture;
+            if (isDecoded(*builder)){
+                texture = ResourceCache::getTextureFile(filename, generateMipmaps, [&](){
+                    return builder->build();
+                });
+            }
+            complete(handle, texture, onLoaded);
+            return true;
+        };
+        instance()->enqueue(job);
+        return handle;
+    }
+
+    AssetHandle<ObjAsset> AssetLoader::loadObj(const std::string &path, const std::string &filename, std::function<void(std::shared_ptr<ObjAsset>)> onLoaded) {
+        struct ObjState {
+            std::shared_ptr<ModelImporter::ObjModel> model;
+            std::vector<std::pair<std::string, std::shared_ptr<Texture::TextureBuilder>>> textures;
+            std::vector<std::shared_ptr<Texture>> uploadedTextures;     // keeps the textures alive in the cache until the materials are created
+            size_t step = 0;
+        };
+        auto handle = createHandle<ObjAsset>();
+        auto state = std::make_shared<ObjState>();
+        auto job = std::make_shared<Job>();
+        job->load = [=](){
+            state->model = ModelImporter::parseObj(path, filename);
+            if (!state->model){
+                return;
+            }
+            auto files = ModelImporter::getTextureFiles(*state->model);
+            std::sort(files.begin(), files.end());
+            files.erase(std::unique(files.begin(), files.end()), files.end());
+            std::vector<std::shared_ptr<Texture::TextureBuilder>> builders(files.size());
+            parallelFor(files.size(), 1, [&](size_t begin, size_t end){
+                for (size_t i = begin; i < end; i++){
+                    builders[i] = std::shared_ptr<Texture::TextureBuilder>(new Texture::TextureBuilder());
+                    builders[i]->withFile(files[i]);
+                }
+            });
+            for (size_t i = 0; i < files.size(); i++){
+                if (isDecoded(*builders[i])){
+                    state->textures.emplace_back(files[i], builders[i]);
+                }
+            }
+        };
+        job->upload = [=]() mutable {
+            if (!state->model){
+                complete(handle, std::shared_ptr<ObjAsset>(), onLoaded);
+                return true;
+            }
+            // upload one texture per step, then the mesh
+            if (state->step < state->textures.size()){
+                auto& texture = state->textures[state->step++];
+                state->uploadedTextures.push_back(ResourceCache::getTextureFile(texture.first, false, [&](){
+                    return texture.second->build();
+                }));
+                return false;
+            }
+            auto asset = std::make_shared<ObjAsset>();
+            asset->mesh = ModelImporter::buildObj(*state->model, asset->materials);
+            complete(handle, asset->mesh ? asset : std::shared_ptr<ObjAsset>(), onLoaded);
+            return true;
+        };
+        instance()->enqueue(job);
+        return handle;
+    }
+
+    AssetHandle<SpriteAtlas> AssetLoader::loadAtlas(const std::string &jsonFile, const std::string &imageFile, bool flipAnchorY, std::function<void(std::shared_ptr<SpriteAtlas>)> onLoaded) {
+        struct AtlasState {
+            std::string json;
+            bool jsonRead = false;
+            std::shared_ptr<Texture::TextureBuilder> builder;
+        };
+        auto handle = createHandle<SpriteAtlas>();
+        auto state = std::make_shared<AtlasState>();
+        state->builder = std::shared_ptr<Texture::TextureBuilder>(new Texture::TextureBuilder());
+        auto job = std::make_shared<Job>();
+        job->load = [=](){
+            state->jsonRead = SpriteAtlas::readJSON(jsonFile, state->json);
+            if (state->jsonRead){
+                state->builder->withFile(imageFile);
+            }
+        };
+        job->upload = [=]() mutable {
+            std::shared_ptr<SpriteAtlas> atlas;
+            if (state->jsonRead && isDecoded(*state->builder)){
+                atlas = SpriteAtlas::createFromJSON(state->json, jsonFile, state->builder->build(), flipAnchorY);
+            }
+            complete(handle, atlas, onLoaded);
+            return true;
+        };
+        instance()->enqueue(job);
+        return handle;
+    }
+
+    bool AssetLoader::isDecoded(Texture::TextureBuilder &builder) {
+        auto data = builder.textureTypeData.find(GL_TEXTURE_2D);
+        return data != builder.textureTypeData.end() && !data->second.data.empty();
+    }
+}
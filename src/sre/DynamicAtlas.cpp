@@ -0,0 +1,253 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/DynamicAtlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include "sre/Texture.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/MappedFile.hpp"
+#define STBRP_STATIC                                        // imgui_draw.cpp compiles its own static copy
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "stb_rect_pack.h"
+
+namespace sre {
+    struct DynamicAtlas::Page {
+        std::shared_ptr<Texture> texture;
+        stbrp_context context;
+        std::vector<stbrp_node> nodes;
+        int usedArea = 0;
+    };
+
+    DynamicAtlas::DynamicAtlasBuilder &DynamicAtlas::DynamicAtlasBuilder::withPageSize(int size) {
+        this->pageSize = size;
+        return *this;
+    }
+
+    DynamicAtlas::DynamicAtlasBuilder &DynamicAtlas::DynamicAtlasBuilder::withPadding(int padding) {
+        this->padding = padding;
+        return *this;
+    }
+
+    DynamicAtlas::DynamicAtlasBuilder &DynamicAtlas::DynamicAtlasBuilder::withFilterSampling(bool enable) {
+        this->filterSampling = enable;
+        return *this;
+    }
+
+    DynamicAtlas::DynamicAtlasBuilder &DynamicAtlas::DynamicAtlasBuilder::withName(const std::string &name) {
+        this->name = name;
+        return *this;
+    }
+
+    std::shared_ptr<DynamicAtlas> DynamicAtlas::DynamicAtlasBuilder::build() {
+        if (pageSize <= 0 || pageSize > 0xffff){
+            LOG_ERROR("Invalid page size %i of dynamic atlas %s", pageSize, name.c_str());
+            pageSize = 1024;
+        }
+        padding = std::max(padding, 0);
+        return std::shared_ptr<DynamicAtlas>(new DynamicAtlas(*this));
+    }
+
+    DynamicAtlas::DynamicAtlasBuilder DynamicAtlas::create() {
+        return DynamicAtlasBuilder();
+    }
+
+    DynamicAtlas::DynamicAtlas(DynamicAtlasBuilder &builder)
+    :pageSize(builder.pageSize), padding(builder.padding), filterSampling(builder.filterSampling), name(builder.name)
+    {
+    }
+
+    DynamicAtlas::~DynamicAtlas() = default;
+
+    DynamicAtlas::Page *DynamicAtlas::allocate(int width, int height, glm::ivec2 &pos) {
+        if (width > pageSize || height > pageSize){
+            LOG_ERROR("Image %ix%i is larger than the page size of dynamic atlas %s", width, height, name.c_str());
+            return nullptr;
+        }
+        stbrp_rect rect;
+        rect.id = 0;
+        rect.w = (stbrp_coord)width;
+        rect.h = (stbrp_coord)height;
+        for (auto& page : pages){
+            stbrp_pack_rects(&page->context, &rect, 1);
+            if (rect.was_packed){
+                pos = {rect.x, rect.y};
+                page->usedArea += width * height;
+                return page.get();
+            }
+        }
+        // create new page (cleared to transparent black)
+        auto page = std::unique_ptr<Page>(new Page());
+        std::vector<char> clear((size_t)pageSize * pageSize * 4, 0);
+        page->texture = Texture::create()
+                .withRGBAData(clear.data(), pageSize, pageSize)
+                .withFilterSampling(filterSampling)
+                .withWrapUV(Texture::Wrap::ClampToEdge)
+                .withName(name + " page " + std::to_string(pages.size()))
+                .build();
+        page->nodes.resize((size_t)pageSize);
+        stbrp_init_target(&page->context, pageSize, pageSize, page->nodes.data(), (int)page->nodes.size());
+        stbrp_pack_rects(&page->context, &rect, 1);
+        pos = {rect.x, rect.y};
+        page->usedArea += width * height;
+        pages.push_back(std::move(page));
+        return pages.back().get();
+    }
+
+    Sprite DynamicAtlas::insert(const std::string &name, Sprite sprite) {
+        sprites.emplace(name, sprite);
+        return sprite;
+    }
+
+    Sprite DynamicAtlas::add(const std::string &name, const char *rgbaData, int width, int height, glm::vec2 pivot) {
+        if (contains(name)){
+            LOG_WARNING("Sprite %s already in dynamic atlas %s", name.c_str(), this->name.c_str());
+            return get(name);
+        }
+        if (rgbaData == nullptr || width <= 0 || height <= 0){
+            LOG_ERROR("Cannot add sprite %s to dynamic atlas %s. Invalid image (%i x %i)", name.c_str(), this->name.c_str(), width, height);
+            return {};
+        }
+        glm::ivec2 pos;
+        int paddedWidth = width + padding * 2;
+        int paddedHeight = height + padding * 2;
+        Page* page = allocate(paddedWidth, paddedHeight, pos);
+        if (page == nullptr){
+            return {};
+        }
+        // extend the edge pixels into the padding
+        std::vector<char> padded((size_t)paddedWidth * paddedHeight * 4);
+        for (int y=0;y<paddedHeight;y++){
+            int srcY = std::min(std::max(y - padding, 0), height - 1);
+            for (int x=0;x<paddedWidth;x++){
+                int srcX = std::min(std::max(x - padding, 0), width - 1);
+                memcpy(&padded[((size_t)y * paddedWidth + x) * 4], rgbaData + ((size_t)srcY * width + srcX) * 4, 4);
+            }
+        }
+        page->texture->updateRegion(pos.x, pos.y, paddedWidth, paddedHeight, padded.data());
+
+        glm::ivec2 size{width, height};
+        return insert(name, Sprite(pos + glm::ivec2(padding), size, {0,0}, size, pivot, page->texture.get()));
+    }
+
+    Sprite DynamicAtlas::addFile(const std::string &name, const std::string &filename, glm::vec2 pivot) {
+        MappedFile file;
+        if (!file.open(filename) || file.size() == 0){
+            LOG_ERROR("Cannot read image %s", filename.c_str());
+            return {};
+        }
+
+        GLenum format;
+        bool alpha;
+        int width, height, bytesPerPixel;
+        auto data = Texture::loadFileFromMemory(file.data(), (int)file.size(), format, alpha, width, height, bytesPerPixel);
+        if (data.empty()){
+            return {};
+        }
+        if (bytesPerPixel == 3){
+            std::vector<char> rgba((size_t)width * height * 4, (char)0xff);
+            for (size_t i=0;i<(size_t)width * height;i++){
+                memcpy(&rgba[i * 4], &data[i * 3], 3);
+            }
+            data = std::move(rgba);
+        }
+        return add(name, data.data(), width, height, pivot);
+    }
+
+    Sprite DynamicAtlas::add(const std::string &name, const Sprite &sprite) {
+        if (contains(name)){
+            LOG_WARNING("Sprite %s already in dynamic atlas %s", name.c_str(), this->name.c_str());
+            return get(name);
+        }
+        if (sprite.texture == nullptr){
+            LOG_ERROR("Cannot add sprite %s without a texture to dynamic atlas %s", name.c_str(), this->name.c_str());
+            return {};
+        }
+        glm::ivec2 pos;
+        glm::ivec2 size = sprite.spriteSize;
+        Page* page = allocate(size.x + padding * 2, size.y + padding * 2, pos);
+        if (page == nullptr){
+            return {};
+        }
+        // copy from a framebuffer with the source texture attached
+        sprite.texture->markUsed();                         // reload if unloaded
+        GLint boundFramebuffer;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &boundFramebuffer);
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sprite.texture->textureId, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE){
+            glBindTexture(GL_TEXTURE_2D, page->texture->textureId);
+            glm::ivec2 src = sprite.spritePos;
+            glm::ivec2 dst = pos + glm::ivec2(padding);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x, dst.y, src.x, src.y, size.x, size.y);
+            // extend the edge pixels into the padding
+            for (int i=1;i<=padding;i++){
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x - i, dst.y, src.x, src.y, 1, size.y);
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x + size.x - 1 + i, dst.y, src.x + size.x - 1, src.y, 1, size.y);
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x, dst.y - i, src.x, src.y, size.x, 1);
+                glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x, dst.y + size.y - 1 + i, src.x, src.y + size.y - 1, size.x, 1);
+            }
+            // fill the corners with the corner pixels
+            for (int i=1;i<=padding;i++){
+                for (int j=1;j<=padding;j++){
+                    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x - i, dst.y - j, src.x, src.y, 1, 1);
+                    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x + size.x - 1 + i, dst.y - j, src.x + size.x - 1, src.y, 1, 1);
+                    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x - i, dst.y + size.y - 1 + j, src.x, src.y + size.y - 1, 1, 1);
+                    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst.x + size.x - 1 + i, dst.y + size.y - 1 + j, src.x + size.x - 1, src.y + size.y - 1, 1, 1);
+                }
+            }
+        } else {
+            LOG_ERROR("Cannot copy sprite %s to dynamic atlas %s. Texture %s cannot be read.", name.c_str(), this->name.c_str(), sprite.texture->getName().c_str());
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)boundFramebuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+
+        Sprite res(pos + glm::ivec2(padding), size, sprite.spriteSourcePos, sprite.spriteSourceSize, sprite.spriteAnchor, page->texture.get());
+        return insert(name, res);
+    }
+
+    bool DynamicAtlas::contains(const std::string &name) {
+        return sprites.find(name) != sprites.end();
+    }
+
+    Sprite DynamicAtlas::get(const std::string &name) {
+        auto res = sprites.find(name);
+        if (res == sprites.end()){
+            LOG_WARNING("Cannot find sprite %s in dynamic atlas %s", name.c_str(), this->name.c_str());
+            return {};
+        }
+        return res->second;
+    }
+
+    std::vector<std::string> DynamicAtlas::getNames() {
+        std::vector<std::string> res;
+        for (auto & e : sprites){
+            res.push_back(e.first);
+        }
+        return res;
+    }
+
+    const std::string &DynamicAtlas::getName() {
+        return name;
+    }
+
+    int DynamicAtlas::getPageCount() {
+        return (int)pages.size();
+    }
+
+    std::shared_ptr<Texture> DynamicAtlas::getTexture(int page) {
+        return pages.at((size_t)page)->texture;
+    }
+
+    float DynamicAtlas::getPageUsage(int page) {
+        return pages.at((size_t)page)->usedArea / (float)(pageSize * pageSize);
+    }
+}
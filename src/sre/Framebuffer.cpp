@@ -26,6 +26,7 @@ namespace sre{
         } else {
             this->size = s;
         }
+        texture->disableReload();                           // rendered content cannot be reloaded from file
         textures.push_back(texture);
         return *this;
     }
@@ -103,6 +104,7 @@ namespace sre{
     void Framebuffer::setColorTexture(std::shared_ptr<Texture> tex, int index) {
         assert(textures.size() > index && index >= 0);
         assert(!tex->isDepthTexture());
+        tex->disableReload();
         textures[index] = tex;
         dirty = true;
     }
@@ -20,6 +20,10 @@
 #include "sre/Framebuffer.hpp"
 #include "sre/RenderPass.hpp"
 #include "sre/Sprite.hpp"
+#include "sre/impl/GeometryArena.hpp"
+#include "sre/impl/VertexArrayCache.hpp"
+#include "sre/ResourceCache.hpp"
+#include "sre/TextureStreamer.hpp"
 #include "imgui_internal.h"
 #include <SDL_image.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -131,9 +135,21 @@ namespace sre {
             ImGui::LabelText("Colorspace", "%s", colorSpace);
             const char* wrap = tex->getWrapUV()==Texture::Wrap::Repeat?"Repeat":(tex->getWrapUV()==Texture::Wrap::Mirror?"Mirror":"Clamp to edge");
             ImGui::LabelText("Wrap tex-coords",wrap);
+            const char* compressionStr[] = {"None", "BC1", "BC3", "BC5", "BC7", "ETC2 RGB", "ETC2 RGBA"};
+            ImGui::LabelText("Compression","%s",compressionStr[(int)tex->getCompression()]);
             ImGui::LabelText("Data size","%f MB",tex->getDataSize()/(1000*1000.0f));
+            ImGui::LabelText("Last used frame","%i",tex->getLastUsedFrame());
+            if (tex->isReloadable()){
+                ImGui::LabelText("Reload from","%s (%s)",tex->sourceFile.c_str(),tex->isLoaded()?"loaded":"unloaded");
+            }
+            if (tex->isStreaming()){
+                auto& state = *tex->streaming;
+                ImGui::LabelText("Resident mip","%i (%ix%i)",state.residentMip,std::max(1,tex->getWidth()>>state.residentMip),std::max(1,tex->getHeight()>>state.residentMip));
+                ImGui::LabelText("Requested mip","%i (frame %i)",state.requestedMip,state.lastRequestFrame);
+                ImGui::LabelText("Streamed mips","%i..%i",state.tailMip,(int)state.levels.size()-1);
+            }
             if (!tex->isCubemap()){
-                ImGui::Image(reinterpret_cast<ImTextureID>(tex->textureId), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
+                ImGui::Image(reinterpret_cast<ImTextureID>(tex->getNativeTextureId()), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
             }
 
             ImGui::TreePop();
@@ -145,6 +161,8 @@ namespace sre {
         if (ImGui::TreeNode(s.c_str())){
             ImGui::LabelText("Vertex count", "%i", mesh->getVertexCount());
             ImGui::LabelText("Mesh size", "%.2f MB", mesh->getDataSize()/(1000*1000.0f));
+            ImGui::LabelText("CPU data", "%s", mesh->isKeepCPUData()?"Kept":"Released");
+            ImGui::LabelText("Geometry arena", "%s", mesh->isInGeometryArena()?"Yes":"No");
             if (ImGui::TreeNode("Vertex attributes")){
                 auto attributeNames = mesh->getAttributeNames();
                 for (auto & a : attributeNames) {
@@ -163,6 +181,14 @@ namespace sre {
                         char res[128];
                         sprintf(res,"Index %i size",i);
                         ImGui::LabelText(res, "%i", mesh->getIndicesSize(i));
+                        if (mesh->getMeshletCount(i) > 0){
+                            sprintf(res,"Index %i meshlets",i);
+                            ImGui::LabelText(res, "%i", mesh->getMeshletCount(i));
+                        }
+                        for (int lod=0;lod<mesh->getLODCount();lod++){
+                            sprintf(res,"Index %i LOD %i size",i,lod);
+                            ImGui::LabelText(res, "%i (screen size < %.2f)", mesh->getLODIndicesSize(lod, i), mesh->getLODScreenSize(lod));
+                        }
                     }
                 }
                 ImGui::TreePop();
@@ -252,7 +278,7 @@ namespace sre {
                 static auto litMat = Shader::getStandardBlinnPhong()->createMaterial();
                 static auto unlitMat = Shader::getUnlit()->createMaterial();
 
-                bool hasNormals = mesh->getNormals().size()>0;
+                bool hasNormals = mesh->hasAttribute("normal");
                 auto mat = hasNormals ? litMat : unlitMat;
                 auto sharedPtrMesh = mesh->shared_from_this();
                 float rotationSpeed = 0.001f;
@@ -269,7 +295,7 @@ namespace sre {
                 }
                 renderToTexturePass.draw(sharedPtrMesh, glm::eulerAngleY(time*rotationSpeed)*glm::scale(glm::vec3{2.0f/maxS,2.0f/maxS,2.0f/maxS})*glm::translate(offset), mats);
 
-                ImGui::Image(reinterpret_cast<ImTextureID>(offscreenTexture->textureId), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
+                ImGui::Image(reinterpret_cast<ImTextureID>(offscreenTexture->getNativeTextureId()), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
             } else {
                 ImGui::LabelText("", "No preview - missing position attribute");
             }
@@ -355,7 +381,7 @@ namespace sre {
 
             renderToTexturePass.draw(mesh, glm::eulerAngleY(time*rotationSpeed), mat);
 
-            ImGui::Image(reinterpret_cast<ImTextureID>(offscreenTexture->textureId), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
+            ImGui::Image(reinterpret_cast<ImTextureID>(offscreenTexture->getNativeTextureId()), ImVec2(previewSize, previewSize),{0,1},{1,0},{1,1,1,1},{0,0,0,1});
             ImGui::TreePop();
         }
     }
@@ -504,6 +530,26 @@ namespace sre {
 
             ImGui::PlotLines(res,data.data(),frames, 0, "State changes", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
 
+            max = 0;
+            sum = 0;
+            for (int i=0;i<frames;i++){
+                int idx = (frameCount + i)%frames;
+                float t = stats[idx].triangles;
+                data[(-frameCount%frames+idx+frames)%frames] = t;
+                max = std::max(max, t);
+                sum += t;
+            }
+            avg = 0;
+            if (frameCount > 0){
+                avg = sum / std::min(frameCount, frames);
+            }
+            sprintf(res,"Avg: %4.0f\n"
+                        "Max: %4.0f\n"
+                        "Cur: %4.0f\n"
+                              ,avg,max,data[frames-1]);
+
+            ImGui::PlotLines(res,data.data(),frames, 0, "Triangles", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
             plotTimings(millisecondsFrameTime.data(), "Frame-time ms");
         }
         if (ImGui::CollapsingHeader("Frame inspector")){
@@ -608,6 +654,22 @@ namespace sre {
                         "Count: %i",avg,max, data[frames-1],(int)r->textures.size());
 
             ImGui::PlotLines(res,data.data(),frames, 0, "Texture MB", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+            auto& last = stats[(frameCount+frames-1)%frames];
+            ImGui::LabelText("Texture updates", "%.2f MB this frame", last.textureBytesUpdated/1000000.0f);
+            if (last.textureBudget > 0 || last.textureStreamingCount > 0){
+                if (last.textureBudget > 0){
+                    ImGui::ProgressBar(last.textureBytes/(float)last.textureBudget, ImVec2(ImGui::CalcItemWidth(),0), "");
+                    ImGui::SameLine();
+                    ImGui::Text("Budget %.1f / %.1f MB",last.textureBytes/1000000.0f,last.textureBudget/1000000.0f);
+                }
+                ImGui::LabelText("Streamed textures", "%i (%i pending, %i mips missing)", last.textureStreamingCount, last.textureStreamingPending, last.textureStreamingMissingMips);
+                ImGui::LabelText("Mip uploads / evictions", "%i / %i", last.textureStreamingUploads, last.textureStreamingEvictions);
+                ImGui::LabelText("Unloaded textures", "%i (%i unloads, %i reloads)", last.textureUnloadedCount, last.textureUnloads, last.textureReloads);
+                if (ImGui::Button("Evict textures")){
+                    TextureStreamer::evictAll();
+                }
+            }
         }
         if (ImGui::CollapsingHeader("Shaders")){
             for (auto s : r->shaders){
@@ -631,6 +693,33 @@ namespace sre {
             }
             if (r->meshes.empty()){
                 ImGui::LabelText("","No meshes");
+            } else if (renderInfo().graphicsAPIVersionMajor >= 3){
+                ImGui::LabelText("Vertex array objects", "%i (%i layouts)", r->vertexArrayCache->getVertexArrayCount(), r->vertexArrayCache->getLayoutCount());
+            }
+        }
+        if (ImGui::CollapsingHeader("Resource cache")){
+            ImGui::LabelText("Resources", "%i", ResourceCache::getEntryCount());
+            ImGui::LabelText("Hits / misses", "%i / %i", ResourceCache::getHits(), ResourceCache::getMisses());
+            ImGui::LabelText("Retained", "%.2f / %.2f MB", ResourceCache::getRetainedBytes()/(1000*1000.0f), ResourceCache::getBudget()/(1000*1000.0f));
+            if (ImGui::Button("Purge")){
+                ResourceCache::purge();
+            }
+        }
+        if (!r->geometryArenas.empty()){
+            if (ImGui::CollapsingHeader("Geometry arenas")){
+                for (auto& arena : r->geometryArenas){
+                    std::string s = "Arena "+std::to_string(arena.second->id);
+                    if (ImGui::TreeNode(s.c_str())){
+                        ImGui::LabelText("Meshes", "%i", arena.second->getMeshCount());
+                        ImGui::LabelText("Vertices", "%i / %i", arena.second->getVerticesUsed(), arena.second->getVertexCapacity());
+                        ImGui::LabelText("Indices", "%i / %i", arena.second->getIndicesUsed(), arena.second->getIndexCapacity());
+                        ImGui::LabelText("Size", "%.2f MB", arena.second->getDataSize()/(1000*1000.0f));
+                        if (ImGui::Button("Defragment")){
+                            arena.second->defragment();
+                        }
+                        ImGui::TreePop();
+                    }
+                }
             }
         }
         if (!r->spriteAtlases.empty()){
@@ -927,7 +1016,7 @@ namespace sre {
                 auto tex = sprite.texture;
                 auto uv0 = ImVec2((sprite.getSpritePos().x)/(float)tex->getWidth(), (sprite.getSpritePos().y+sprite.getSpriteSize().y)/(float)tex->getHeight());
                 auto uv1 = ImVec2((sprite.getSpritePos().x+sprite.getSpriteSize().x)/(float)tex->getWidth(),(sprite.getSpritePos().y)/(float)tex->getHeight());
-                ImGui::Image(reinterpret_cast<ImTextureID>(tex->textureId), ImVec2(previewSize/sprite.getSpriteSize().y*(float)sprite.getSpriteSize().x, previewSize),uv0, uv1,{1,1,1,1},{0,0,0,1});
+                ImGui::Image(reinterpret_cast<ImTextureID>(tex->getNativeTextureId()), ImVec2(previewSize/sprite.getSpriteSize().y*(float)sprite.getSpriteSize().x, previewSize),uv0, uv1,{1,1,1,1},{0,0,0,1});
             }
 
             ImGui::TreePop();
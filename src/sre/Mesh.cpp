@@ -13,16 +13,273 @@
 #include <iostream>
 #include <glm/gtx/string_cast.hpp>
 #include <iomanip>
+#include <cstring>
+#include <cmath>
 #include "sre/Renderer.hpp"
 #include "sre/Shader.hpp"
 #include "sre/Log.hpp"
+#include "sre/MeshOptimizer.hpp"
+#include "sre/MeshCodec.hpp"
+#include "sre/impl/ParallelFor.hpp"
+#include "sre/impl/GeometryArena.hpp"
+#include "sre/impl/VertexArrayCache.hpp"
+#include "sre/impl/MappedFile.hpp"
+#include "sre/impl/VertexWelder.hpp"
+#include "sre/impl/Simd.hpp"
+#include <fstream>
+#include <mutex>
+#include <cstdint>
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
+namespace {
+    // .sremesh binary format (little endian):
+    // header: magic, version, flags, vertexCount, bytesPerVertex, attributeCount, indexSetCount, lodCount,
+    //         elementCount, bounds (6 floats), name
+    // attributes: name, offset, elementCount, dataType, attributeType
+    // topologies: count, topology per index set (or a single topology if the mesh has no indices)
+    // index sets: byte offset, count
+    // lods: ratio, screenSize, (byte offset, count) per index set
+    // padding to 16 bytes followed by interleaved vertex data and element buffer data (uint16)
+    // if compressed: encoded vertex data size, encoded element data size followed by the data (see MeshCodec)
+    const char sreMeshMagic[8] = {'S','R','E','M','E','S','H','\0'};
+    const uint32_t sreMeshVersion = 2;                              // version 1 has no flags
+    const uint32_t sreMeshFlagCompressed = 1;
+
+    class BinaryWriter {
+    public:
+        template<typename T>
+        void write(T value){
+            data.append((const char*)&value, sizeof(T));
+        }
+        void writeString(const std::string& s){
+            write((uint32_t)s.size());
+            data.append(s);
+        }
+        void pad(size_t alignment){
+            while (data.size() % alignment != 0){
+                data.push_back(0);
+            }
+        }
+        std::string data;
+    };
+
+    class BinaryReader {
+    public:
+        BinaryReader(const char* data, size_t size)
+        :data(data), size(size)
+        {
+        }
+        template<typename T>
+        T read(){
+            T value{};
+            if (!ok || pos + sizeof(T) > size){
+                ok = false;
+                return value;
+            }
+            memcpy(&value, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+        std::string readString(){
+            uint32_t length = read<uint32_t>();
+            const char* s = skip(length);
+            return s ? std::string(s, length) : std::string();
+        }
+        const char* skip(size_t bytes){                            // returns pointer to skipped bytes (nullptr if out of bounds)
+            if (!ok || bytes > size - pos){
+                ok = false;
+                return nullptr;
+            }
+            const char* res = data + pos;
+            pos += bytes;
+            return res;
+        }
+        void align(size_t alignment){
+            if (pos % alignment != 0){
+                skip(alignment - pos % alignment);
+            }
+        }
+        bool ok = true;
+    private:
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+    };
+
+    // copy a single attribute out of interleaved vertex data
+    template<typename T>
+    std::vector<T> extractAttribute(const std::vector<float>& interleavedData, int vertexCount, int bytesPerVertex, int offset){
+        std::vector<T> res;
+        if (interleavedData.empty()){
+            return res;
+        }
+        const char * dataPtr = (const char*) interleavedData.data();
+        res.resize(vertexCount);
+        for (int i=0;i<vertexCount;i++){
+            memcpy(&res[i], dataPtr + bytesPerVertex * i + offset, sizeof(T));
+        }
+        return res;
+    }
+
+    const size_t parallelMeshBlockSize = 16384;                 // vertices per block when interleaving or computing bounds in parallel
+
+    struct AttributeStream {
+        const char* data;
+        size_t count;
+        size_t elementSize;
+        int offset;
+    };
+
+    // copy vertices [begin;end) of a single attribute into the interleaved buffer
+    void interleaveAttribute(const AttributeStream& stream, char* dst, int stride, size_t begin, size_t end){
+        end = std::min(end, stream.count);
+        if (begin >= end){
+            return;
+        }
+        dst += stream.offset;
+        size_t i = begin;
+#ifdef SRE_SSE2
+        switch (stream.elementSize){
+            case 16:
+                for (;i<end;i++){
+                    _mm_storeu_si128((__m128i*)(dst + stride*i), _mm_loadu_si128((const __m128i*)(stream.data + 16*i)));
+                }
+                break;
+            case 12: {
+                // load four floats (reading into the next element) and clear the padding
+                const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+                size_t last = end == stream.count ? end - 1 : end;
+                for (;i<last;i++){
+                    __m128 v = _mm_and_ps(_mm_loadu_ps((const float*)(stream.data + 12*i)), mask);
+                    _mm_storeu_ps((float*)(dst + stride*i), v);
+                }
+                break;
+            }
+            case 8:
+                for (;i<end;i++){
+                    _mm_storel_epi64((__m128i*)(dst + stride*i), _mm_loadl_epi64((const __m128i*)(stream.data + 8*i)));
+                }
+                break;
+            default:
+                break;
+        }
+#endif
+        for (;i<end;i++){
+            memcpy(dst + stride*i, stream.data + stream.elementSize*i, stream.elementSize);
+        }
+    }
+
+    // min/max of positions [begin;end)
+    std::array<glm::vec3,2> computeBounds(const glm::vec3* positions, size_t count, size_t begin, size_t end){
+        std::array<glm::vec3,2> res = {glm::vec3{std::numeric_limits<float>::max()}, glm::vec3{-std::numeric_limits<float>::max()}};
+        size_t i = begin;
+#ifdef SRE_SSE2
+        if (begin < end){
+            __m128 minV = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 maxV = _mm_set1_ps(-std::numeric_limits<float>::max());
+            size_t last = end == count ? end - 1 : end;      // the last vec3 cannot be loaded as four floats
+            for (;i<last;i++){
+                __m128 v = _mm_loadu_ps((const float*)(positions + i));
+                minV = _mm_min_ps(minV, v);
+                maxV = _mm_max_ps(maxV, v);
+            }
+            float minF[4], maxF[4];
+            _mm_storeu_ps(minF, minV);
+            _mm_storeu_ps(maxF, maxV);
+            res[0] = glm::vec3(minF[0], minF[1], minF[2]);
+            res[1] = glm::vec3(maxF[0], maxF[1], maxF[2]);
+        }
+#endif
+        for (;i<end;i++){
+            res[0] = glm::min(res[0], positions[i]);
+            res[1] = glm::max(res[1], positions[i]);
+        }
+        return res;
+    }
+
+    // move each vertex i to remap[i]. Used both for vertex deduplication and for vertex fetch reordering. When several
+    // vertices map to the same index, the first one is kept (iterating backwards)
+    template<typename T>
+    void remapAttributes(std::map<std::string,std::vector<T>>& attributes, const std::vector<uint16_t>& remap, int newVertexCount){
+        for (auto& attribute : attributes){
+            std::vector<T> remapped(newVertexCount);
+            for (size_t i=std::min(attribute.second.size(), remap.size());i-- > 0;){
+                remapped[remap[i]] = attribute.second[i];
+            }
+            attribute.second = std::move(remapped);
+        }
+    }
+
+    template<typename T>
+    int getKeyWords(const std::map<std::string,std::vector<T>>& attributes, int vertexCount){
+        int res = 0;
+        for (auto& attribute : attributes){
+            if ((int)attribute.second.size() >= vertexCount){
+                res += sizeof(T) / sizeof(uint32_t);
+            }
+        }
+        return res;
+    }
+
+    inline uint32_t weldKey(float value, float epsilon){
+        if (epsilon > 0){
+            return (uint32_t)(int32_t)std::floor(value / epsilon + 0.5f);   // quantize to a grid of size epsilon
+        }
+        if (value == 0){
+            value = 0;                                                      // -0 equals 0
+        }
+        uint32_t res;
+        memcpy(&res, &value, sizeof(uint32_t));
+        return res;
+    }
+
+    inline uint32_t weldKey(int32_t value, float){
+        return (uint32_t)value;
+    }
+
+    inline const float* components(const float& value){
+        return &value;
+    }
+
+    inline const float* components(const glm::vec2& value){
+        return &value.x;
+    }
+
+    inline const float* components(const glm::vec3& value){
+        return &value.x;
+    }
+
+    inline const float* components(const glm::vec4& value){
+        return &value.x;
+    }
+
+    inline const int32_t* components(const glm::i32vec4& value){
+        return &value.x;
+    }
+
+    // the epsilon only applies to positions. Other attributes (normals, uvs, colors, ...) are compared exactly
+    template<typename T>
+    uint32_t* appendVertexKey(const std::map<std::string,std::vector<T>>& attributes, int vertex, int vertexCount, float epsilon, uint32_t* key){
+        for (auto& attribute : attributes){
+            if ((int)attribute.second.size() >= vertexCount){
+                auto values = components(attribute.second[vertex]);
+                float attributeEpsilon = attribute.first == "position" ? epsilon : 0;
+                for (int i=0;i<(int)(sizeof(T) / sizeof(uint32_t));i++){
+                    *key++ = weldKey(values[i], attributeEpsilon);
+                }
+            }
+        }
+        return key;
+    }
+
+
+}
+
 namespace sre {
     uint16_t Mesh::meshIdCount = 0;
 
-    Mesh::Mesh(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name,RenderStats& renderStats)
+    Mesh::Mesh(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology, std::string name,RenderStats& renderStats, bool keepCPUData, std::vector<float> lodRatios, bool useGeometryArena)
     {
         meshId = meshIdCount++;
         if ( Renderer::instance == nullptr){
@@ -37,7 +294,19 @@ namespace sre {
                std::move(indices),
                meshTopology,
                name,
-               renderStats);
+               renderStats,
+               keepCPUData,
+               std::move(lodRatios),
+               useGeometryArena);
+        Renderer::instance->meshes.emplace_back(this);
+    }
+
+    Mesh::Mesh() {
+        meshId = meshIdCount++;
+        if ( Renderer::instance == nullptr){
+            LOG_FATAL("Cannot instantiate sre::Mesh before sre::Renderer is created.");
+        }
+        glGenBuffers(1, &vertexBufferId);
         Renderer::instance->meshes.emplace_back(this);
     }
 
@@ -52,35 +321,18 @@ namespace sre {
             r->meshes.erase(std::remove(r->meshes.begin(), r->meshes.end(), this));
         }
 
-        if (renderInfo().graphicsAPIVersionMajor >= 3) {
-            for (auto arrayObj : shaderToVertexArrayObject) {
-                glDeleteVertexArrays(1, &(arrayObj.second.vaoID));
-            }
-        }
         glDeleteBuffers(1, &vertexBufferId);
         if (elementBufferId != 0){
             glDeleteBuffers(1, &elementBufferId);
         }
+        if (geometryArena){
+            geometryArena->free(this);
+        }
     }
 
     void Mesh::bind(Shader* shader) {
         if (renderInfo().graphicsAPIVersionMajor >= 3) {
-            auto res = shaderToVertexArrayObject.find(shader->shaderProgramId);
-            if (res != shaderToVertexArrayObject.end() && res->second.shaderId == shader->shaderUniqueId) {
-                GLuint vao = res->second.vaoID;
-                glBindVertexArray(vao);
-            } else {
-                GLuint index;
-                if (res != shaderToVertexArrayObject.end()){
-                    index = res->second.vaoID;
-                } else {
-                    glGenVertexArrays(1, &index);
-                }
-                glBindVertexArray(index);
-                setVertexAttributePointers(shader);
-                shaderToVertexArrayObject[shader->shaderProgramId] = {shader->shaderUniqueId, index};
-                bindIndexSet();
-            }
+            Renderer::instance->vertexArrayCache->bind(this, shader);
         } else {
             setVertexAttributePointers(shader);
             bindIndexSet();
@@ -98,7 +350,11 @@ namespace sre {
         return vertexCount;
     }
 
-    void Mesh::update(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats) {
+    void Mesh::update(std::map<std::string,std::vector<float>>&& attributesFloat,std::map<std::string,std::vector<glm::vec2>>&& attributesVec2, std::map<std::string,std::vector<glm::vec3>>&& attributesVec3,std::map<std::string,std::vector<glm::vec4>>&& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>&& attributesIVec4, std::vector<std::vector<uint16_t>> &&indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats, bool keepCPUData, std::vector<float> lodRatios, bool useGeometryArena) {
+        if (geometryArena){
+            geometryArena->free(this);
+            geometryArena.reset();
+        }
         this->meshTopology = meshTopology;
         this->name = name;
         meshId = meshIdCount++;
@@ -106,14 +362,9 @@ namespace sre {
         vertexCount = 0;
         dataSize = 0;
 
-        if (renderInfo().graphicsAPIVersionMajor >= 3) {
-            for (auto arrayObj : shaderToVertexArrayObject){
-                glDeleteVertexArrays(1, &(arrayObj.second.vaoID));
-            }
-            shaderToVertexArrayObject.clear();
-        }
         attributeByName.clear();
 
+        this->keepCPUData     = true;
         this->indices         = std::move(indices);
         this->attributesFloat = std::move(attributesFloat);
         this->attributesVec2  = std::move(attributesVec2);
@@ -122,28 +373,23 @@ namespace sre {
         this->attributesIVec4 = std::move(attributesIVec4);
 
         auto interleavedData = getInterleavedData();
+        layoutId = Renderer::instance->vertexArrayCache->getLayoutId(getLayoutKey());
 
-        if (renderInfo().graphicsAPIVersionMajor >= 3) {
-            glBindVertexArray(0);
-        }
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(float)*interleavedData.size(), interleavedData.data(), GL_STATIC_DRAW);
-
+        // level of details are stored after the index sets in the same element buffer
         elementBufferOffsetCount.clear();
-        if (this->indices.empty()){
-            if (elementBufferId != 0){
-                glDeleteBuffers(1, &elementBufferId);
-                elementBufferId = 0;
-            }
-        } else {
-            if (elementBufferId == 0){
-                glGenBuffers(1, &elementBufferId);
-            }
+        lods.clear();
+        std::vector<uint16_t> concatenatedIndices;
+        if (!this->indices.empty()){
+            std::vector<std::vector<std::vector<uint16_t>>> lodIndices = generateLODs(lodRatios);
             size_t totalCount = 0;
             for (int i=0;i<this->indices.size();i++) {
                 totalCount += this->indices[i].size();
             }
-            std::vector<uint16_t> concatenatedIndices;
+            for (auto& lod : lodIndices){
+                for (auto& lodIndexSet : lod){
+                    totalCount += lodIndexSet.size();
+                }
+            }
             concatenatedIndices.reserve(totalCount);
             int offset = 0;
             for (int i=0;i<this->indices.size();i++) {
@@ -152,29 +398,92 @@ namespace sre {
                 elementBufferOffsetCount.emplace_back(offset, this->indices[i].size());
                 offset += dataSize;
             }
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, offset, concatenatedIndices.data(), GL_STATIC_DRAW);
-
-            this->dataSize += offset;
+            for (int l=0;l<lodIndices.size();l++){
+                LOD lod;
+                lod.ratio = lodRatios[l];
+                lod.screenSize = 0.5f * sqrt(lodRatios[l]);    // keeps the triangle density on screen roughly constant
+                for (int i=0;i<lodIndices[l].size();i++){
+                    if (lodIndices[l][i].empty()){
+                        lod.elementBufferOffsetCount.push_back(elementBufferOffsetCount[i]); // not simplified - use the full index set
+                        continue;
+                    }
+                    size_t dataSize = lodIndices[l][i].size()*sizeof(uint16_t);
+                    concatenatedIndices.insert(concatenatedIndices.end(), lodIndices[l][i].begin(), lodIndices[l][i].end());
+                    lod.elementBufferOffsetCount.emplace_back(offset, lodIndices[l][i].size());
+                    offset += dataSize;
+                }
+                lods.push_back(std::move(lod));
+            }
         }
 
+        upload(interleavedData.data(), concatenatedIndices.data(), (int)concatenatedIndices.size(), useGeometryArena);
+
         boundsMinMax[0] = glm::vec3{std::numeric_limits<float>::max()};
         boundsMinMax[1] = glm::vec3{-std::numeric_limits<float>::max()};
         auto pos = this->attributesVec3.find("position");
         if (pos != this->attributesVec3.end()){
-            for (auto v : pos->second){
-                boundsMinMax[0] = glm::min(boundsMinMax[0], v);
-                boundsMinMax[1] = glm::max(boundsMinMax[1], v);
-            }
+            std::mutex boundsMutex;
+            const glm::vec3* positions = pos->second.data();
+            size_t count = pos->second.size();
+            parallelFor(count, parallelMeshBlockSize, [&](size_t begin, size_t end){
+                auto blockBounds = computeBounds(positions, count, begin, end);
+                std::lock_guard<std::mutex> lock(boundsMutex);
+                boundsMinMax[0] = glm::min(boundsMinMax[0], blockBounds[0]);
+                boundsMinMax[1] = glm::max(boundsMinMax[1], blockBounds[1]);
+            });
         }
         dataSize = totalBytesPerVertex * vertexCount;
 
         renderStats.meshBytes += dataSize;
         renderStats.meshBytesAllocated += dataSize;
+
+        if (!keepCPUData){
+            // release CPU copies (attribute layout, index counts and bounds are kept)
+            this->keepCPUData = false;
+            std::vector<std::vector<uint16_t>>().swap(this->indices);
+            std::map<std::string,std::vector<float>>().swap(this->attributesFloat);
+            std::map<std::string,std::vector<glm::vec2>>().swap(this->attributesVec2);
+            std::map<std::string,std::vector<glm::vec3>>().swap(this->attributesVec3);
+            std::map<std::string,std::vector<glm::vec4>>().swap(this->attributesVec4);
+            std::map<std::string,std::vector<glm::i32vec4>>().swap(this->attributesIVec4);
+        }
+    }
+
+    void Mesh::upload(const void *vertexData, const uint16_t *indexData, int indexCount, bool useGeometryArena) {
+        if (renderInfo().graphicsAPIVersionMajor >= 3) {
+            glBindVertexArray(0);
+        }
+        if (useGeometryArena && GeometryArena::isSupported() && vertexCount > 0){
+            geometryArena = GeometryArena::get(getLayoutKey(), totalBytesPerVertex);
+            geometryArena->allocate(this, vertexData, vertexCount, indexData, indexCount);
+            // release the mesh buffers
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+            glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+            if (elementBufferId != 0){
+                glDeleteBuffers(1, &elementBufferId);
+                elementBufferId = 0;
+            }
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCount*totalBytesPerVertex, vertexData, GL_STATIC_DRAW);
+
+            if (indexCount == 0){
+                if (elementBufferId != 0){
+                    glDeleteBuffers(1, &elementBufferId);
+                    elementBufferId = 0;
+                }
+            } else {
+                if (elementBufferId == 0){
+                    glGenBuffers(1, &elementBufferId);
+                }
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferId);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount*sizeof(uint16_t), indexData, GL_STATIC_DRAW);
+            }
+        }
     }
 
-    void Mesh::setVertexAttributePointers(Shader* shader) {
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+    void Mesh::setVertexAttributePointers(Shader* shader, std::vector<VertexAttributePointer>* pointers) {
+        glBindBuffer(GL_ARRAY_BUFFER, geometryArena ? geometryArena->vertexBufferId : vertexBufferId);
         int vertexAttribArray = 0;
         for (auto shaderAttribute : shader->attributes) {
             auto meshAttribute = attributeByName.find(shaderAttribute.first);
@@ -189,7 +498,11 @@ namespace sre {
                                                      );
             if (attributeFoundInMesh &&  equalType && shaderAttribute.second.arraySize == 1) {
 				glEnableVertexAttribArray(shaderAttribute.second.position);
-                if ((shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)){
+                bool integer = shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType;
+                if (pointers){
+                    pointers->push_back({(unsigned int)shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, integer, meshAttribute->second.offset});
+                }
+                if (integer){
                     glVertexAttribIPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
                 } else {
                     glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, GL_FALSE, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
@@ -225,71 +538,93 @@ namespace sre {
     }
 
     std::vector<glm::vec3> Mesh::getPositions() {
-        std::vector<glm::vec3> res;
-        auto ref = attributesVec3.find("position");
-        if (ref != attributesVec3.end()){
-            res = ref->second;
-        }
-        return res;
+        return readAttribute("position", attributesVec3);
     }
 
     std::vector<glm::vec3> Mesh::getNormals() {
-        std::vector<glm::vec3> res;
-        auto ref = attributesVec3.find("normal");
-        if (ref != attributesVec3.end()){
-            res = ref->second;
-        }
-        return res;
+        return readAttribute("normal", attributesVec3);
     }
 
     std::vector<glm::vec4> Mesh::getUVs() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("uv");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
-        }
-        return res;
+        return readAttribute("uv", attributesVec4);
     }
 
     const std::vector<uint16_t>& Mesh::getIndices(int indexSet) {
+        if (!checkCPUData("indices")){
+            static std::vector<uint16_t> empty;
+            return empty;
+        }
         return indices.at(indexSet);
     }
 
     Mesh::MeshBuilder Mesh::update() {
         Mesh::MeshBuilder res;
         res.updateMesh = this;
-
-        res.attributesFloat = attributesFloat;
-        res.attributesVec2 = attributesVec2;
-        res.attributesVec3 = attributesVec3;
-        res.attributesVec4 = attributesVec4;
-        res.attributesIVec4 = attributesIVec4;
-
-        res.indices = indices;
+        res.keepCPUData = keepCPUData;
         res.meshTopology = meshTopology;
+        for (auto& lod : lods){
+            res.lodRatios.push_back(lod.ratio);
+        }
+        res.meshletMaxVertices = meshletMaxVertices;
+        res.meshletMaxTriangles = meshletMaxTriangles;
+        res.useGeometryArena = geometryArena != nullptr;
+
+        if (keepCPUData){
+            res.attributesFloat = attributesFloat;
+            res.attributesVec2 = attributesVec2;
+            res.attributesVec3 = attributesVec3;
+            res.attributesVec4 = attributesVec4;
+            res.attributesIVec4 = attributesIVec4;
+
+            res.indices = indices;
+            return res;
+        }
+
+        // CPU data released: restore the mesh data from the GPU
+        auto interleavedData = readInterleavedData();
+        for (auto & a : attributeByName){
+            int offset = a.second.offset;
+            switch (a.second.attributeType){
+                case GL_FLOAT:
+                    res.attributesFloat[a.first] = extractAttribute<float>(interleavedData, vertexCount, totalBytesPerVertex, offset);
+                    break;
+                case GL_FLOAT_VEC2:
+                    res.attributesVec2[a.first] = extractAttribute<glm::vec2>(interleavedData, vertexCount, totalBytesPerVertex, offset);
+                    break;
+                case GL_FLOAT_VEC3:
+                    res.attributesVec3[a.first] = extractAttribute<glm::vec3>(interleavedData, vertexCount, totalBytesPerVertex, offset);
+                    break;
+                case GL_FLOAT_VEC4:
+                    res.attributesVec4[a.first] = extractAttribute<glm::vec4>(interleavedData, vertexCount, totalBytesPerVertex, offset);
+                    break;
+                case GL_INT_VEC4:
+                    res.attributesIVec4[a.first] = extractAttribute<glm::i32vec4>(interleavedData, vertexCount, totalBytesPerVertex, offset);
+                    break;
+                default:
+                    LOG_ERROR("Unhandled attribute type: %i",a.second.attributeType);
+                    break;
+            }
+        }
+        for (int i=0;i<getIndexSets();i++){
+            res.indices.push_back(readIndices(i));
+        }
         return res;
     }
 
+    void Mesh::weld(float epsilon) {
+        update().withWeld(epsilon).build();
+    }
+
     Mesh::MeshBuilder Mesh::create() {
         return Mesh::MeshBuilder();
     }
 
     std::vector<glm::vec4> Mesh::getColors() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("color");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
-        }
-        return res;
+        return readAttribute("color", attributesVec4);
     }
 
     std::vector<float> Mesh::getParticleSizes() {
-        std::vector<float> res;
-        auto ref = attributesFloat.find("particleSize");
-        if (ref != attributesFloat.end()){
-            res = ref->second;
-        }
-        return res;
+        return readAttribute("particleSize", attributesFloat);
     }
 
     int Mesh::getDataSize() {
@@ -317,7 +652,7 @@ namespace sre {
     }
 
     int Mesh::getIndexSets() {
-        return indices.size();
+        return (int)elementBufferOffsetCount.size();
     }
 
     const std::string& Mesh::getName() {
@@ -325,19 +660,92 @@ namespace sre {
     }
 
     int Mesh::getIndicesSize(int indexSet) {
-        return indices.at(indexSet).size();
+        return elementBufferOffsetCount.at(indexSet).second;
     }
 
-    std::vector<glm::vec4> Mesh::getTangents() {
-        std::vector<glm::vec4> res;
-        auto ref = attributesVec4.find("tangent");
-        if (ref != attributesVec4.end()){
-            res = ref->second;
+    int Mesh::getLODCount() {
+        return (int)lods.size();
+    }
+
+    int Mesh::getLODIndicesSize(int lod, int indexSet) {
+        return lods.at(lod).elementBufferOffsetCount.at(indexSet).second;
+    }
+
+    bool Mesh::isInGeometryArena() {
+        return geometryArena != nullptr;
+    }
+
+    std::string Mesh::getLayoutKey() {
+        std::stringstream ss;
+        for (auto& a : attributeByName){
+            ss << a.first << ':' << a.second.offset << ':' << a.second.attributeType << ';';
+        }
+        ss << totalBytesPerVertex;
+        return ss.str();
+    }
+
+    int64_t Mesh::getBindKey() {
+        if (geometryArena){
+            return 0x10000 + geometryArena->id;                    // after the range of mesh ids
+        }
+        return meshId;
+    }
+
+    int Mesh::getIndexByteOffset() {
+        return arenaIndexOffset * (int)sizeof(uint16_t);
+    }
+
+    int Mesh::getMeshletCount(int indexSet) {
+        if (indexSet >= meshlets.size()){
+            return 0;
+        }
+        return (int)meshlets[indexSet].size();
+    }
+
+    float Mesh::getLODScreenSize(int lod) {
+        return lods.at(lod).screenSize;
+    }
+
+    int Mesh::selectLOD(float projectedSize) {
+        int res = -1;
+        for (int i=0;i<lods.size();i++){
+            if (projectedSize < lods[i].screenSize){
+                res = i;
+            }
+        }
+        return res;
+    }
+
+    std::vector<std::vector<std::vector<uint16_t>>> Mesh::generateLODs(const std::vector<float>& lodRatios) {
+        std::vector<std::vector<std::vector<uint16_t>>> res;
+        auto pos = attributesVec3.find("position");
+        if (lodRatios.empty() || pos == attributesVec3.end()){
+            return res;
+        }
+        for (auto ratio : lodRatios){
+            std::vector<std::vector<uint16_t>> lod(indices.size());
+            for (int i=0;i<indices.size();i++){
+                if (meshTopology[i] != MeshTopology::Triangles){
+                    continue;
+                }
+                // simplify from the previous LOD (same result, but faster)
+                auto& source = res.empty() || res.back()[i].empty() ? indices[i] : res.back()[i];
+                int targetIndexCount = (int)(indices[i].size() * ratio);
+                lod[i] = MeshOptimizer::optimizeVertexCache(MeshOptimizer::simplify(source, pos->second, targetIndexCount), vertexCount);
+            }
+            res.push_back(std::move(lod));
         }
         return res;
     }
 
+    std::vector<glm::vec4> Mesh::getTangents() {
+        return readAttribute("tangent", attributesVec4);
+    }
+
     std::vector<float> Mesh::getInterleavedData() {
+        if (!keepCPUData){
+            return readInterleavedData();
+        }
         totalBytesPerVertex = 0;
         std::vector<int> offset;
         // enforced std140 layout rules ( https://learnopengl.com/#!Advanced-OpenGL/Advanced-GLSL )
@@ -377,47 +785,94 @@ namespace sre {
             totalBytesPerVertex += sizeof(float)*4 - totalBytesPerVertex%(sizeof(float)*4);
         }
         std::vector<float> interleavedData((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
-        const char * dataPtr = (char*) interleavedData.data();
+        char * dataPtr = (char*) interleavedData.data();
 
         // add data (copy each element into interleaved buffer)
+        std::vector<AttributeStream> streams;
         for (auto & pair : attributesVec3){
-            auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++){
-                glm::vec3 * locationPtr = (glm::vec3 *) (dataPtr + (totalBytesPerVertex * i) + offsetBytes.offset);
-                *locationPtr = pair.second[i];
-            }
+            streams.push_back({(const char*)pair.second.data(), pair.second.size(), sizeof(glm::vec3), attributeByName[pair.first].offset});
         }
         for (auto & pair : attributesVec4){
-            auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::vec4 * locationPtr = (glm::vec4 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
-                *locationPtr = pair.second[i];
-            }
+            streams.push_back({(const char*)pair.second.data(), pair.second.size(), sizeof(glm::vec4), attributeByName[pair.first].offset});
         }
         for (auto & pair : attributesIVec4){
-            auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::i32vec4 * locationPtr = (glm::i32vec4 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
-                *locationPtr = pair.second[i];
-            }
+            streams.push_back({(const char*)pair.second.data(), pair.second.size(), sizeof(glm::i32vec4), attributeByName[pair.first].offset});
         }
         for (auto & pair : attributesVec2){
-            auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                glm::vec2 * locationPtr = (glm::vec2 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
-                *locationPtr = pair.second[i];
-            }
+            streams.push_back({(const char*)pair.second.data(), pair.second.size(), sizeof(glm::vec2), attributeByName[pair.first].offset});
         }
         for (auto & pair : attributesFloat){
-            auto& offsetBytes = attributeByName[pair.first];
-            for (int i=0;i<pair.second.size();i++) {
-                float * locationPtr = (float *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
-                *locationPtr = pair.second[i];
-            }
+            streams.push_back({(const char*)pair.second.data(), pair.second.size(), sizeof(float), attributeByName[pair.first].offset});
         }
+        int stride = totalBytesPerVertex;
+        parallelFor(vertexCount, parallelMeshBlockSize, [&](size_t begin, size_t end){
+            for (auto& stream : streams){
+                interleaveAttribute(stream, dataPtr, stride, begin, end);
+            }
+        });
         return interleavedData;
     }
 
+    std::vector<float> Mesh::readInterleavedData() {
+        std::vector<float> res((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
+#ifdef EMSCRIPTEN
+        LOG_ERROR("Reading mesh data from the GPU is not supported on WebGL. Mesh %s", name.c_str());
+#else
+        if (geometryArena){
+            glBindBuffer(GL_ARRAY_BUFFER, geometryArena->vertexBufferId);
+            glGetBufferSubData(GL_ARRAY_BUFFER, (GLintptr)arenaVertexOffset*totalBytesPerVertex, sizeof(float)*res.size(), res.data());
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+            glGetBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float)*res.size(), res.data());
+        }
+#endif
+        return res;
+    }
+
+    std::vector<uint16_t> Mesh::readIndices(int indexSet) {
+        auto offsetCount = elementBufferOffsetCount.at(indexSet);
+        std::vector<uint16_t> res(offsetCount.second, 0);
+#ifdef EMSCRIPTEN
+        LOG_ERROR("Reading mesh data from the GPU is not supported on WebGL. Mesh %s", name.c_str());
+#else
+        if (renderInfo().graphicsAPIVersionMajor >= 3) {
+            glBindVertexArray(0);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometryArena ? geometryArena->elementBufferId : elementBufferId);
+        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, getIndexByteOffset() + offsetCount.first, sizeof(uint16_t)*res.size(), res.data());
+#endif
+        return res;
+    }
+
+    template<typename T>
+    std::vector<T> Mesh::readAttribute(const std::string& name, std::map<std::string,std::vector<T>>& attributes) {
+        std::vector<T> res;
+        if (keepCPUData){
+            auto ref = attributes.find(name);
+            if (ref != attributes.end()){
+                res = ref->second;
+            }
+            return res;
+        }
+        auto attribute = attributeByName.find(name);
+        if (attribute == attributeByName.end() || attribute->second.elementCount*sizeof(float) != sizeof(T)){
+            return res;
+        }
+        return extractAttribute<T>(readInterleavedData(), vertexCount, totalBytesPerVertex, attribute->second.offset);
+    }
+
+    bool Mesh::checkCPUData(const std::string& name) {
+        if (!keepCPUData){
+            LOG_ERROR("Cannot access %s of mesh %s. The CPU data has been released (see MeshBuilder::withKeepCPUData()).", name.c_str(), this->name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool Mesh::isKeepCPUData() {
+        return keepCPUData;
+    }
+
     void Mesh::setBoundsMinMax(const std::array<glm::vec3,2>& minMax) {
         boundsMinMax = minMax;
     }
@@ -426,6 +881,251 @@ namespace sre {
         return attributeByName.find(name) != attributeByName.end();
     }
 
+    std::vector<uint16_t> Mesh::getElementBufferData() {
+        int elementCount = 0;
+        for (auto& offsetCount : elementBufferOffsetCount){
+            elementCount = std::max(elementCount, offsetCount.first/(int)sizeof(uint16_t) + offsetCount.second);
+        }
+        for (auto& lod : lods){
+            for (auto& offsetCount : lod.elementBufferOffsetCount){
+                elementCount = std::max(elementCount, offsetCount.first/(int)sizeof(uint16_t) + offsetCount.second);
+            }
+        }
+        std::vector<uint16_t> res;
+        if (keepCPUData && lods.empty()){
+            res.reserve(elementCount);
+            for (auto& indexSet : indices){
+                res.insert(res.end(), indexSet.begin(), indexSet.end());
+            }
+            return res;
+        }
+        res.resize(elementCount, 0);
+#ifdef EMSCRIPTEN
+        LOG_ERROR("Reading mesh data from the GPU is not supported on WebGL. Mesh %s", name.c_str());
+#else
+        if (elementCount > 0){
+            if (renderInfo().graphicsAPIVersionMajor >= 3) {
+                glBindVertexArray(0);
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometryArena ? geometryArena->elementBufferId : elementBufferId);
+            glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, getIndexByteOffset(), sizeof(uint16_t)*res.size(), res.data());
+        }
+#endif
+        return res;
+    }
+
+    bool Mesh::saveBinary(const std::string &filename, bool compress) {
+        auto vertexData = getInterleavedData();
+        auto elementData = getElementBufferData();
+
+        BinaryWriter writer;
+        writer.data.append(sreMeshMagic, sizeof(sreMeshMagic));
+        writer.write(sreMeshVersion);
+        writer.write(compress ? sreMeshFlagCompressed : 0u);
+        writer.write((uint32_t)vertexCount);
+        writer.write((uint32_t)totalBytesPerVertex);
+        writer.write((uint32_t)attributeByName.size());
+        writer.write((uint32_t)elementBufferOffsetCount.size());
+        writer.write((uint32_t)lods.size());
+        writer.write((uint32_t)elementData.size());
+        for (int i=0;i<2;i++){
+            for (int j=0;j<3;j++){
+                writer.write(boundsMinMax[i][j]);
+            }
+        }
+        writer.writeString(name);
+        for (auto& attribute : attributeByName){
+            writer.writeString(attribute.first);
+            writer.write((int32_t)attribute.second.offset);
+            writer.write((int32_t)attribute.second.elementCount);
+            writer.write((int32_t)attribute.second.dataType);
+            writer.write((int32_t)attribute.second.attributeType);
+        }
+        writer.write((uint32_t)meshTopology.size());
+        for (auto topology : meshTopology){
+            writer.write((uint32_t)topology);
+        }
+        for (int i=0;i<elementBufferOffsetCount.size();i++){
+            writer.write((uint32_t)elementBufferOffsetCount[i].first);
+            writer.write((uint32_t)elementBufferOffsetCount[i].second);
+        }
+        for (auto& lod : lods){
+            writer.write(lod.ratio);
+            writer.write(lod.screenSize);
+            for (auto& offsetCount : lod.elementBufferOffsetCount){
+                writer.write((uint32_t)offsetCount.first);
+                writer.write((uint32_t)offsetCount.second);
+            }
+        }
+        writer.pad(16);
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file){
+            LOG_ERROR("Cannot write mesh file %s", filename.c_str());
+            return false;
+        }
+        file.write(writer.data.data(), writer.data.size());
+        if (compress){
+            auto encodedVertices = MeshCodec::encodeVertexBuffer(vertexData.data(), vertexCount, totalBytesPerVertex);
+            auto encodedIndices = MeshCodec::encodeIndexBuffer(elementData.data(), (int)elementData.size());
+            BinaryWriter sizes;
+            sizes.write((uint32_t)encodedVertices.size());
+            sizes.write((uint32_t)encodedIndices.size());
+            file.write(sizes.data.data(), sizes.data.size());
+            file.write((const char*)encodedVertices.data(), (std::streamsize)encodedVertices.size());
+            file.write((const char*)encodedIndices.data(), (std::streamsize)encodedIndices.size());
+        } else {
+            file.write((const char*)vertexData.data(), (std::streamsize)vertexCount*totalBytesPerVertex);
+            file.write((const char*)elementData.data(), (std::streamsize)elementData.size()*sizeof(uint16_t));
+        }
+        if (!file){
+            LOG_ERROR("Cannot write mesh file %s", filename.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<Mesh> Mesh::loadBinary(const std::string &filename) {
+        MappedFile file;
+        if (!file.open(filename)){
+            LOG_ERROR("Cannot open mesh file %s", filename.c_str());
+            return nullptr;
+        }
+        BinaryReader reader(file.data(), file.size());
+        const char* magic = reader.skip(sizeof(sreMeshMagic));
+        if (magic == nullptr || memcmp(magic, sreMeshMagic, sizeof(sreMeshMagic)) != 0){
+            LOG_ERROR("%s is not a sremesh file", filename.c_str());
+            return nullptr;
+        }
+        uint32_t version = reader.read<uint32_t>();
+        if (version < 1 || version > sreMeshVersion){
+            LOG_ERROR("Unsupported sremesh version %u in %s", version, filename.c_str());
+            return nullptr;
+        }
+        uint32_t flags = version >= 2 ? reader.read<uint32_t>() : 0;
+        uint32_t vertexCount = reader.read<uint32_t>();
+        uint32_t bytesPerVertex = reader.read<uint32_t>();
+        uint32_t attributeCount = reader.read<uint32_t>();
+        uint32_t indexSetCount = reader.read<uint32_t>();
+        uint32_t lodCount = reader.read<uint32_t>();
+        uint32_t elementCount = reader.read<uint32_t>();
+        std::array<glm::vec3,2> bounds;
+        for (int i=0;i<2;i++){
+            for (int j=0;j<3;j++){
+                bounds[i][j] = reader.read<float>();
+            }
+        }
+        std::string name = reader.readString();
+        // 16 bit indices address at most 65536 vertices. Sizes are passed on as int
+        reader.ok &= vertexCount <= 65536 && bytesPerVertex > 0 && (uint64_t)vertexCount*bytesPerVertex <= INT32_MAX && elementCount <= INT32_MAX;
+        std::map<std::string,Attribute> attributes;
+        for (uint32_t i=0;i<attributeCount && reader.ok;i++){
+            std::string attributeName = reader.readString();
+            Attribute attribute{};
+            attribute.offset = reader.read<int32_t>();
+            attribute.elementCount = reader.read<int32_t>();
+            attribute.dataType = reader.read<int32_t>();
+            attribute.attributeType = reader.read<int32_t>();
+            if (attribute.offset < 0 || attribute.elementCount < 1 || attribute.elementCount > 4 ||
+                (int64_t)attribute.offset + attribute.elementCount*4 > (int64_t)bytesPerVertex){
+                reader.ok = false;
+            }
+            attributes[attributeName] = attribute;
+        }
+        auto validRange = [&](uint32_t byteOffset, uint32_t count){
+            return byteOffset % sizeof(uint16_t) == 0 && (uint64_t)byteOffset/sizeof(uint16_t) + count <= elementCount;
+        };
+        std::vector<MeshTopology> meshTopology;
+        uint32_t topologyCount = reader.read<uint32_t>();
+        for (uint32_t i=0;i<topologyCount && reader.ok;i++){
+            meshTopology.push_back((MeshTopology)reader.read<uint32_t>());
+        }
+        std::vector<std::pair<int,int>> elementBufferOffsetCount;
+        for (uint32_t i=0;i<indexSetCount && reader.ok;i++){
+            uint32_t offset = reader.read<uint32_t>();
+            uint32_t count = reader.read<uint32_t>();
+            reader.ok &= validRange(offset, count);
+            elementBufferOffsetCount.emplace_back(offset, count);
+        }
+        std::vector<LOD> lods;
+        for (uint32_t l=0;l<lodCount && reader.ok;l++){
+            LOD lod;
+            lod.ratio = reader.read<float>();
+            lod.screenSize = reader.read<float>();
+            for (uint32_t i=0;i<indexSetCount;i++){
+                uint32_t offset = reader.read<uint32_t>();
+                uint32_t count = reader.read<uint32_t>();
+                reader.ok &= validRange(offset, count);
+                lod.elementBufferOffsetCount.emplace_back(offset, count);
+            }
+            lods.push_back(std::move(lod));
+        }
+        reader.align(16);
+        const char* vertexData;
+        const char* elementData;
+        std::vector<char> decodedVertices;
+        std::vector<uint16_t> decodedIndices;
+        if (flags & sreMeshFlagCompressed){
+            uint32_t encodedVertexSize = reader.read<uint32_t>();
+            uint32_t encodedIndexSize = reader.read<uint32_t>();
+            auto encodedVertices = (const uint8_t*)reader.skip(encodedVertexSize);
+            auto encodedIndices = (const uint8_t*)reader.skip(encodedIndexSize);
+            // each index is at least one byte and each block of 256 vertices stores the first vertex raw
+            reader.ok &= elementCount < encodedIndexSize && ((uint64_t)vertexCount + 255)/256*bytesPerVertex < encodedVertexSize;
+            if (reader.ok){
+                decodedVertices.resize((size_t)vertexCount*bytesPerVertex);
+                decodedIndices.resize(elementCount);
+                reader.ok = MeshCodec::decodeVertexBuffer(decodedVertices.data(), vertexCount, bytesPerVertex, encodedVertices, encodedVertexSize) &&
+                            MeshCodec::decodeIndexBuffer(decodedIndices.data(), elementCount, encodedIndices, encodedIndexSize);
+            }
+            vertexData = decodedVertices.data();
+            elementData = (const char*)decodedIndices.data();
+        } else {
+            vertexData = reader.skip((size_t)vertexCount*bytesPerVertex);
+            elementData = reader.skip((size_t)elementCount*sizeof(uint16_t));
+        }
+        if (!reader.ok || bytesPerVertex % 16 != 0 || meshTopology.empty() || meshTopology.size() < indexSetCount){
+            LOG_ERROR("Invalid sremesh file %s", filename.c_str());
+            return nullptr;
+        }
+        auto indices = (const uint16_t*)elementData;
+        for (uint32_t i=0;i<elementCount;i++){
+            if (indices[i] >= vertexCount){
+                LOG_ERROR("Invalid sremesh file %s. Index %u is out of range", filename.c_str(), (unsigned int)indices[i]);
+                return nullptr;
+            }
+        }
+
+        // uncompressed files are passed directly from the mapped file to the GPU
+        return createFromInterleavedData(name, vertexData, vertexCount, bytesPerVertex, std::move(attributes), std::move(meshTopology),
+                                         indices, elementCount, std::move(elementBufferOffsetCount), std::move(lods), bounds);
+    }
+
+    std::shared_ptr<Mesh> Mesh::createFromInterleavedData(const std::string &name, const void *vertexData, int vertexCount, int bytesPerVertex,
+                                                          std::map<std::string, Attribute> &&attributes, std::vector<MeshTopology> &&meshTopology,
+                                                          const uint16_t *elementData, int elementCount, std::vector<std::pair<int, int>> &&elementBufferOffsetCount,
+                                                          std::vector<LOD> &&lods, const std::array<glm::vec3, 2> &bounds) {
+        auto mesh = new Mesh();
+        mesh->name = name;
+        mesh->keepCPUData = false;
+        mesh->vertexCount = vertexCount;
+        mesh->totalBytesPerVertex = bytesPerVertex;
+        mesh->attributeByName = std::move(attributes);
+        mesh->meshTopology = std::move(meshTopology);
+        mesh->elementBufferOffsetCount = std::move(elementBufferOffsetCount);
+        mesh->lods = std::move(lods);
+        mesh->boundsMinMax = bounds;
+        mesh->layoutId = Renderer::instance->vertexArrayCache->getLayoutId(mesh->getLayoutKey());
+        mesh->upload(vertexData, elementData, elementCount, false);
+        mesh->dataSize = bytesPerVertex * vertexCount;
+
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        renderStats.meshBytes += mesh->dataSize;
+        renderStats.meshBytesAllocated += mesh->dataSize;
+        renderStats.meshCount++;
+        return std::shared_ptr<Mesh>(mesh);
+    }
+
     Mesh::MeshBuilder &Mesh::MeshBuilder::withPositions(const std::vector<glm::vec3> &vertexPositions) {
         withAttribute("position", vertexPositions);
         return *this;
@@ -485,19 +1185,42 @@ namespace sre {
             name = "Unnamed Mesh";
         }
 
+        bool buildMeshlets = meshletMaxVertices > 0 && meshletMaxTriangles > 0;
+        if (weldEpsilon >= 0){
+            weldVertices(weldEpsilon);
+        } else if ((optimizeMesh || !lodRatios.empty() || buildMeshlets) && indices.empty()){
+            weldVertices(0);
+        }
+        if (optimizeMesh){
+            applyOptimization();
+        }
+        std::vector<std::vector<MeshOptimizer::Meshlet>> meshlets;
+        if (buildMeshlets){
+            auto positionIter = attributesVec3.find("position");
+            for (int i=0;i<indices.size() && positionIter != attributesVec3.end();i++){
+                meshlets.emplace_back();
+                if (i < meshTopology.size() && meshTopology[i] == MeshTopology::Triangles){
+                    meshlets[i] = MeshOptimizer::buildMeshlets(indices[i], positionIter->second, meshletMaxVertices, meshletMaxTriangles);
+                }
+            }
+        }
+
+        Mesh* mesh = updateMesh;
         if (updateMesh != nullptr){
             renderStats.meshBytes -= updateMesh->getDataSize();
-            updateMesh->update(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology,name,renderStats);
-
+            updateMesh->update(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology,name,renderStats,keepCPUData,lodRatios,useGeometryArena);
+        } else {
+            mesh = new Mesh(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology,name,renderStats,keepCPUData,lodRatios,useGeometryArena);
+            renderStats.meshCount++;
+        }
+        mesh->meshlets = std::move(meshlets);
+        mesh->meshletMaxVertices = meshletMaxVertices;
+        mesh->meshletMaxTriangles = meshletMaxTriangles;
 
+        if (updateMesh != nullptr){
             return updateMesh->shared_from_this();
         }
-
-        auto res = new Mesh(std::move(this->attributesFloat), std::move(this->attributesVec2), std::move(this->attributesVec3), std::move(this->attributesVec4), std::move(this->attributesIVec4), std::move(indices), meshTopology,name,renderStats);
-        renderStats.meshCount++;
-
-        return std::shared_ptr<Mesh>(res);
-
+        return std::shared_ptr<Mesh>(mesh);
     }
 
     Mesh::MeshBuilder &Mesh::MeshBuilder::withSphere(int stacks, int slices, float radius) {
@@ -890,4 +1613,125 @@ namespace sre {
         this->name = name;
         return *this;
     }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withKeepCPUData(bool enable) {
+        this->keepCPUData = enable;
+        return *this;
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withOptimize(bool enable) {
+        this->optimizeMesh = enable;
+        return *this;
+    }
+
+    int Mesh::MeshBuilder::getVertexCount() {
+        int vertexCount = 0;
+        for (auto& a : attributesFloat) vertexCount = std::max(vertexCount, (int)a.second.size());
+        for (auto& a : attributesVec2) vertexCount = std::max(vertexCount, (int)a.second.size());
+        for (auto& a : attributesVec3) vertexCount = std::max(vertexCount, (int)a.second.size());
+        for (auto& a : attributesVec4) vertexCount = std::max(vertexCount, (int)a.second.size());
+        for (auto& a : attributesIVec4) vertexCount = std::max(vertexCount, (int)a.second.size());
+        return vertexCount;
+    }
+
+    void Mesh::MeshBuilder::remapVertices(const std::vector<uint16_t>& remap, int newVertexCount) {
+        remapAttributes(attributesFloat, remap, newVertexCount);
+        remapAttributes(attributesVec2, remap, newVertexCount);
+        remapAttributes(attributesVec3, remap, newVertexCount);
+        remapAttributes(attributesVec4, remap, newVertexCount);
+        remapAttributes(attributesIVec4, remap, newVertexCount);
+    }
+
+    void Mesh::MeshBuilder::weldVertices(float epsilon) {
+        // merge identical vertices (or vertices in the same epsilon grid cell). Non-indexed triangle meshes (such as
+        // withSphere() and withTorus()) become indexed. Other non-indexed meshes are left unchanged
+        int vertexCount = getVertexCount();
+        bool indexed = !indices.empty();
+        if (vertexCount == 0 || (!indexed && (meshTopology.empty() || meshTopology[0] != MeshTopology::Triangles))){
+            return;
+        }
+        int keyWords = getKeyWords(attributesFloat, vertexCount) + getKeyWords(attributesVec2, vertexCount) + getKeyWords(attributesVec3, vertexCount) +
+                       getKeyWords(attributesVec4, vertexCount) + getKeyWords(attributesIVec4, vertexCount);
+        VertexWelder welder(keyWords, vertexCount);
+        std::vector<int> vertexRemap(vertexCount);
+        std::vector<uint32_t> key(keyWords);
+        for (int i=0;i<vertexCount;i++){
+            uint32_t* k = key.data();
+            k = appendVertexKey(attributesFloat, i, vertexCount, epsilon, k);
+            k = appendVertexKey(attributesVec2, i, vertexCount, epsilon, k);
+            k = appendVertexKey(attributesVec3, i, vertexCount, epsilon, k);
+            k = appendVertexKey(attributesVec4, i, vertexCount, epsilon, k);
+            appendVertexKey(attributesIVec4, i, vertexCount, epsilon, k);
+            vertexRemap[i] = welder.insert(key.data());
+        }
+        int uniqueCount = welder.size();
+        if (uniqueCount > 65536){
+            LOG_WARNING("Cannot index mesh %s. Too many unique vertices (%i).", name.c_str(), uniqueCount);
+            return;
+        }
+        if (uniqueCount == vertexCount && indexed){
+            return;
+        }
+        std::vector<uint16_t> remap(vertexRemap.begin(), vertexRemap.end());
+        remapVertices(remap, uniqueCount);                      // the first vertex of each group is kept
+        if (indexed){
+            for (auto& indexSet : indices){
+                for (auto& index : indexSet){
+                    index = remap[index];
+                }
+            }
+        } else {
+            indices.push_back(std::move(remap));
+        }
+    }
+
+    void Mesh::MeshBuilder::applyOptimization() {
+        int vertexCount = getVertexCount();
+        if (vertexCount == 0 || vertexCount > 65536){
+            return;                                             // cannot be indexed with 16 bit indices
+        }
+
+        auto positionIter = attributesVec3.find("position");
+        for (int i=0;i<indices.size();i++){
+            if (i < meshTopology.size() && meshTopology[i] != MeshTopology::Triangles){
+                continue;
+            }
+            auto before = MeshOptimizer::analyzeVertexCache(indices[i], vertexCount);
+            indices[i] = MeshOptimizer::optimizeVertexCache(indices[i], vertexCount);
+            if (positionIter != attributesVec3.end()){
+                indices[i] = MeshOptimizer::optimizeOverdraw(indices[i], positionIter->second);
+            }
+            auto after = MeshOptimizer::analyzeVertexCache(indices[i], vertexCount);
+            LOG_INFO("Optimized mesh %s index set %i. ACMR %.3f -> %.3f ATVR %.3f -> %.3f", name.c_str(), i, before.acmr, after.acmr, before.atvr, after.atvr);
+        }
+
+        auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertexCount);
+        remapVertices(remap, vertexCount);
+        for (auto& indexSet : indices){
+            for (auto& index : indexSet){
+                index = remap[index];
+            }
+        }
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withLODs(const std::vector<float>& ratios) {
+        this->lodRatios = ratios;
+        return *this;
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withMeshlets(int maxVertices, int maxTriangles) {
+        this->meshletMaxVertices = maxVertices;
+        this->meshletMaxTriangles = maxTriangles;
+        return *this;
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withWeld(float epsilon) {
+        this->weldEpsilon = epsilon;
+        return *this;
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withGeometryArena(bool enable) {
+        this->useGeometryArena = enable;
+        return *this;
+    }
 }
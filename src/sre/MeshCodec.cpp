@@ -0,0 +1,294 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/MeshCodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include "sre/impl/ParallelFor.hpp"
+#include "sre/impl/Simd.hpp"
+
+namespace {
+    const uint8_t vertexCodecHeader = 0xa1;
+    const uint8_t indexCodecHeader = 0xb1;
+    const int vertexBlockSize = 256;                                // vertices per block (must be a multiple of 16)
+    const int groupSize = 16;
+
+    inline uint8_t zigzag(uint8_t delta){
+        return (uint8_t)((delta << 1) ^ ((int8_t)delta >> 7));
+    }
+
+    inline uint8_t unzigzag(uint8_t value){
+        return (uint8_t)((value >> 1) ^ -(value & 1));
+    }
+
+    // lookup table for 2 bit groups: each byte expands to 4 values
+    struct TwoBitTable {
+        TwoBitTable(){
+            for (int i=0;i<256;i++){
+                uint8_t values[4];
+                for (int j=0;j<4;j++){
+                    values[j] = (uint8_t)((i >> (j*2)) & 3);
+                }
+                memcpy(&table[i], values, 4);
+            }
+        }
+        uint32_t table[256];
+    };
+    const TwoBitTable twoBitTable;
+
+    void encodeGroup(const uint8_t* values, int bits, std::vector<uint8_t>& res){
+        if (bits == 2){
+            for (int i=0;i<groupSize;i+=4){
+                res.push_back((uint8_t)(values[i] | values[i+1] << 2 | values[i+2] << 4 | values[i+3] << 6));
+            }
+        } else if (bits == 4){
+            for (int i=0;i<groupSize;i+=2){
+                res.push_back((uint8_t)(values[i] | values[i+1] << 4));
+            }
+        } else if (bits == 8){
+            res.insert(res.end(), values, values + groupSize);
+        }
+    }
+
+    // decodes a byte plane of groupCount groups. Returns pointer after the plane or nullptr if out of bounds
+    const uint8_t* decodePlane(uint8_t* plane, int groupCount, const uint8_t* data, const uint8_t* dataEnd){
+        const uint8_t* header = data;
+        data += (groupCount + 3) / 4;
+        if (data > dataEnd){
+            return nullptr;
+        }
+        for (int g=0;g<groupCount;g++){
+            int code = (header[g / 4] >> ((g % 4) * 2)) & 3;
+            uint8_t* dst = plane + g * groupSize;
+            switch (code){
+                case 0:
+                    memset(dst, 0, groupSize);
+                    break;
+                case 1:
+                    if (data + 4 > dataEnd){
+                        return nullptr;
+                    }
+                    for (int i=0;i<4;i++){
+                        memcpy(dst + i*4, &twoBitTable.table[data[i]], 4);
+                    }
+                    data += 4;
+                    break;
+                case 2:
+                {
+                    if (data + 8 > dataEnd){
+                        return nullptr;
+                    }
+#ifdef SRE_SSE2
+                    __m128i packed = _mm_loadl_epi64((const __m128i*)data);
+                    __m128i mask = _mm_set1_epi8(0x0f);
+                    __m128i low = _mm_and_si128(packed, mask);
+                    __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+                    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(low, high));
+#else
+                    for (int i=0;i<8;i++){
+                        dst[i*2] = (uint8_t)(data[i] & 0x0f);
+                        dst[i*2+1] = (uint8_t)(data[i] >> 4);
+                    }
+#endif
+                    data += 8;
+                    break;
+                }
+                default:
+                    if (data + groupSize > dataEnd){
+                        return nullptr;
+                    }
+                    memcpy(dst, data, groupSize);
+                    data += groupSize;
+                    break;
+            }
+        }
+        return data;
+    }
+
+#ifdef SRE_SSE2
+    // transpose 16x16 bytes (4 rounds of interleaving row i with row i+8)
+    inline void transpose16x16(__m128i* rows){
+        __m128i tmp[16];
+        for (int round=0;round<4;round++){
+            for (int i=0;i<8;i++){
+                tmp[i*2] = _mm_unpacklo_epi8(rows[i], rows[i+8]);
+                tmp[i*2+1] = _mm_unpackhi_epi8(rows[i], rows[i+8]);
+            }
+            for (int i=0;i<16;i++){
+                rows[i] = tmp[i];
+            }
+        }
+    }
+
+    inline __m128i unzigzag(__m128i value){
+        __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1)));
+        __m128i shifted = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7f));
+        return _mm_xor_si128(shifted, sign);
+    }
+#endif
+}
+
+namespace sre {
+    std::vector<uint8_t> MeshCodec::encodeVertexBuffer(const void *vertices, int vertexCount, int vertexSize) {
+        std::vector<uint8_t> res;
+        res.reserve((size_t)vertexCount * vertexSize / 2);
+        res.push_back(vertexCodecHeader);
+        int blockCount = (vertexCount + vertexBlockSize - 1) / vertexBlockSize;
+        size_t offsetTable = res.size();
+        res.resize(res.size() + blockCount * sizeof(uint32_t));
+        const uint8_t* data = (const uint8_t*)vertices;
+        uint8_t plane[vertexBlockSize];
+        for (int block = 0; block < blockCount; block++){
+            int base = block * vertexBlockSize;
+            int count = std::min(vertexBlockSize, vertexCount - base);
+            int groupCount = (count + groupSize - 1) / groupSize;
+            uint32_t offset = (uint32_t)res.size();
+            memcpy(res.data() + offsetTable + block * sizeof(uint32_t), &offset, sizeof(uint32_t));
+            // the first vertex is stored raw and used as delta base
+            const uint8_t* first = data + (size_t)base * vertexSize;
+            res.insert(res.end(), first, first + vertexSize);
+            for (int k=0;k<vertexSize;k++){
+                uint8_t previous = first[k];
+                for (int i=0;i<count;i++){
+                    uint8_t value = data[(size_t)(base + i) * vertexSize + k];
+                    plane[i] = zigzag((uint8_t)(value - previous));
+                    previous = value;
+                }
+                memset(plane + count, 0, groupCount * groupSize - count);
+
+                size_t headerPos = res.size();
+                res.resize(res.size() + (groupCount + 3) / 4, 0);
+                for (int g=0;g<groupCount;g++){
+                    const uint8_t* values = plane + g * groupSize;
+                    uint8_t maxValue = *std::max_element(values, values + groupSize);
+                    int code = maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+                    res[headerPos + g / 4] |= (uint8_t)(code << ((g % 4) * 2));
+                    encodeGroup(values, code == 0 ? 0 : 1 << code, res);
+                }
+            }
+        }
+        return res;
+    }
+
+    bool MeshCodec::decodeVertexBuffer(void *destination, int vertexCount, int vertexSize, const uint8_t *data, size_t size) {
+        int blockCount = (vertexCount + vertexBlockSize - 1) / vertexBlockSize;
+        size_t headerSize = 1 + blockCount * sizeof(uint32_t);
+        if (size < headerSize || data[0] != vertexCodecHeader){
+            return false;
+        }
+        std::vector<uint32_t> offsets(blockCount + 1);
+        memcpy(offsets.data(), data + 1, blockCount * sizeof(uint32_t));
+        offsets[blockCount] = (uint32_t)size;
+        for (int block = 0; block < blockCount; block++){
+            if (offsets[block] < headerSize || offsets[block] > offsets[block + 1]){
+                return false;
+            }
+        }
+        // blocks are independent and decoded in parallel
+        uint8_t* dst = (uint8_t*)destination;
+        std::atomic<bool> valid(true);
+        parallelFor(blockCount, 16, [&](size_t begin, size_t end){
+            std::vector<uint8_t> planes((size_t)vertexSize * vertexBlockSize);
+            std::vector<uint8_t> last(vertexSize);
+            for (size_t block = begin; block < end && valid; block++){
+                const uint8_t* blockData = data + offsets[block];
+                const uint8_t* blockEnd = data + offsets[block + 1];
+                int base = (int)block * vertexBlockSize;
+                int count = std::min(vertexBlockSize, vertexCount - base);
+                int groupCount = (count + groupSize - 1) / groupSize;
+                if (blockEnd - blockData < vertexSize){
+                    valid = false;
+                    return;
+                }
+                memcpy(last.data(), blockData, vertexSize);
+                blockData += vertexSize;
+                for (int k=0;k<vertexSize;k++){
+                    blockData = decodePlane(planes.data() + k * vertexBlockSize, groupCount, blockData, blockEnd);
+                    if (blockData == nullptr){
+                        valid = false;
+                        return;
+                    }
+                }
+                int k = 0;
+#ifdef SRE_SSE2
+                // 16 vertex bytes at a time: transpose the planes back into vertices and accumulate the deltas
+                for (; k + 16 <= vertexSize; k += 16){
+                    __m128i accumulator = _mm_loadu_si128((const __m128i*)(last.data() + k));
+                    for (int i0 = 0; i0 < count; i0 += 16){
+                        __m128i rows[16];
+                        for (int j=0;j<16;j++){
+                            rows[j] = _mm_loadu_si128((const __m128i*)(planes.data() + (k + j) * vertexBlockSize + i0));
+                        }
+                        transpose16x16(rows);
+                        int rowCount = std::min(16, count - i0);
+                        uint8_t* vertex = dst + (size_t)(base + i0) * vertexSize + k;
+                        for (int i=0;i<rowCount;i++){
+                            accumulator = _mm_add_epi8(accumulator, unzigzag(rows[i]));
+                            _mm_storeu_si128((__m128i*)vertex, accumulator);
+                            vertex += vertexSize;
+                        }
+                    }
+                }
+#endif
+                for (; k < vertexSize; k++){
+                    uint8_t value = last[k];
+                    const uint8_t* plane = planes.data() + k * vertexBlockSize;
+                    for (int i=0;i<count;i++){
+                        value += unzigzag(plane[i]);
+                        dst[(size_t)(base + i) * vertexSize + k] = value;
+                    }
+                }
+            }
+        });
+        return valid;
+    }
+
+    std::vector<uint8_t> MeshCodec::encodeIndexBuffer(const uint16_t *indices, int indexCount) {
+        std::vector<uint8_t> res;
+        res.reserve(indexCount + 1);
+        res.push_back(indexCodecHeader);
+        int previous = 0;
+        for (int i=0;i<indexCount;i++){
+            int delta = indices[i] - previous;
+            uint32_t value = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31); // zigzag, shifted as unsigned
+            while (value >= 0x80){
+                res.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            res.push_back((uint8_t)value);
+            previous = indices[i];
+        }
+        return res;
+    }
+
+    bool MeshCodec::decodeIndexBuffer(uint16_t *destination, int indexCount, const uint8_t *data, size_t size) {
+        if (size < 1 || data[0] != indexCodecHeader){
+            return false;
+        }
+        const uint8_t* dataEnd = data + size;
+        data++;
+        int previous = 0;
+        for (int i=0;i<indexCount;i++){
+            uint32_t value = 0;
+            int shift = 0;
+            uint8_t byte;
+            do {
+                if (data == dataEnd || shift > 14){
+                    return false;
+                }
+                byte = *data++;
+                value |= (uint32_t)(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            previous += (int)(value >> 1) ^ -(int)(value & 1);
+            destination[i] = (uint16_t)previous;
+        }
+        return true;
+    }
+}
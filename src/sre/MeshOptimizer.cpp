@@ -0,0 +1,613 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <array>
+#include <unordered_map>
+#include <map>
+#include <limits>
+
+namespace {
+    // Forsyth's linear-speed vertex cache optimisation
+    // https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+    const int forsythCacheSize = 32;
+    const float cacheDecayPower = 1.5f;
+    const float lastTriScore = 0.75f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+
+    float vertexScore(int cachePosition, int liveTriangles){
+        if (liveTriangles == 0){
+            return -1.0f;                           // no triangles left, never selected
+        }
+        float score = 0;
+        if (cachePosition >= 0){
+            if (cachePosition < 3){
+                score = lastTriScore;               // used by the last triangle, fixed score to avoid favouring a specific vertex
+            } else {
+                const float scaler = 1.0f / (forsythCacheSize - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, cacheDecayPower);
+            }
+        }
+        score += valenceBoostScale * std::pow((float)liveTriangles, -valenceBoostPower);
+        return score;
+    }
+
+    // returns number of cache misses for each triangle using a FIFO cache
+    std::vector<int> simulateFifo(const std::vector<uint16_t>& indices, int vertexCount, int cacheSize){
+        std::vector<int> cacheTimestamp(vertexCount, -cacheSize-1);
+        std::vector<int> misses(indices.size()/3, 0);
+        int time = 0;
+        for (size_t i=0;i+2<indices.size();i+=3){
+            for (int j=0;j<3;j++){
+                uint16_t v = indices[i+j];
+                if (time - cacheTimestamp[v] > cacheSize){
+                    cacheTimestamp[v] = time;
+                    time++;
+                    misses[i/3]++;
+                }
+            }
+        }
+        return misses;
+    }
+
+    // symmetric 4x4 matrix (stored as upper triangle) representing the sum of squared distances to a set of planes
+    struct Quadric {
+        std::array<double,10> m{};
+
+        void addPlane(glm::dvec3 n, double d, double weight){
+            m[0] += weight*n.x*n.x; m[1] += weight*n.x*n.y; m[2] += weight*n.x*n.z; m[3] += weight*n.x*d;
+            m[4] += weight*n.y*n.y; m[5] += weight*n.y*n.z; m[6] += weight*n.y*d;
+            m[7] += weight*n.z*n.z; m[8] += weight*n.z*d;
+            m[9] += weight*d*d;
+        }
+
+        void add(const Quadric& q){
+            for (int i=0;i<10;i++){
+                m[i] += q.m[i];
+            }
+        }
+
+        double error(glm::dvec3 v) const {
+            return  m[0]*v.x*v.x + 2*m[1]*v.x*v.y + 2*m[2]*v.x*v.z + 2*m[3]*v.x
+                  + m[4]*v.y*v.y + 2*m[5]*v.y*v.z + 2*m[6]*v.y
+                  + m[7]*v.z*v.z + 2*m[8]*v.z
+                  + m[9];
+        }
+    };
+
+    struct Collapse {
+        int from;           // canonical vertex removed
+        int to;             // canonical vertex kept
+        int wedge;          // vertex index replacing 'from' (the 'to' vertex on the same side of any attribute seam)
+        double error;
+    };
+
+    glm::vec3 triangleNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2){
+        return glm::cross(p1-p0, p2-p0);
+    }
+}
+
+namespace sre {
+
+    MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint16_t> &indices, int vertexCount, int cacheSize) {
+        VertexCacheStats stats;
+        int triangleCount = (int)indices.size()/3;
+        if (triangleCount == 0 || vertexCount == 0){
+            return stats;
+        }
+        auto misses = simulateFifo(indices, vertexCount, cacheSize);
+        int totalMisses = std::accumulate(misses.begin(), misses.end(), 0);
+        stats.acmr = totalMisses / (float)triangleCount;
+        stats.atvr = totalMisses / (float)vertexCount;
+        return stats;
+    }
+
+    std::vector<uint16_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint16_t> &indices, int vertexCount) {
+        int triangleCount = (int)indices.size()/3;
+        if (triangleCount == 0){
+            return indices;
+        }
+
+        // build vertex to triangle adjacency (compressed in a single array)
+        std::vector<int> liveTriangles(vertexCount, 0);
+        for (int i=0;i<triangleCount*3;i++){
+            liveTriangles[indices[i]]++;
+        }
+        std::vector<int> adjacencyOffset(vertexCount+1, 0);
+        for (int i=0;i<vertexCount;i++){
+            adjacencyOffset[i+1] = adjacencyOffset[i] + liveTriangles[i];
+        }
+        std::vector<int> adjacency(triangleCount*3);
+        std::vector<int> adjacencyFill(adjacencyOffset.begin(), adjacencyOffset.end()-1);
+        for (int i=0;i<triangleCount*3;i++){
+            adjacency[adjacencyFill[indices[i]]++] = i/3;
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for (int i=0;i<vertexCount;i++){
+            score[i] = vertexScore(-1, liveTriangles[i]);
+        }
+        std::vector<float> triangleScore(triangleCount);
+        for (int i=0;i<triangleCount;i++){
+            triangleScore[i] = score[indices[i*3]] + score[indices[i*3+1]] + score[indices[i*3+2]];
+        }
+        std::vector<bool> emitted(triangleCount, false);
+
+        std::vector<uint16_t> res;
+        res.reserve(triangleCount*3);
+
+        std::vector<int> cache;
+        std::vector<int> newCache;
+        cache.reserve(forsythCacheSize+3);
+        newCache.reserve(forsythCacheSize+3);
+
+        int bestTriangle = 0;
+        for (int i=1;i<triangleCount;i++){
+            if (triangleScore[i] > triangleScore[bestTriangle]){
+                bestTriangle = i;
+            }
+        }
+        int nextUnemitted = 0;                          // linear scan fallback when no cached vertex has live triangles
+
+        for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++){
+            if (bestTriangle < 0){
+                while (emitted[nextUnemitted]) {
+                    nextUnemitted++;
+                }
+                bestTriangle = nextUnemitted;
+            }
+            emitted[bestTriangle] = true;
+
+            // emit triangle and remove it from the adjacency of its vertices
+            newCache.clear();
+            for (int j=0;j<3;j++){
+                int v = indices[bestTriangle*3+j];
+                res.push_back((uint16_t)v);
+                newCache.push_back(v);
+                int begin = adjacencyOffset[v];
+                int end = begin + liveTriangles[v];
+                for (int k=begin;k<end;k++){
+                    if (adjacency[k] == bestTriangle){
+                        std::swap(adjacency[k], adjacency[end-1]);
+                        break;
+                    }
+                }
+                liveTriangles[v]--;
+            }
+            for (int v : cache){
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()){
+                    newCache.push_back(v);
+                }
+            }
+            // vertices pushed out of the cache
+            for (size_t j = forsythCacheSize; j < newCache.size(); j++){
+                cachePosition[newCache[j]] = -1;
+                score[newCache[j]] = vertexScore(-1, liveTriangles[newCache[j]]);
+            }
+            if (newCache.size() > forsythCacheSize){
+                newCache.resize(forsythCacheSize);
+            }
+            std::swap(cache, newCache);
+
+            // update scores of cached vertices and find the best triangle among their adjacent triangles
+            for (int j=0;j<(int)cache.size();j++){
+                cachePosition[cache[j]] = j;
+                score[cache[j]] = vertexScore(j, liveTriangles[cache[j]]);
+            }
+            bestTriangle = -1;
+            float bestScore = -1;
+            for (int v : cache){
+                int begin = adjacencyOffset[v];
+                int end = begin + liveTriangles[v];
+                for (int k=begin;k<end;k++){
+                    int t = adjacency[k];
+                    float s = score[indices[t*3]] + score[indices[t*3+1]] + score[indices[t*3+2]];
+                    triangleScore[t] = s;
+                    if (s > bestScore){
+                        bestScore = s;
+                        bestTriangle = t;
+                    }
+                }
+            }
+        }
+        return res;
+    }
+
+    std::vector<uint16_t> MeshOptimizer::optimizeOverdraw(const std::vector<uint16_t> &indices, const std::vector<glm::vec3> &positions, float threshold) {
+        int triangleCount = (int)indices.size()/3;
+        int vertexCount = (int)positions.size();
+        if (triangleCount < 2){
+            return indices;
+        }
+
+        // split into clusters. Hard boundaries are where the cache is flushed (all three vertices are misses).
+        // Soft boundaries are added inside a hard cluster where the ACMR so far is below the threshold of the
+        // complete cluster, which means that reordering the clusters does not degrade the cache efficiency much.
+        const int cacheSize = 16;
+        auto misses = simulateFifo(indices, vertexCount, cacheSize);
+        std::vector<int> hardClusters;
+        for (int i=0;i<triangleCount;i++){
+            if (i == 0 || misses[i] == 3){
+                hardClusters.push_back(i);
+            }
+        }
+        hardClusters.push_back(triangleCount);
+
+        std::vector<int> clusters;
+        for (size_t c=0;c+1<hardClusters.size();c++){
+            int begin = hardClusters[c];
+            int end = hardClusters[c+1];
+            int clusterMisses = 0;
+            for (int i=begin;i<end;i++){
+                clusterMisses += misses[i];
+            }
+            float clusterAcmr = clusterMisses / (float)(end - begin);
+            clusters.push_back(begin);
+            int accumulatedMisses = 0;
+            int start = begin;
+            for (int i=begin;i<end;i++){
+                accumulatedMisses += misses[i];
+                int count = i - start + 1;
+                if (count >= 8 && i+1 < end && accumulatedMisses / (float)count <= clusterAcmr * threshold && misses[i+1] > 0){
+                    clusters.push_back(i+1);
+                    start = i+1;
+                    accumulatedMisses = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        // sort clusters so outwards facing clusters (likely occluders) are rendered first
+        glm::vec3 meshCentroid(0);
+        float meshArea = 0;
+        struct ClusterSort {
+            int index;
+            float dot;
+        };
+        std::vector<glm::vec3> clusterCentroid(clusters.size()-1, glm::vec3(0));
+        std::vector<glm::vec3> clusterNormal(clusters.size()-1, glm::vec3(0));
+        for (size_t c=0;c+1<clusters.size();c++){
+            float clusterArea = 0;
+            for (int i=clusters[c];i<clusters[c+1];i++){
+                const glm::vec3& p0 = positions[indices[i*3]];
+                const glm::vec3& p1 = positions[indices[i*3+1]];
+                const glm::vec3& p2 = positions[indices[i*3+2]];
+                glm::vec3 normal = glm::cross(p1-p0, p2-p0);        // length is twice the area
+                float area = glm::length(normal);
+                glm::vec3 centroid = (p0+p1+p2)*(1.0f/3.0f);
+                clusterCentroid[c] += centroid * area;
+                clusterNormal[c] += normal;
+                clusterArea += area;
+                meshCentroid += centroid * area;
+                meshArea += area;
+            }
+            if (clusterArea > 0){
+                clusterCentroid[c] /= clusterArea;
+            }
+            float len = glm::length(clusterNormal[c]);
+            if (len > 0){
+                clusterNormal[c] /= len;
+            }
+        }
+        if (meshArea > 0){
+            meshCentroid /= meshArea;
+        }
+        std::vector<ClusterSort> order;
+        for (size_t c=0;c+1<clusters.size();c++){
+            order.push_back({(int)c, glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c])});
+        }
+        std::stable_sort(order.begin(), order.end(), [](const ClusterSort& a, const ClusterSort& b){
+            return a.dot > b.dot;
+        });
+
+        std::vector<uint16_t> res;
+        res.reserve(triangleCount*3);
+        for (auto& o : order){
+            res.insert(res.end(), indices.begin() + clusters[o.index]*3, indices.begin() + clusters[o.index+1]*3);
+        }
+        return res;
+    }
+
+    std::vector<uint16_t> MeshOptimizer::optimizeVertexFetch(const std::vector<std::vector<uint16_t>> &indexSets, int vertexCount) {
+        const int unused = -1;
+        std::vector<int> remap(vertexCount, unused);
+        int next = 0;
+        for (auto& indices : indexSets){
+            for (auto i : indices){
+                if (remap[i] == unused){
+                    remap[i] = next++;
+                }
+            }
+        }
+        for (auto& r : remap){
+            if (r == unused){
+                r = next++;
+            }
+        }
+        return std::vector<uint16_t>(remap.begin(), remap.end());
+    }
+
+    std::vector<uint16_t> MeshOptimizer::simplify(const std::vector<uint16_t> &indicesIn, const std::vector<glm::vec3> &positions, int targetIndexCount) {
+        std::vector<uint16_t> indices(indicesIn.begin(), indicesIn.begin() + (indicesIn.size()/3)*3);
+        int vertexCount = (int)positions.size();
+        if ((int)indices.size() <= targetIndexCount || vertexCount == 0){
+            return indices;
+        }
+
+        // vertices sharing the same position (such as uv seams) are simplified as one canonical vertex
+        std::vector<int> canonical(vertexCount);
+        std::vector<int> wedgeCount(vertexCount, 0);
+        {
+            struct PositionHash {
+                size_t operator()(const glm::vec3& p) const {
+                    const uint32_t* u = reinterpret_cast<const uint32_t*>(&p);
+                    return (u[0] * 73856093u) ^ (u[1] * 19349663u) ^ (u[2] * 83492791u);
+                }
+            };
+            std::unordered_map<glm::vec3, int, PositionHash> positionToVertex;
+            for (int i=0;i<vertexCount;i++){
+                auto res = positionToVertex.emplace(positions[i], i);
+                canonical[i] = res.first->second;
+            }
+        }
+        std::vector<bool> used(vertexCount, false);
+        for (auto i : indices){
+            if (!used[i]){
+                used[i] = true;
+                wedgeCount[canonical[i]]++;
+            }
+        }
+
+        // lock vertices on attribute seams and on open borders (edges used by a single triangle)
+        std::vector<bool> locked(vertexCount, false);
+        for (int i=0;i<vertexCount;i++){
+            if (wedgeCount[i] > 1){
+                locked[i] = true;
+            }
+        }
+        {
+            std::map<std::pair<int,int>,int> edgeCount;
+            for (size_t i=0;i<indices.size();i+=3){
+                for (int j=0;j<3;j++){
+                    int a = canonical[indices[i+j]];
+                    int b = canonical[indices[i+(j+1)%3]];
+                    edgeCount[{std::min(a,b), std::max(a,b)}]++;
+                }
+            }
+            for (auto& e : edgeCount){
+                if (e.second == 1){
+                    locked[e.first.first] = true;
+                    locked[e.first.second] = true;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i=0;i<indices.size();i+=3){
+            const glm::vec3& p0 = positions[indices[i]];
+            glm::dvec3 normal = triangleNormal(p0, positions[indices[i+1]], positions[indices[i+2]]);
+            double length = glm::length(normal);
+            if (length == 0){
+                continue;
+            }
+            normal /= length;
+            double area = length * 0.5;
+            double d = -glm::dot(normal, glm::dvec3(p0));
+            for (int j=0;j<3;j++){
+                quadrics[canonical[indices[i+j]]].addPlane(normal, d, area);
+            }
+        }
+
+        std::vector<int> collapseTarget(vertexCount, -1);
+        std::vector<bool> touched(vertexCount);
+        std::vector<std::vector<int>> vertexTriangles(vertexCount);
+        std::vector<Collapse> collapses;
+
+        while ((int)indices.size() > targetIndexCount){
+            int triangleCount = (int)indices.size()/3;
+            for (auto& v : vertexTriangles){
+                v.clear();
+            }
+            for (int t=0;t<triangleCount;t++){
+                for (int j=0;j<3;j++){
+                    vertexTriangles[canonical[indices[t*3+j]]].push_back(t);
+                }
+            }
+
+            collapses.clear();
+            for (int t=0;t<triangleCount;t++){
+                for (int j=0;j<3;j++){
+                    int va = indices[t*3+j];
+                    int vb = indices[t*3+(j+1)%3];
+                    int a = canonical[va];
+                    int b = canonical[vb];
+                    // consider both directions of each edge
+                    if (!locked[a]){
+                        Quadric q = quadrics[a];
+                        q.add(quadrics[b]);
+                        collapses.push_back({a, b, vb, q.error(positions[b])});
+                    }
+                    if (!locked[b]){
+                        Quadric q = quadrics[b];
+                        q.add(quadrics[a]);
+                        collapses.push_back({b, a, va, q.error(positions[a])});
+                    }
+                }
+            }
+            if (collapses.empty()){
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b){
+                return a.error < b.error;
+            });
+
+            std::fill(touched.begin(), touched.end(), false);
+            int trianglesToRemove = (triangleCount*3 - targetIndexCount + 2)/3;
+            int removed = 0;
+            int collapseCount = 0;
+            for (auto& c : collapses){
+                if (removed >= trianglesToRemove){
+                    break;
+                }
+                if (touched[c.from] || touched[c.to]){
+                    continue;
+                }
+                // reject collapses which flip a triangle around the removed vertex
+                bool flipped = false;
+                int sharedTriangles = 0;
+                for (int t : vertexTriangles[c.from]){
+                    glm::vec3 p[3];
+                    bool containsTo = false;
+                    for (int j=0;j<3;j++){
+                        int v = canonical[indices[t*3+j]];
+                        containsTo |= v == c.to;
+                        p[j] = v == c.from ? positions[c.to] : positions[v];
+                    }
+                    if (containsTo){
+                        sharedTriangles++;
+                        continue;
+                    }
+                    glm::vec3 before = triangleNormal(positions[canonical[indices[t*3]]], positions[canonical[indices[t*3+1]]], positions[canonical[indices[t*3+2]]]);
+                    glm::vec3 after = triangleNormal(p[0], p[1], p[2]);
+                    if (glm::dot(before, after) <= 0){
+                        flipped = true;
+                        break;
+                    }
+                }
+                if (flipped){
+                    continue;
+                }
+                collapseTarget[c.from] = c.wedge;
+                quadrics[c.to].add(quadrics[c.from]);
+                // the neighbourhood of the removed vertex must not change within this pass
+                for (int t : vertexTriangles[c.from]){
+                    for (int j=0;j<3;j++){
+                        touched[canonical[indices[t*3+j]]] = true;
+                    }
+                }
+                removed += sharedTriangles;
+                collapseCount++;
+            }
+            if (collapseCount == 0){
+                break;
+            }
+
+            // apply collapses and remove degenerate triangles
+            size_t write = 0;
+            for (size_t i=0;i<indices.size();i+=3){
+                uint16_t tri[3];
+                for (int j=0;j<3;j++){
+                    int v = indices[i+j];
+                    int target = collapseTarget[canonical[v]];
+                    tri[j] = (uint16_t)(target != -1 ? target : v);
+                }
+                int c0 = canonical[tri[0]], c1 = canonical[tri[1]], c2 = canonical[tri[2]];
+                if (c0 == c1 || c1 == c2 || c0 == c2){
+                    continue;
+                }
+                indices[write++] = tri[0];
+                indices[write++] = tri[1];
+                indices[write++] = tri[2];
+            }
+            indices.resize(write);
+            for (auto& c : collapseTarget){
+                c = -1;
+            }
+        }
+        return indices;
+    }
+
+    std::vector<MeshOptimizer::Meshlet> MeshOptimizer::buildMeshlets(const std::vector<uint16_t> &indices, const std::vector<glm::vec3> &positions, int maxVertices, int maxTriangles) {
+        std::vector<Meshlet> meshlets;
+        int triangleCount = (int)indices.size()/3;
+        if (triangleCount == 0 || positions.empty()){
+            return meshlets;
+        }
+
+        // greedy scan in the triangle order (vertex cache optimized index sets keeps meshlets local)
+        std::vector<int> meshletOfVertex(positions.size(), -1);
+        int meshletVertices = 0;
+        Meshlet current{0, 0};
+        auto finishMeshlet = [&](){
+            if (current.indexCount > 0){
+                meshlets.push_back(current);
+            }
+            current = {current.indexOffset + current.indexCount, 0};
+            meshletVertices = 0;
+        };
+        for (int t=0;t<triangleCount;t++){
+            int newVertices = 0;
+            for (int j=0;j<3;j++){
+                if (meshletOfVertex[indices[t*3+j]] != (int)meshlets.size()){
+                    newVertices++;
+                }
+            }
+            if (meshletVertices + newVertices > maxVertices || current.indexCount/3 + 1 > maxTriangles){
+                finishMeshlet();
+            }
+            for (int j=0;j<3;j++){
+                int v = indices[t*3+j];
+                if (meshletOfVertex[v] != (int)meshlets.size()){
+                    meshletOfVertex[v] = (int)meshlets.size();
+                    meshletVertices++;
+                }
+            }
+            current.indexCount += 3;
+        }
+        finishMeshlet();
+
+        // compute bounds
+        for (auto& m : meshlets){
+            glm::vec3 minP(std::numeric_limits<float>::max());
+            glm::vec3 maxP(-std::numeric_limits<float>::max());
+            glm::vec3 axis(0);
+            for (int i=m.indexOffset;i<m.indexOffset+m.indexCount;i++){
+                minP = glm::min(minP, positions[indices[i]]);
+                maxP = glm::max(maxP, positions[indices[i]]);
+            }
+            m.center = (minP + maxP) * 0.5f;
+            m.radius = 0;
+            for (int i=m.indexOffset;i<m.indexOffset+m.indexCount;i++){
+                m.radius = std::max(m.radius, glm::length(positions[indices[i]] - m.center));
+            }
+            std::vector<glm::vec3> normals;
+            for (int i=m.indexOffset;i<m.indexOffset+m.indexCount;i+=3){
+                glm::vec3 n = triangleNormal(positions[indices[i]], positions[indices[i+1]], positions[indices[i+2]]);
+                float length = glm::length(n);
+                if (length > 0){
+                    normals.push_back(n / length);
+                    axis += normals.back();
+                }
+            }
+            float axisLength = glm::length(axis);
+            m.coneAxis = axisLength > 0 ? axis / axisLength : glm::vec3(0,0,1);
+            float minDot = axisLength > 0 ? 1.0f : -1.0f;
+            for (auto& n : normals){
+                minDot = std::min(minDot, glm::dot(n, m.coneAxis));
+            }
+            m.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+        }
+        return meshlets;
+    }
+
+    bool MeshOptimizer::isMeshletCulled(const MeshOptimizer::Meshlet &meshlet, glm::vec3 cameraPosition, const glm::vec4 *frustumPlanes, bool backFaceCulling) {
+        for (int i=0;i<6;i++){
+            if (glm::dot(glm::vec3(frustumPlanes[i]), meshlet.center) + frustumPlanes[i].w < -meshlet.radius){
+                return true;
+            }
+        }
+        // all triangles are back-facing if the camera is inside the (negative) normal cone
+        glm::vec3 toCenter = meshlet.center - cameraPosition;
+        return backFaceCulling && meshlet.coneCutoff < 1.0f && glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+    }
+}
@@ -8,16 +8,19 @@
 #include "sre/ModelImporter.hpp"
 #include "sre/Color.hpp"
 #include <algorithm>
+#include <map>
 #include <fstream>
 #include <string>
 #include <cstring>
 #include <sstream>
 #include <cerrno>
 #include <cctype>
-#include <unordered_map>
 #include "sre/Mesh.hpp"
 #include "sre/Log.hpp"
-#include <unordered_map>
+#include "sre/ResourceCache.hpp"
+#include "sre/impl/MappedFile.hpp"
+#include "sre/impl/ParallelFor.hpp"
+#include "sre/impl/VertexWelder.hpp"
 #include <glm/gtx/string_cast.hpp>
 #include "glm/glm.hpp"
 
@@ -27,26 +30,6 @@ using namespace glm;
 // anonymous namespace
 namespace {
 
-    // trim from start (in place)
-    inline void ltrim(std::string &s) {
-        s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](int ch) {
-            return !std::isspace(ch);
-        }));
-    }
-
-    // trim from end (in place)
-    inline void rtrim(std::string &s) {
-        s.erase(std::find_if(s.rbegin(), s.rend(), [](int ch) {
-            return !std::isspace(ch);
-        }).base(), s.end());
-    }
-
-    // trim from both ends (in place)
-    inline void trim(std::string &s) {
-        ltrim(s);
-        rtrim(s);
-    }
-
     const char kPathSeparator =
 #ifdef _WIN32
             '\\';
@@ -61,37 +44,6 @@ namespace {
             '/';
 #endif
 
-    // from http://stackoverflow.com/questions/2602013/read-whole-ascii-file-into-c-stdstring
-    string getFileContents(const string& filename)
-    {
-        ifstream in{filename, ios::in | ios::binary};
-        if (in)
-        {
-            std::string contents;
-            in.seekg(0, std::ios::end);
-            auto size = in.tellg();
-            if (size>0){
-                contents.resize((string::size_type)size);
-                in.seekg(0, std::ios::beg);
-                in.read(&contents[0], contents.size());
-            }
-            in.close();
-            return contents;
-        }
-        LOG_ERROR("Error reading %s. Error code: %i",filename.c_str(), errno);
-        return "";
-    }
-
-    std::string concat(std::vector<std::string> v, int from){
-        std::string res = v[from];
-        for (int i=from+1;i<v.size();i++){
-            res += " ";
-            res += v[i];
-        }
-        trim(res);
-        return res;
-    }
-
     std::string fixPathEnd(std::string &path){
         char lastChar = path[path.length()-1];
         if (lastChar != kPathSeparator){
@@ -121,45 +73,218 @@ namespace {
         return path;
     }
 
-    vec4 toVec4(vector<string> &tokens){
-        vec4 res{0,0,0,1};
-        for (int i=0;i<4;i++){
-            if (i+1 < tokens.size()){
-                res[i] = (float)atof(tokens[i+1].c_str());
-            }
+    // range of characters in the (memory mapped) file. Not null terminated
+    struct Token {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        bool empty() const {
+            return begin == end;
         }
-        return res;
+        bool equals(const char* s) const {
+            size_t length = strlen(s);
+            return (size_t)(end - begin) == length && memcmp(begin, s, length) == 0;
+        }
+        std::string str() const {
+            return std::string(begin, end);
+        }
+    };
+
+    inline bool isSpace(char c){
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
     }
 
-    vec3 toVec3(vector<string> &tokens){
-        vec3 res{0,0,0};
-        for (int i=0;i<3;i++){
-            if (i+1 < tokens.size()){
-                res[i] = (float)atof(tokens[i+1].c_str());
-            }
+    inline bool isDigit(char c){
+        return c >= '0' && c <= '9';
+    }
+
+    const size_t objMinChunkSize = 1024*1024;                       // bytes parsed by each worker thread (minimum)
+    const size_t objStreamWindowSize = 4*1024*1024;                 // bytes parsed before the pages are released when streaming
+
+    const double powersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    // handles nan, inf and other formats not handled by parseFloat
+    const char* parseFloatFallback(const char* p, const char* end, float& value){
+        char buffer[64];
+        size_t length = std::min((size_t)(end - p), sizeof(buffer) - 1);
+        memcpy(buffer, p, length);
+        buffer[length] = '\0';
+        char* parseEnd;
+        value = strtof(buffer, &parseEnd);
+        if (parseEnd == buffer){
+            return nullptr;
         }
-        return res;
+        return p + (parseEnd - buffer);
     }
 
-    sre::Color toColorRGB(vector<string> &tokens){
-        sre::Color res{0,0,0};
-        for (int i=0;i<3;i++){
-            if (i+1 < tokens.size()){
-                res[i] = (float)atof(tokens[i+1].c_str());
+    // parse a decimal floating point number (like from_chars). Returns the position after the number or nullptr
+    const char* parseFloat(const char* p, const char* end, float& value){
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')){
+            negative = *p == '-';
+            p++;
+        }
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;                                             // significant digits in mantissa
+        bool hasDigits = false;
+        for (; p < end && isDigit(*p); p++){
+            if (digits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+            } else {
+                exponent++;
             }
+            hasDigits = true;
         }
-        return res;
+        if (p < end && *p == '.'){
+            for (p++; p < end && isDigit(*p); p++){
+                if (digits < 19){
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa != 0;
+                    exponent--;
+                }
+                hasDigits = true;
+            }
+        }
+        if (!hasDigits){
+            return parseFloatFallback(start, end, value);
+        }
+        if (p < end && (*p == 'e' || *p == 'E')){
+            const char* e = p + 1;
+            bool negativeExponent = false;
+            if (e < end && (*e == '-' || *e == '+')){
+                negativeExponent = *e == '-';
+                e++;
+            }
+            if (e < end && isDigit(*e)){
+                int exponentValue = 0;
+                for (; e < end && isDigit(*e); e++){
+                    if (exponentValue < 10000){
+                        exponentValue = exponentValue * 10 + (*e - '0');
+                    }
+                }
+                exponent += negativeExponent ? -exponentValue : exponentValue;
+                p = e;
+            }
+        }
+        double result = (double)mantissa;
+        if (mantissa != 0 && exponent != 0){
+            if (exponent < 0 && exponent >= -22){
+                result /= powersOf10[-exponent];
+            } else if (exponent > 0 && exponent <= 22){
+                result *= powersOf10[exponent];
+            } else {
+                result *= std::pow(10.0, (double)exponent);
+            }
+        }
+        value = (float)(negative ? -result : result);
+        return p;
     }
 
-    // replace first occurrence of from in str with to
-    bool replace(std::string& str, const std::string& from, const std::string& to) {
-        size_t start_pos = str.find(from);
-        if(start_pos == std::string::npos)
-            return false;
-        str.replace(start_pos, from.length(), to);
-        return true;
+    // parse a decimal integer. Returns the position after the number or nullptr
+    const char* parseInt(const char* p, const char* end, int& value){
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')){
+            negative = *p == '-';
+            p++;
+        }
+        if (p == end || !isDigit(*p)){
+            return nullptr;
+        }
+        int res = 0;
+        for (; p < end && isDigit(*p); p++){
+            res = res * 10 + (*p - '0');
+        }
+        value = negative ? -res : res;
+        return p;
     }
 
+    // splits the file into lines and whitespace separated tokens without copying or allocating
+    class ObjTokenizer {
+    public:
+        ObjTokenizer(const char* data, size_t size)
+        :pos(data), dataEnd(data + size)
+        {
+        }
+
+        bool nextLine(){                                            // returns false at the end of the file
+            if (pos >= dataEnd){
+                return false;
+            }
+            cursor = pos;
+            auto newLine = (const char*)memchr(pos, '\n', dataEnd - pos);
+            lineEnd = newLine ? newLine : dataEnd;
+            pos = newLine ? newLine + 1 : dataEnd;
+            return true;
+        }
+
+        Token nextToken(){                                          // returns an empty token at the end of the line
+            while (cursor < lineEnd && isSpace(*cursor)){
+                cursor++;
+            }
+            Token token;
+            token.begin = cursor;
+            while (cursor < lineEnd && !isSpace(*cursor)){
+                cursor++;
+            }
+            token.end = cursor;
+            return token;
+        }
+
+        const char* position() const {                              // start of the next line
+            return pos;
+        }
+
+        Token rest(){                                               // remainder of the line (trimmed)
+            Token token{cursor, lineEnd};
+            while (token.begin < token.end && isSpace(*token.begin)){
+                token.begin++;
+            }
+            while (token.end > token.begin && isSpace(*(token.end - 1))){
+                token.end--;
+            }
+            cursor = lineEnd;
+            return token;
+        }
+
+        template<typename T>
+        T nextVector(T res, int count){                             // parse up to count floats (missing values keep the default)
+            for (int i=0;i<count;i++){
+                Token token = nextToken();
+                if (token.empty() || parseFloat(token.begin, token.end, res[i]) == nullptr){
+                    break;
+                }
+            }
+            return res;
+        }
+
+        float nextFloat(float defaultValue = 0){
+            Token token = nextToken();
+            float res = defaultValue;
+            if (!token.empty()){
+                parseFloat(token.begin, token.end, res);
+            }
+            return res;
+        }
+
+        int nextInt(int defaultValue = 0){
+            Token token = nextToken();
+            int res = defaultValue;
+            if (!token.empty()){
+                parseInt(token.begin, token.end, res);
+            }
+            return res;
+        }
+    private:
+        const char* pos;
+        const char* dataEnd;
+        const char* cursor = nullptr;
+        const char* lineEnd = nullptr;
+    };
+
     struct ObjGroup {
         int faceIndex;
         std::string name;
@@ -175,7 +300,6 @@ namespace {
         int textureIdx;
         int normalIdx;
     };
-    typedef std::vector<ObjVertex> ObjFace;
 
     enum class ObjIlluminationMode {
         Mode0 = 0, // Color on and Ambient off
@@ -225,113 +349,192 @@ namespace {
         std::string name;
     };
 
-    ObjFace toObjFace(vector<string> &tokens){
-        ObjFace res;
-        for (int i=1; i<tokens.size(); i++) {
-            string & p = tokens[i];
-            replace(p, "//","/0/");
-
-            ObjVertex o{0,0,0};
+    // parse a face vertex (v, v/vt, v//vn or v/vt/vn). Negative indices are relative to the end of the lists and are
+    // resolved against the counts parsed so far. The components that were relative are returned in relativeMask
+    // (bit 0: position, bit 1: texture, bit 2: normal)
+    bool parseObjVertex(const Token& token, ObjVertex& vertex, int& relativeMask, int positionCount, int textureCount, int normalCount){
+        vertex = {0,0,0};
+        relativeMask = 0;
+        const char* p = parseInt(token.begin, token.end, vertex.vertexPositionIdx);
+        if (p == nullptr || vertex.vertexPositionIdx == 0){
+            return false;
+        }
+        if (p < token.end && *p == '/'){
+            p++;
+            if (p < token.end && *p != '/'){
+                p = parseInt(p, token.end, vertex.textureIdx);
+            }
+            if (p != nullptr && p < token.end && *p == '/'){
+                parseInt(p + 1, token.end, vertex.normalIdx);
+            }
+        }
+        if (vertex.vertexPositionIdx < 0){
+            vertex.vertexPositionIdx += positionCount + 1;
+            relativeMask |= 1;
+        }
+        if (vertex.textureIdx < 0){
+            vertex.textureIdx += textureCount + 1;
+            relativeMask |= 2;
+        }
+        if (vertex.normalIdx < 0){
+            vertex.normalIdx += normalCount + 1;
+            relativeMask |= 4;
+        }
+        return true;
+    }
 
-            stringstream ss{p};
-            char buffer[50];
+    // result of parsing a range of lines. Face indices are local to the chunk, except relative vertex indices which
+    // are relative to the positions, texture coordinates and normals of the chunk until the chunks are merged
+    struct ObjChunk {
+        std::vector<glm::vec3> vertexPositions;
+        std::vector<glm::vec4> textureCoords;
+        std::vector<glm::vec3> normals;
+        std::vector<ObjVertex> faceVertices;                            // vertices of all faces
+        std::vector<int> faceStart;                                     // first vertex of each face in faceVertices
+        std::vector<std::pair<int,int>> relativeVertices;               // face vertex index and relative mask
+        std::vector<ObjGroup> namedObjects;
+        std::vector<ObjGroup> polygonGroups;
+        std::vector<SmoothGroup> smoothGroups;
+        std::vector<ObjMaterialChange> materialChanges;
+        std::vector<std::string> materialLibs;
+    };
 
-            ss.getline(buffer,50, '/');
-            o.vertexPositionIdx = atoi(buffer);
-            if (ss.good()){
-                ss.getline(buffer,50, '/');
-                o.textureIdx = atoi(buffer);
+    void parseObjChunk(const char* data, size_t size, ObjChunk& chunk, const std::string& filename){
+        ObjTokenizer tokenizer(data, size);
+        while (tokenizer.nextLine()){
+            Token keyword = tokenizer.nextToken();
+            if (keyword.empty() || *keyword.begin == '#'){                  // empty line or comment
+                continue;
             }
-            if (ss.good()){
-                ss.getline(buffer,50, '/');
-                o.normalIdx = atoi(buffer);
+            int currentIndex = static_cast<int>(chunk.faceStart.size()) + 1;
+            if (keyword.equals("v")){                                       // vertex position
+                chunk.vertexPositions.push_back(tokenizer.nextVector(vec3(0), 3));
+            } else if (keyword.equals("vt")){                               // vertex texture coordinates
+                chunk.textureCoords.push_back(tokenizer.nextVector(vec4(0), 4));
+            } else if (keyword.equals("vn")){                               // vertex normal
+                chunk.normals.push_back(tokenizer.nextVector(vec3(0), 3));
+            } else if (keyword.equals("f")){                                // face
+                int start = static_cast<int>(chunk.faceVertices.size());
+                size_t relativeStart = chunk.relativeVertices.size();
+                for (Token token = tokenizer.nextToken(); !token.empty(); token = tokenizer.nextToken()){
+                    ObjVertex vertex;
+                    int relativeMask;
+                    if (!parseObjVertex(token, vertex, relativeMask, (int)chunk.vertexPositions.size(), (int)chunk.textureCoords.size(), (int)chunk.normals.size())){
+                        LOG_WARNING("Invalid face vertex %s in %s", token.str().c_str(), filename.c_str());
+                        continue;
+                    }
+                    if (relativeMask != 0){
+                        chunk.relativeVertices.emplace_back((int)chunk.faceVertices.size(), relativeMask);
+                    }
+                    chunk.faceVertices.push_back(vertex);
+                }
+                if (chunk.faceVertices.size() - start < 3){                 // skip degenerate faces
+                    chunk.faceVertices.resize(start);
+                    chunk.relativeVertices.resize(relativeStart);
+                } else {
+                    chunk.faceStart.push_back(start);
+                }
+            } else if (keyword.equals("mtllib")){                           // material library
+                chunk.materialLibs.push_back(tokenizer.rest().str());
+            } else if (keyword.equals("usemtl")){                           // use material
+                chunk.materialChanges.push_back({currentIndex, tokenizer.rest().str()});
+            } else if (keyword.equals("o")){                                // named object
+                chunk.namedObjects.push_back({currentIndex, tokenizer.nextToken().str()});
+            } else if (keyword.equals("g")){                                // polygon group
+                chunk.polygonGroups.push_back({currentIndex, tokenizer.nextToken().str()});
+            } else if (keyword.equals("s")){                                // smoothing groups
+                Token token = tokenizer.nextToken();
+                int smoothingGroup = 0;                                     // 0 = no smoothing
+                if (!token.equals("off")){
+                    parseInt(token.begin, token.end, smoothingGroup);
+                }
+                chunk.smoothGroups.push_back({currentIndex, smoothingGroup});
             }
-            res.push_back(o);
         }
-        return move(res);
     }
 
-    void parseMaterialLib(std::string & materialLib, std::vector<ObjMaterial>& materials){
-        const int bufferSize = 256;
-        char buffer[bufferSize];
-        char buffer2[bufferSize];
-        stringstream ss{materialLib};
-
-        while (ss.good()){
-            ss.getline(buffer, bufferSize);
-            stringstream likeTokensizer{buffer};
-            vector<string> tokens;
-            while (likeTokensizer.good()) {
-                likeTokensizer.getline(buffer2, bufferSize, ' ');
-                tokens.emplace_back(buffer2);
+    // split the data at line boundaries in up to maxChunks chunks of at least minChunkSize bytes
+    std::vector<std::pair<const char*, size_t>> splitLines(const char* data, size_t size, size_t maxChunks, size_t minChunkSize){
+        std::vector<std::pair<const char*, size_t>> res;
+        size_t chunkCount = std::max((size_t)1, std::min(maxChunks, size / minChunkSize));
+        size_t chunkSize = size / chunkCount;
+        const char* end = data + size;
+        const char* begin = data;
+        for (size_t i=1;i<chunkCount && begin < end;i++){
+            const char* split = std::max(begin, data + i * chunkSize);
+            auto newLine = (const char*)memchr(split, '\n', end - split);
+            if (newLine == nullptr){
+                break;
             }
-            if (tokens.empty()){
+            res.emplace_back(begin, newLine + 1 - begin);
+            begin = newLine + 1;
+        }
+        if (begin < end || res.empty()){
+            res.emplace_back(begin, end - begin);
+        }
+        return res;
+    }
+
+    template<typename T>
+    void appendGroups(std::vector<T>& dst, const std::vector<T>& src, int faceOffset){
+        for (auto& group : src){
+            dst.push_back(group);
+            dst.back().faceIndex += faceOffset;
+        }
+    }
+
+    void parseMaterialLib(const char* data, size_t size, std::vector<ObjMaterial>& materials){
+        ObjTokenizer tokenizer(data, size);
+        while (tokenizer.nextLine()){
+            Token keyword = tokenizer.nextToken();
+            if (keyword.empty()){
                 continue;
             }
-            if (tokens[0] == "newmtl"){
+            if (keyword.equals("newmtl")){
                 sre::Color zero{0,0,0};
-                auto name = concat(tokens,1);
-                ObjMaterial material{replaceAll(name,"\r",""),zero,zero,zero,50,1};
+                ObjMaterial material{tokenizer.rest().str(),zero,zero,zero,50,1};
                 materials.push_back(material);
             } else {
                 if (materials.empty()){
                     continue;
                 }
                 ObjMaterial & currentMat = materials.back();
-                if (tokens[0] == "Ka"){
-                    currentMat.ambientColor = toColorRGB(tokens);
-                } else if (tokens[0] == "Kd"){
-                    currentMat.diffuseColor = toColorRGB(tokens);
-                } else if (tokens[0] == "Ks"){
-                    currentMat.specularColor = toColorRGB(tokens);
-                } else if (tokens[0] == "d"){
-                    currentMat.transparent = (float)atof(tokens[1].c_str());
-                } else if (tokens[0] == "illum"){
-                    int illumMode = atoi(tokens[1].c_str());
+                if (keyword.equals("Ka")){
+                    currentMat.ambientColor = tokenizer.nextVector(sre::Color{0,0,0}, 3);
+                } else if (keyword.equals("Kd")){
+                    currentMat.diffuseColor = tokenizer.nextVector(sre::Color{0,0,0}, 3);
+                } else if (keyword.equals("Ks")){
+                    currentMat.specularColor = tokenizer.nextVector(sre::Color{0,0,0}, 3);
+                } else if (keyword.equals("d")){
+                    currentMat.transparent = tokenizer.nextFloat();
+                } else if (keyword.equals("illum")){
+                    int illumMode = tokenizer.nextInt();
                     currentMat.illuminationModes.push_back(static_cast<ObjIlluminationMode>(illumMode));
-                } else if (tokens[0] == "map_Ka"){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::Ambient});
-                } else if (tokens[0] == "map_Kd"){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::Diffuse});
-                } else if (tokens[0] == "map_Ks"){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::Specular});
-                } else if (tokens[0] == "map_Ns"){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::SpecularCoeficient});
-                } else if (tokens[0] == "map_d"){
-
-                } else if (tokens[0] == "map_bump" || tokens[0] == "bump" ){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::Bump});
-                } else if (tokens[0] == "map_disp" || tokens[0] == "disp" ){
-                    currentMat.textureMaps.push_back({tokens[1], ObjTextureMapType::Displacement});
-                } else if (tokens[0] == "map_decal" || tokens[0] == "decal" ){
+                } else if (keyword.equals("map_Ka")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::Ambient});
+                } else if (keyword.equals("map_Kd")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::Diffuse});
+                } else if (keyword.equals("map_Ks")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::Specular});
+                } else if (keyword.equals("map_Ns")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::SpecularCoeficient});
+                } else if (keyword.equals("map_d")){
+
+                } else if (keyword.equals("map_bump") || keyword.equals("bump")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::Bump});
+                } else if (keyword.equals("map_disp") || keyword.equals("disp")){
+                    currentMat.textureMaps.push_back({tokenizer.nextToken().str(), ObjTextureMapType::Displacement});
+                } else if (keyword.equals("map_decal") || keyword.equals("decal")){
 
                 }
             }
         }
     }
 
-    struct ObjVertexHash {
-        std::size_t operator()(const ObjVertex& k) const {
-            return (( k.vertexPositionIdx << 16 ) ^ ( k.textureIdx << 8 )) ^ k.normalIdx;
-        }
-    };
-
-    struct ObjVertexEqual {
-        bool operator()(const ObjVertex& lhs, const ObjVertex& rhs) const {
-            return lhs.vertexPositionIdx == rhs.vertexPositionIdx &&
-                   lhs.textureIdx == rhs.textureIdx &&
-                   lhs.normalIdx == rhs.normalIdx;
-        }
-    };
-    using ObjVertexHashTable = std::unordered_map<ObjVertex,int,ObjVertexHash, ObjVertexEqual>;
-
-    int getCreateIndex(ObjVertex &vertexIndex, int nextIndex, ObjVertexHashTable& usedVertices){
-        auto pos = usedVertices.find(vertexIndex);
-        if (pos != usedVertices.end()){
-            return pos->second;
-        }
-        usedVertices.emplace(vertexIndex, nextIndex);
-        return nextIndex;
+    // returns the interleaved index of the vertex (the current vertex count if the vertex is new)
+    int getCreateIndex(const ObjVertex &vertexIndex, sre::VertexWelder& usedVertices){
+        uint32_t key[] = {(uint32_t)vertexIndex.vertexPositionIdx, (uint32_t)vertexIndex.textureIdx, (uint32_t)vertexIndex.normalIdx};
+        return usedVertices.insert(key);
     }
 
     struct ObjInterleavedIndex {
@@ -339,23 +542,26 @@ namespace {
         std::vector<uint16_t> vertexIndices;
     };
 
-    shared_ptr<sre::Material> createMaterial(const std::string& materialName, const std::vector<ObjMaterial>& matVector, std::string path) {
+    const ObjMaterial* findMaterial(const std::string& materialName, const std::vector<ObjMaterial>& matVector) {
         if (matVector.empty()){
-            auto shader = sre::Shader::getStandardBlinnPhong();
-            auto mat = shader->createMaterial();
-            return mat;
+            return nullptr;
         }
-        const ObjMaterial* foundMat = nullptr;
         for (auto & v : matVector){
             if (v.name == materialName
                 || materialName.empty()){ // empty is used for default material
-                foundMat = &v;
-                break;
+                return &v;
             }
         }
+        LOG_WARNING("Could not find material %s",materialName.c_str());
+        return matVector.data();
+    }
+
+    shared_ptr<sre::Material> createMaterial(const std::string& materialName, const std::vector<ObjMaterial>& matVector, std::string path) {
+        const ObjMaterial* foundMat = findMaterial(materialName, matVector);
         if (foundMat == nullptr){
-            LOG_WARNING("Could not find material ",materialName.c_str());
-            foundMat = matVector.data();
+            auto shader = sre::Shader::getStandardBlinnPhong();
+            auto mat = shader->createMaterial();
+            return mat;
         }
         auto shader = sre::Shader::getStandardBlinnPhong();
         auto mat = shader->createMaterial();
@@ -366,7 +572,7 @@ namespace {
         auto name = materialName;
         for (auto & map :foundMat->textureMaps){
             if (map.type == ObjTextureMapType::Diffuse){
-                mat->setTexture(sre::Texture::create().withFile(fixPath(path+map.filename)).build());
+                mat->setTexture(sre::ResourceCache::getTexture(fixPath(path+map.filename)));
                 name+=" "+map.filename;
             }
         }
@@ -374,6 +580,106 @@ namespace {
         return mat;
     }
 
+
+    // mesh under construction in importObjStreaming. Face vertices are deduplicated per mesh
+    class ObjStreamMesh {
+    public:
+        int getVertexCount() const {
+            return (int)positions.size();
+        }
+
+        bool empty() const {
+            return indices.empty();
+        }
+
+        void setMaterial(const std::string& name){
+            materialName = name;
+            currentIndex = nullptr;
+        }
+
+        void addFace(const ObjVertex* faceVertex, int faceSize, const std::vector<glm::vec3>& vertexPositions,
+                     const std::vector<glm::vec4>& textureCoords, const std::vector<glm::vec3>& normals){
+            if (currentIndex == nullptr){
+                for (auto& idx : indices){
+                    if (idx.materialName == materialName){
+                        currentIndex = &idx;
+                    }
+                }
+                if (currentIndex == nullptr){
+                    indices.push_back({materialName, {}});
+                    currentIndex = &indices.back();
+                }
+            }
+            for (int i=2;i < faceSize;i++){
+                int triangle[] = {0, i-1, i};
+                for (int triangleIndex : triangle){
+                    auto & vertexIndexObject = faceVertex[triangleIndex];
+                    int vertexCount = getVertexCount();
+                    int vertexIndex = getCreateIndex(vertexIndexObject, usedVertices);
+                    if (vertexIndex == vertexCount){
+                        positions.push_back(vertexPositions[vertexIndexObject.vertexPositionIdx - 1]);
+                        vec4 textureCoord{0,0,0,0};
+                        if (vertexIndexObject.textureIdx > 0 && vertexIndexObject.textureIdx <= textureCoords.size()){
+                            textureCoord = textureCoords[vertexIndexObject.textureIdx - 1];
+                            includeTextureCoordinates = true;
+                        }
+                        vec3 normal{0,0,0};
+                        if (vertexIndexObject.normalIdx > 0 && vertexIndexObject.normalIdx <= normals.size()){
+                            normal = normals[vertexIndexObject.normalIdx - 1];
+                            includeNormals = true;
+                        }
+                        finalTextureCoordinates.push_back(textureCoord);
+                        finalNormals.push_back(normal);
+                    }
+                    currentIndex->vertexIndices.emplace_back(vertexIndex);
+                }
+            }
+        }
+
+        std::shared_ptr<sre::Mesh> build(const std::function<std::shared_ptr<sre::Material>(const std::string&)>& getMaterial,
+                                         std::vector<std::shared_ptr<sre::Material>>& outMaterials, bool useGeometryArena){
+            auto&& meshBuilder = sre::Mesh::create();
+            meshBuilder.withGeometryArena(useGeometryArena);
+            meshBuilder.withPositions(positions);
+            if (includeTextureCoordinates){
+                meshBuilder.withUVs(finalTextureCoordinates);
+            }
+            if (includeNormals){
+                meshBuilder.withNormals(finalNormals);
+            }
+            int indexSet = 0;
+            for (auto& idx : indices){
+                if (idx.vertexIndices.empty()){
+                    continue;
+                }
+                outMaterials.push_back(getMaterial(idx.materialName));
+                meshBuilder.withIndices(idx.vertexIndices, sre::MeshTopology::Triangles, indexSet++);
+            }
+            return meshBuilder.build();
+        }
+
+        void clear(){
+            positions.clear();
+            finalTextureCoordinates.clear();
+            finalNormals.clear();
+            indices.clear();
+            usedVertices.clear();
+            currentIndex = nullptr;
+            includeTextureCoordinates = false;
+            includeNormals = false;
+        }
+    private:
+        std::string materialName;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec4> finalTextureCoordinates;
+        std::vector<glm::vec3> finalNormals;
+        std::vector<ObjInterleavedIndex> indices;
+        ObjInterleavedIndex* currentIndex = nullptr;
+        sre::VertexWelder usedVertices{3};
+        bool includeTextureCoordinates = false;
+        bool includeNormals = false;
+    };
+
 }
 
 std::shared_ptr<sre::Mesh> sre::ModelImporter::importObj(std::string path, std::string filename){
@@ -381,88 +687,134 @@ std::shared_ptr<sre::Mesh> sre::ModelImporter::importObj(std::string path, std::
     return sre::ModelImporter::importObj(path, filename, outModelMaterials);
 }
 
+// parsed obj model (vertices are interleaved and indexed per material)
+struct sre::ModelImporter::ObjModel {
+    std::string path;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec4> textureCoordinates;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjInterleavedIndex> indices;
+    std::vector<ObjMaterial> materials;
+};
+
 std::shared_ptr<sre::Mesh> sre::ModelImporter::importObj(std::string path, std::string filename, std::vector<std::shared_ptr<Material>>& outModelMaterials) {
+    auto model = parseObj(path, filename);
+    if (!model){
+        return {};
+    }
+    // decode the textures in parallel (kept alive in the cache until the materials are created)
+    auto files = getTextureFiles(*model);
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    auto textures = ResourceCache::getTextures(files);
+    return buildObj(*model, outModelMaterials);
+}
+
+std::shared_ptr<sre::ModelImporter::ObjModel> sre::ModelImporter::parseObj(std::string path, std::string filename) {
     path = fixPathEnd(path);
-    string file = getFileContents(path+filename);
+    MappedFile file;
+    if (!file.open(path+filename)){
+        LOG_ERROR("Cannot open %s", (path+filename).c_str());
+        return {};
+    }
+
+    // parse chunks of lines in parallel
+    auto ranges = splitLines(file.data(), file.size(), (size_t)parallelForThreadCount(), objMinChunkSize);
+    std::vector<ObjChunk> chunks(ranges.size());
+    parallelFor(ranges.size(), 1, [&](size_t begin, size_t end){
+        for (size_t i = begin; i < end; i++){
+            parseObjChunk(ranges[i].first, ranges[i].second, chunks[i], filename);
+        }
+    });
+
+    // merge chunks using the prefix sum of the element counts
+    struct ChunkOffset {
+        int position = 0;
+        int textureCoord = 0;
+        int normal = 0;
+        int faceVertex = 0;
+        int face = 0;
+    };
+    std::vector<ChunkOffset> offsets(chunks.size() + 1);
+    for (size_t i=0;i<chunks.size();i++){
+        offsets[i+1].position = offsets[i].position + (int)chunks[i].vertexPositions.size();
+        offsets[i+1].textureCoord = offsets[i].textureCoord + (int)chunks[i].textureCoords.size();
+        offsets[i+1].normal = offsets[i].normal + (int)chunks[i].normals.size();
+        offsets[i+1].faceVertex = offsets[i].faceVertex + (int)chunks[i].faceVertices.size();
+        offsets[i+1].face = offsets[i].face + (int)chunks[i].faceStart.size();
+    }
+    auto& total = offsets.back();
+    std::vector<glm::vec3> vertexPositions(total.position);
+    std::vector<glm::vec4> textureCoords(total.textureCoord);
+    std::vector<glm::vec3> normals(total.normal);
+    std::vector<ObjVertex> faceVertices(total.faceVertex);              // vertices of all faces
+    std::vector<int> faceStart(total.face + 1);                         // first vertex of each face in faceVertices
+    parallelFor(chunks.size(), 1, [&](size_t begin, size_t end){
+        for (size_t i = begin; i < end; i++){
+            auto& chunk = chunks[i];
+            auto& offset = offsets[i];
+            std::copy(chunk.vertexPositions.begin(), chunk.vertexPositions.end(), vertexPositions.begin() + offset.position);
+            std::copy(chunk.textureCoords.begin(), chunk.textureCoords.end(), textureCoords.begin() + offset.textureCoord);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offset.normal);
+            std::copy(chunk.faceVertices.begin(), chunk.faceVertices.end(), faceVertices.begin() + offset.faceVertex);
+            for (size_t f=0;f<chunk.faceStart.size();f++){
+                faceStart[offset.face + f] = chunk.faceStart[f] + offset.faceVertex;
+            }
+            // resolve relative indices
+            for (auto& relative : chunk.relativeVertices){
+                auto& vertex = faceVertices[offset.faceVertex + relative.first];
+                if (relative.second & 1){
+                    vertex.vertexPositionIdx += offset.position;
+                }
+                if (relative.second & 2){
+                    vertex.textureIdx += offset.textureCoord;
+                }
+                if (relative.second & 4){
+                    vertex.normalIdx += offset.normal;
+                }
+            }
+        }
+    });
+    faceStart.back() = total.faceVertex;                                // sentinel
 
-    std::vector<glm::vec3> vertexPositions;
-    std::vector<glm::vec4> textureCoords;
-    std::vector<glm::vec3> normals;
-    std::vector<ObjFace> faces;
     std::vector<ObjGroup> namedObjects;
     std::vector<ObjGroup> polygonGroups;
     std::vector<SmoothGroup> smoothGroups;
     std::vector<ObjMaterialChange> materialChanges;
     std::vector<ObjMaterial> materials;
-
-    stringstream ss{file};
-    const int bufferSize = 256;
-    char buffer[bufferSize];
-    char buffer2[bufferSize];
-    while (ss.good()){
-        ss.getline(buffer, bufferSize);
-        stringstream likeTokensizer{buffer};
-        vector<string> tokens;
-        while (likeTokensizer.good()) {
-            likeTokensizer.getline(buffer2, bufferSize, ' ');
-			int buffer2Length = static_cast<int>(strlen(buffer2));
-            for (int i=0;i<buffer2Length;i++){
-                if (isspace(buffer2[i])){
-                    buffer2[i] = '\0';
-                }
-
+    for (size_t i=0;i<chunks.size();i++){
+        appendGroups(namedObjects, chunks[i].namedObjects, offsets[i].face);
+        appendGroups(polygonGroups, chunks[i].polygonGroups, offsets[i].face);
+        appendGroups(smoothGroups, chunks[i].smoothGroups, offsets[i].face);
+        appendGroups(materialChanges, chunks[i].materialChanges, offsets[i].face);
+        for (auto& materialLibName : chunks[i].materialLibs){
+            MappedFile materialLib;
+            string materialLibFilename = fixPath(path+materialLibName);
+            if (materialLib.open(materialLibFilename)){
+                parseMaterialLib(materialLib.data(), materialLib.size(), materials);
+            } else {
+                LOG_WARNING("Cannot open material library %s", materialLibFilename.c_str());
             }
-            tokens.emplace_back(buffer2);
-        }
-        if (tokens.empty()){
-            continue;
-        }
-        int currentIndex = static_cast<int>(faces.size()) + 1;
-        if (tokens[0] == "#"){                                          // comment
-            // ignore
-        } else if (tokens[0] == "v"){                                   // vertex position
-            vec3 vertexPosition = toVec3(tokens);
-            vertexPositions.push_back(vertexPosition);
-        } else if (tokens[0] == "vt"){                                  // vertex texture coordinates
-            vec4 textureCoord = toVec4(tokens);
-            textureCoords.push_back(textureCoord);
-        } else if (tokens[0] == "vn"){                                  // vertex normal
-            vec3 normal = toVec3(tokens);
-            normals.push_back(normal);
-        } else if (tokens[0] == "f"){                                   // face
-            faces.push_back(toObjFace(tokens));
-        } else if (tokens[0] == "mtllib"){                              // material library
-            string materialLib = getFileContents(fixPath(path+tokens[1]));
-            parseMaterialLib(materialLib, materials);
-        } else if (tokens[0] == "usemtl"){                              // use material
-            materialChanges.push_back({currentIndex, concat(tokens,1)});
-        } else if (tokens[0] == "o"){                                   // named object
-            namedObjects.push_back({currentIndex, tokens[1]});
-        } else if (tokens[0] == "g"){                                   // polygon group
-            polygonGroups.push_back({currentIndex, tokens[1]});
-        } else if (tokens[0] == "s"){                                   // smoothing groups
-            int smoothingGroup = 0;                                     // 0 = no smoothing
-            if (tokens[1] != "off"){
-                smoothingGroup = atoi(tokens[1].c_str());
-            }
-            smoothGroups.push_back({currentIndex, smoothingGroup});
         }
     }
+    chunks.clear();
+
 
     int vertexCount = 0;
     int faceCount = 0;
+    int invalidFaces = 0;
 
     std::vector<ObjInterleavedIndex> indices;
     ObjInterleavedIndex * currentIndex = nullptr;
     auto materialChange = materialChanges.cbegin();
     bool includeTextureCoordinates = !textureCoords.empty();
     bool includeNormals = !normals.empty();
-    ObjVertexHashTable usedVertices{42,ObjVertexHash{}, ObjVertexEqual{}};
+    VertexWelder usedVertices{3, total.position};
     std::vector<glm::vec3> finalPositions;
     std::vector<glm::vec4> finalTextureCoordinates;
     std::vector<glm::vec3> finalNormals;
     bool firstFace = true;
-    for (auto & face : faces){
+    for (int face = 0; face + 1 < faceStart.size(); face++){
         faceCount++;
         if (materialChange != materialChanges.end() || firstFace){
             if (firstFace && materialChange == materialChanges.end()){
@@ -487,21 +839,31 @@ std::shared_ptr<sre::Mesh> sre::ModelImporter::importObj(std::string path, std::
             firstFace = false;
         }
 
-        for (int i=2;i < face.size();i++){
+        const ObjVertex* faceVertex = faceVertices.data() + faceStart[face];
+        int faceSize = faceStart[face + 1] - faceStart[face];
+        bool validFace = true;
+        for (int i=0;i<faceSize;i++){
+            validFace &= faceVertex[i].vertexPositionIdx > 0 && faceVertex[i].vertexPositionIdx <= vertexPositions.size();
+        }
+        if (!validFace){
+            invalidFaces++;
+            continue;
+        }
+        for (int i=2;i < faceSize;i++){
             int triangle[] = {0, i-1, i};
             for (int triangleIndex : triangle){
-                auto & vertexIndexObject = face[triangleIndex];
-                int vertexIndex = getCreateIndex(vertexIndexObject, vertexCount, usedVertices);
+                auto & vertexIndexObject = faceVertex[triangleIndex];
+                int vertexIndex = getCreateIndex(vertexIndexObject, usedVertices);
                 bool existInInterleavedData = vertexIndex != vertexCount;
                 if (!existInInterleavedData){
                     // read data
                     vec3 vertexPosition = vertexPositions[vertexIndexObject.vertexPositionIdx - 1];
                     vec4 textureCoord{0,0,0,0};
-                    if (vertexIndexObject.textureIdx > 0 && includeTextureCoordinates){
+                    if (vertexIndexObject.textureIdx > 0 && vertexIndexObject.textureIdx <= textureCoords.size()){
                         textureCoord = textureCoords[vertexIndexObject.textureIdx - 1];
                     }
                     vec3 normal;
-                    if (vertexIndexObject.normalIdx > 0 && includeNormals){
+                    if (vertexIndexObject.normalIdx > 0 && vertexIndexObject.normalIdx <= normals.size()){
                         normal = normals[vertexIndexObject.normalIdx-1];
                     }
                     // write interleaved data
@@ -519,24 +881,186 @@ std::shared_ptr<sre::Mesh> sre::ModelImporter::importObj(std::string path, std::
         }
     }
 
+    if (invalidFaces > 0){
+        LOG_WARNING("%s has %i faces with invalid vertex indices", filename.c_str(), invalidFaces);
+    }
+
     // remove unused materials
     indices.erase(std::remove_if(indices.begin(), indices.end(), [](const ObjInterleavedIndex &a){ return a.vertexIndices.size()==0;}),
                   indices.end());
 
-    auto&& meshBuilder = Mesh::create();
-    meshBuilder.withPositions(finalPositions);
+    auto model = std::make_shared<ObjModel>();
+    model->path = path;
+    model->positions = std::move(finalPositions);
     if (includeTextureCoordinates){
-        meshBuilder.withUVs(finalTextureCoordinates);
+        model->textureCoordinates = std::move(finalTextureCoordinates);
     }
     if (includeNormals){
-        meshBuilder.withNormals(finalNormals);
+        model->normals = std::move(finalNormals);
+    }
+    model->indices = std::move(indices);
+    model->materials = std::move(materials);
+    return model;
+}
+
+std::vector<std::string> sre::ModelImporter::getTextureFiles(ObjModel &model) {
+    std::vector<std::string> res;
+    for (auto& index : model.indices){
+        auto material = findMaterial(index.materialName, model.materials);
+        if (material == nullptr){
+            continue;
+        }
+        for (auto & map : material->textureMaps){
+            if (map.type == ObjTextureMapType::Diffuse){
+                res.push_back(fixPath(model.path+map.filename));
+            }
+        }
+    }
+    return res;
+}
+
+std::shared_ptr<sre::Mesh> sre::ModelImporter::buildObj(ObjModel &model, std::vector<std::shared_ptr<Material>> &outModelMaterials) {
+    auto&& meshBuilder = Mesh::create();
+    meshBuilder.withPositions(model.positions);
+    if (!model.textureCoordinates.empty()){
+        meshBuilder.withUVs(model.textureCoordinates);
+    }
+    if (!model.normals.empty()){
+        meshBuilder.withNormals(model.normals);
     }
 
-    for (int i=0;i<indices.size();i++){
-        outModelMaterials.push_back(createMaterial(indices[i].materialName, materials, path));
-        meshBuilder.withIndices(indices[i].vertexIndices, MeshTopology::Triangles, i);
+    for (int i=0;i<model.indices.size();i++){
+        outModelMaterials.push_back(createMaterial(model.indices[i].materialName, model.materials, model.path));
+        meshBuilder.withIndices(model.indices[i].vertexIndices, MeshTopology::Triangles, i);
     }
 
     return meshBuilder.build();
 }
 
+bool sre::ModelImporter::importObjStreaming(std::string path, std::string filename,
+                                            std::function<void(std::shared_ptr<Mesh>, std::vector<std::shared_ptr<Material>>&)> onMesh,
+                                            int vertexBudget, bool splitAtGroups) {
+    return streamObj(path, filename, [&](const std::string&, std::shared_ptr<Mesh> mesh, std::vector<std::shared_ptr<Material>>& materials){
+        onMesh(mesh, materials);
+    }, vertexBudget, splitAtGroups, false);
+}
+
+std::vector<sre::ModelImporter::ObjPart> sre::ModelImporter::importObjParts(std::string path, std::string filename, int vertexBudget) {
+    std::vector<ObjPart> parts;
+    streamObj(path, filename, [&](const std::string& name, std::shared_ptr<Mesh> mesh, std::vector<std::shared_ptr<Material>>& materials){
+        parts.push_back({name, mesh, materials});
+    }, vertexBudget, true, true);
+    return parts;
+}
+
+bool sre::ModelImporter::streamObj(std::string path, std::string filename,
+                                   std::function<void(const std::string&, std::shared_ptr<Mesh>, std::vector<std::shared_ptr<Material>>&)> onMesh,
+                                   int vertexBudget, bool splitAtGroups, bool useGeometryArena) {
+    path = fixPathEnd(path);
+    MappedFile file;
+    if (!file.open(path+filename)){
+        LOG_ERROR("Cannot open %s", (path+filename).c_str());
+        return false;
+    }
+    if (vertexBudget < 3 || vertexBudget > 65536){
+        LOG_WARNING("Vertex budget %i out of range [3;65536]", vertexBudget);
+        vertexBudget = glm::clamp(vertexBudget, 3, 65536);
+    }
+
+    // the vertex attributes must be kept since faces may reference any previous vertex. Memory therefore grows with the
+    // attribute count of the file; only the output meshes (and the parsed pages of the mapped file) are bounded
+    std::vector<glm::vec3> vertexPositions;
+    std::vector<glm::vec4> textureCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjMaterial> materials;
+    std::vector<ObjVertex> faceVertices;
+    ObjStreamMesh mesh;
+    std::string groupName;
+
+    // materials are shared between the meshes
+    std::map<std::string, std::shared_ptr<Material>> createdMaterials;
+    auto getMaterial = [&](const std::string& name){
+        auto& material = createdMaterials[name];
+        if (!material){
+            material = createMaterial(name, materials, path);
+        }
+        return material;
+    };
+
+    auto emitMesh = [&](){
+        if (mesh.empty()){
+            return;
+        }
+        std::vector<std::shared_ptr<Material>> meshMaterials;
+        auto res = mesh.build(getMaterial, meshMaterials, useGeometryArena);
+        mesh.clear();
+        onMesh(groupName, res, meshMaterials);
+    };
+
+    ObjTokenizer tokenizer(file.data(), file.size());
+    size_t discarded = 0;
+    int invalidFaces = 0;
+    while (tokenizer.nextLine()){
+        // release the pages of the mapped file which has been parsed
+        size_t parsed = tokenizer.position() - file.data();
+        if (parsed - discarded >= objStreamWindowSize){
+            file.discard(discarded, parsed - discarded);
+            discarded = parsed;
+        }
+
+        Token keyword = tokenizer.nextToken();
+        if (keyword.empty() || *keyword.begin == '#'){                  // empty line or comment
+            continue;
+        }
+        if (keyword.equals("v")){                                       // vertex position
+            vertexPositions.push_back(tokenizer.nextVector(vec3(0), 3));
+        } else if (keyword.equals("vt")){                               // vertex texture coordinates
+            textureCoords.push_back(tokenizer.nextVector(vec4(0), 4));
+        } else if (keyword.equals("vn")){                               // vertex normal
+            normals.push_back(tokenizer.nextVector(vec3(0), 3));
+        } else if (keyword.equals("f")){                                // face
+            faceVertices.clear();
+            bool validFace = true;
+            for (Token token = tokenizer.nextToken(); !token.empty(); token = tokenizer.nextToken()){
+                ObjVertex vertex;
+                int relativeMask;
+                validFace &= parseObjVertex(token, vertex, relativeMask, (int)vertexPositions.size(), (int)textureCoords.size(), (int)normals.size())
+                             && vertex.vertexPositionIdx > 0 && vertex.vertexPositionIdx <= vertexPositions.size();
+                faceVertices.push_back(vertex);
+            }
+            int faceSize = (int)faceVertices.size();
+            if (!validFace || faceSize < 3){
+                invalidFaces++;
+                continue;
+            }
+            if (mesh.getVertexCount() + faceSize > vertexBudget){
+                emitMesh();
+            }
+            if (faceSize > vertexBudget){
+                invalidFaces++;
+                continue;
+            }
+            mesh.addFace(faceVertices.data(), faceSize, vertexPositions, textureCoords, normals);
+        } else if (keyword.equals("mtllib")){                           // material library
+            MappedFile materialLib;
+            string materialLibFilename = fixPath(path+tokenizer.rest().str());
+            if (materialLib.open(materialLibFilename)){
+                parseMaterialLib(materialLib.data(), materialLib.size(), materials);
+            } else {
+                LOG_WARNING("Cannot open material library %s", materialLibFilename.c_str());
+            }
+        } else if (keyword.equals("usemtl")){                           // use material
+            mesh.setMaterial(tokenizer.rest().str());
+        } else if (keyword.equals("o") || keyword.equals("g")){         // named object or polygon group
+            if (splitAtGroups){
+                emitMesh();
+            }
+            groupName = tokenizer.rest().str();
+        }
+    }
+    emitMesh();
+    if (invalidFaces > 0){
+        LOG_WARNING("%s has %i invalid faces", filename.c_str(), invalidFaces);
+    }
+    return true;
+}
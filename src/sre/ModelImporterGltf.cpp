@@ -0,0 +1,928 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/ModelImporter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include "sre/Mesh.hpp"
+#include "sre/Texture.hpp"
+#include "sre/Shader.hpp"
+#include "sre/Color.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/MappedFile.hpp"
+#include "picojson.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+namespace {
+    const uint32_t glbMagic = 0x46546C67;                           // "glTF"
+    const uint32_t glbChunkJson = 0x4E4F534A;                       // "JSON"
+    const uint32_t glbChunkBin = 0x004E4942;                        // "BIN\0"
+    const int maxNodeDepth = 64;                                    // guards against cycles in the node hierarchy
+
+    enum GltfComponentType {
+        GltfByte = 5120,
+        GltfUnsignedByte = 5121,
+        GltfShort = 5122,
+        GltfUnsignedShort = 5123,
+        GltfUnsignedInt = 5125,
+        GltfFloat = 5126
+    };
+
+    enum GltfFilter {
+        GltfNearest = 9728,
+        GltfNearestMipmapNearest = 9984
+    };
+
+    struct GltfBufferView {
+        int buffer = -1;
+        size_t byteOffset = 0;
+        size_t byteLength = 0;
+        size_t byteStride = 0;                                      // 0: tightly packed
+    };
+
+    struct GltfAccessor {
+        int bufferView = -1;                                        // -1: all zeros
+        size_t byteOffset = 0;
+        int componentType = 0;
+        bool normalized = false;
+        size_t count = 0;
+        int components = 0;                                         // 0 for matrix types (unsupported)
+        bool sparse = false;
+        bool hasMinMax = false;
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // glTF attributes mapped to the vertex attributes of the standard shaders
+    const std::pair<const char*, const char*> gltfAttributeNames[] = {
+            {"POSITION",   "position"},
+            {"NORMAL",     "normal"},
+            {"TEXCOORD_0", "uv"},
+            {"TANGENT",    "tangent"},
+            {"COLOR_0",    "vertex_color"}
+    };
+
+    const picojson::value& member(const picojson::value& value, const char* name){
+        static const picojson::value null;
+        if (!value.is<picojson::object>()){
+            return null;
+        }
+        auto& object = value.get<picojson::object>();
+        auto iter = object.find(name);
+        return iter == object.end() ? null : iter->second;
+    }
+
+    const picojson::value& element(const picojson::value& value, int index){
+        static const picojson::value null;
+        if (!value.is<picojson::array>() || index < 0 || index >= (int)value.get<picojson::array>().size()){
+            return null;
+        }
+        return value.get<picojson::array>()[index];
+    }
+
+    int arraySize(const picojson::value& value){
+        return value.is<picojson::array>() ? (int)value.get<picojson::array>().size() : 0;
+    }
+
+    double number(const picojson::value& value, double defaultValue){
+        return value.is<double>() ? value.get<double>() : defaultValue;
+    }
+
+    int integer(const picojson::value& value, int defaultValue = -1){
+        return value.is<double>() ? (int)value.get<double>() : defaultValue;
+    }
+
+    // byte offsets, lengths and counts. Negative or huge values return SIZE_MAX, which fails the range checks
+    size_t byteCount(const picojson::value& value){
+        double res = number(value, 0);
+        return res >= 0 && res < (double)(std::numeric_limits<size_t>::max() / 2) ? (size_t)res : std::numeric_limits<size_t>::max();
+    }
+
+    std::string getString(const picojson::value& value){
+        return value.is<std::string>() ? value.get<std::string>() : std::string();
+    }
+
+    template<typename T>
+    T readVector(const picojson::value& value, T defaultValue){
+        for (int i=0;i<T::length() && i<arraySize(value);i++){
+            defaultValue[i] = (float)number(element(value, i), defaultValue[i]);
+        }
+        return defaultValue;
+    }
+
+    int componentSize(int componentType){
+        switch (componentType){
+            case GltfByte:
+            case GltfUnsignedByte:
+                return 1;
+            case GltfShort:
+            case GltfUnsignedShort:
+                return 2;
+            case GltfUnsignedInt:
+            case GltfFloat:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    int componentCount(const std::string& type){
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        return 0;
+    }
+
+    std::string joinPath(const std::string& path, const std::string& filename){
+        if (path.empty() || path.back() == '/' || path.back() == '\\'){
+            return path + filename;
+        }
+        return path + "/" + filename;
+    }
+
+    // uris are percent encoded (e.g. spaces are stored as %20)
+    std::string decodeUri(const std::string& uri){
+        std::string res;
+        for (size_t i=0;i<uri.size();i++){
+            if (uri[i] == '%' && i + 2 < uri.size()){
+                res += (char)strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            } else {
+                res += uri[i];
+            }
+        }
+        return res;
+    }
+
+    bool decodeBase64(const char* p, const char* end, std::vector<char>& res){
+        static const struct Table {
+            Table(){
+                const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+                memset(values, -1, sizeof(values));
+                for (int i=0;i<64;i++){
+                    values[(uint8_t)alphabet[i]] = (int8_t)i;
+                }
+            }
+            int8_t values[256];
+        } table;
+        res.clear();
+        res.reserve((end - p) / 4 * 3);
+        uint32_t bits = 0;
+        int bitCount = 0;
+        for (;p < end && *p != '=';p++){
+            int value = table.values[(uint8_t)*p];
+            if (value < 0){
+                return false;
+            }
+            bits = (bits << 6) | (uint32_t)value;
+            bitCount += 6;
+            if (bitCount >= 8){
+                bitCount -= 8;
+                res.push_back((char)(bits >> bitCount));
+            }
+        }
+        return true;
+    }
+
+    // decodes a "data:[<mime type>];base64,<data>" uri. Returns false if the uri is not a data uri
+    bool decodeDataUri(const std::string& uri, std::vector<char>& res){
+        if (uri.compare(0, 5, "data:") != 0){
+            return false;
+        }
+        auto comma = uri.find(";base64,");
+        if (comma == std::string::npos || !decodeBase64(uri.data() + comma + 8, uri.data() + uri.size(), res)){
+            LOG_WARNING("Invalid glTF data uri");
+            res.clear();
+        }
+        return true;
+    }
+
+    glm::mat4 nodeTransform(const picojson::value& node){
+        auto& matrix = member(node, "matrix");
+        if (arraySize(matrix) == 16){
+            glm::mat4 res;
+            for (int i=0;i<16;i++){
+                glm::value_ptr(res)[i] = (float)number(element(matrix, i), 0);    // column major (like glm)
+            }
+            return res;
+        }
+        auto translation = readVector(member(node, "translation"), glm::vec3(0));
+        auto rotation = readVector(member(node, "rotation"), glm::vec4(0,0,0,1)); // x,y,z,w
+        auto scale = readVector(member(node, "scale"), glm::vec3(1));
+        return glm::translate(glm::mat4(1), translation) *
+               glm::mat4_cast(glm::quat(rotation.w, rotation.x, rotation.y, rotation.z)) *
+               glm::scale(glm::mat4(1), scale);
+    }
+
+    struct GltfInstance {
+        int mesh;
+        glm::mat4 transform;
+    };
+
+    void collectInstances(const picojson::value& json, int nodeIndex, const glm::mat4& parent, int depth, std::vector<GltfInstance>& res){
+        auto& node = element(member(json, "nodes"), nodeIndex);
+        if (!node.is<picojson::object>() || depth > maxNodeDepth){
+            return;
+        }
+        glm::mat4 transform = parent * nodeTransform(node);
+        int mesh = integer(member(node, "mesh"));
+        if (mesh >= 0){
+            res.push_back({mesh, transform});
+        }
+        auto& children = member(node, "children");
+        for (int i=0;i<arraySize(children);i++){
+            collectInstances(json, integer(element(children, i)), transform, depth + 1, res);
+        }
+    }
+
+    MeshTopology toMeshTopology(int mode, bool& valid){
+        valid = mode >= 0 && mode <= 6 && mode != 2;                // line loops are not supported
+        return (MeshTopology)mode;
+    }
+}
+
+// parsed glTF file. Buffers reference the memory mapped files (or decoded data uris)
+struct sre::ModelImporter::GltfModel {
+    std::string path;
+    std::string filename;
+    picojson::value json;
+    MappedFile file;
+    std::vector<std::unique_ptr<MappedFile>> externalFiles;
+    std::vector<std::vector<char>> embeddedData;
+    std::vector<std::pair<const char*, size_t>> buffers;            // data and size of each buffer
+    std::vector<GltfBufferView> bufferViews;
+    std::vector<GltfAccessor> accessors;
+    std::map<std::pair<int,int>, std::shared_ptr<Texture>> textures; // texture index and colorspace
+
+    bool load();
+    const char* getAccessorData(int accessor, size_t& stride);     // nullptr if the accessor is not valid
+    bool readAccessor(int accessor, std::vector<glm::vec4>& res);
+    bool readIndices(int accessor, std::vector<uint32_t>& res);
+    std::shared_ptr<Texture> getTexture(const picojson::value& textureInfo, Texture::SamplerColorspace colorspace);
+    std::shared_ptr<Material> createMaterial(int material, bool tangents, bool vertexColors);
+};
+
+bool sre::ModelImporter::GltfModel::load() {
+    std::string fullPath = joinPath(path, filename);
+    if (!file.open(fullPath)){
+        LOG_ERROR("Cannot open %s", fullPath.c_str());
+        return false;
+    }
+    std::string jsonText;
+    std::pair<const char*, size_t> binChunk{nullptr, 0};
+    uint32_t header[3] = {0, 0, 0};
+    if (file.size() >= sizeof(header)){
+        memcpy(header, file.data(), sizeof(header));
+    }
+    if (header[0] == glbMagic){
+        // binary glTF: 12 byte header followed by chunks (length, type, data)
+        if (header[1] != 2){
+            LOG_ERROR("Unsupported glb version %u in %s", header[1], fullPath.c_str());
+            return false;
+        }
+        size_t offset = sizeof(header);
+        size_t length = std::min((size_t)header[2], file.size());
+        while (offset + 8 <= length){
+            uint32_t chunk[2];
+            memcpy(chunk, file.data() + offset, sizeof(chunk));
+            offset += sizeof(chunk);
+            if (chunk[0] > length - offset){
+                break;
+            }
+            if (chunk[1] == glbChunkJson && jsonText.empty()){
+                jsonText.assign(file.data() + offset, chunk[0]);
+            } else if (chunk[1] == glbChunkBin && binChunk.first == nullptr){
+                binChunk = {file.data() + offset, chunk[0]};
+            }
+            offset += (chunk[0] + 3) & ~3u;                         // chunks are 4 byte aligned
+        }
+    } else {
+        jsonText.assign(file.data(), file.size());
+    }
+    std::string err = picojson::parse(json, jsonText);
+    if (!err.empty() || !json.is<picojson::object>()){
+        LOG_ERROR("Cannot parse %s %s", fullPath.c_str(), err.c_str());
+        return false;
+    }
+    auto version = getString(member(member(json, "asset"), "version"));
+    if (version.compare(0, 2, "2.") != 0){
+        LOG_ERROR("Unsupported glTF version '%s' in %s (only 2.x is supported)", version.c_str(), fullPath.c_str());
+        return false;
+    }
+    auto& required = member(json, "extensionsRequired");
+    for (int i=0;i<arraySize(required);i++){
+        LOG_WARNING("glTF extension %s is not supported (%s)", getString(element(required, i)).c_str(), fullPath.c_str());
+    }
+
+    auto& jsonBuffers = member(json, "buffers");
+    embeddedData.reserve(arraySize(jsonBuffers));
+    for (int i=0;i<arraySize(jsonBuffers);i++){
+        auto& buffer = element(jsonBuffers, i);
+        auto uri = getString(member(buffer, "uri"));
+        std::pair<const char*, size_t> data{nullptr, 0};
+        embeddedData.emplace_back();
+        if (uri.empty()){
+            data = binChunk;                                        // glb binary chunk
+        } else if (decodeDataUri(uri, embeddedData.back())){
+            data = {embeddedData.back().data(), embeddedData.back().size()};
+        } else {
+            std::unique_ptr<MappedFile> bufferFile(new MappedFile());
+            if (bufferFile->open(joinPath(path, decodeUri(uri)))){
+                data = {bufferFile->data(), bufferFile->size()};
+            } else {
+                LOG_ERROR("Cannot open glTF buffer %s", uri.c_str());
+            }
+            externalFiles.push_back(std::move(bufferFile));
+        }
+        size_t byteLength = byteCount(member(buffer, "byteLength"));
+        if (data.second < byteLength){
+            LOG_ERROR("glTF buffer %i is too small (%zu bytes, expected %zu) in %s", i, data.second, byteLength, fullPath.c_str());
+            data = {nullptr, 0};
+        }
+        buffers.push_back(data);
+    }
+
+    auto& jsonBufferViews = member(json, "bufferViews");
+    for (int i=0;i<arraySize(jsonBufferViews);i++){
+        auto& view = element(jsonBufferViews, i);
+        GltfBufferView bufferView;
+        bufferView.buffer = integer(member(view, "buffer"));
+        bufferView.byteOffset = byteCount(member(view, "byteOffset"));
+        bufferView.byteLength = byteCount(member(view, "byteLength"));
+        bufferView.byteStride = byteCount(member(view, "byteStride"));
+        if (bufferView.buffer < 0 || bufferView.buffer >= (int)buffers.size() || bufferView.byteStride > 252 ||  // max stride in the spec
+                bufferView.byteLength > buffers[bufferView.buffer].second ||
+                bufferView.byteOffset > buffers[bufferView.buffer].second - bufferView.byteLength){
+            LOG_ERROR("Invalid glTF buffer view %i in %s", i, fullPath.c_str());
+            bufferView.buffer = -1;
+        }
+        bufferViews.push_back(bufferView);
+    }
+
+    auto& jsonAccessors = member(json, "accessors");
+    for (int i=0;i<arraySize(jsonAccessors);i++){
+        auto& jsonAccessor = element(jsonAccessors, i);
+        GltfAccessor accessor;
+        accessor.bufferView = integer(member(jsonAccessor, "bufferView"));
+        accessor.byteOffset = byteCount(member(jsonAccessor, "byteOffset"));
+        accessor.componentType = integer(member(jsonAccessor, "componentType"), 0);
+        accessor.normalized = member(jsonAccessor, "normalized").is<bool>() && member(jsonAccessor, "normalized").get<bool>();
+        accessor.count = byteCount(member(jsonAccessor, "count"));
+        accessor.components = componentCount(getString(member(jsonAccessor, "type")));
+        accessor.sparse = member(jsonAccessor, "sparse").is<picojson::object>();
+        accessor.hasMinMax = arraySize(member(jsonAccessor, "min")) >= 3 && arraySize(member(jsonAccessor, "max")) >= 3;
+        accessor.min = readVector(member(jsonAccessor, "min"), glm::vec3(0));
+        accessor.max = readVector(member(jsonAccessor, "max"), glm::vec3(0));
+        accessors.push_back(accessor);
+    }
+    return true;
+}
+
+const char *sre::ModelImporter::GltfModel::getAccessorData(int index, size_t &stride) {
+    if (index < 0 || index >= (int)accessors.size()){
+        return nullptr;
+    }
+    auto& accessor = accessors[index];
+    size_t elementSize = (size_t)accessor.components * componentSize(accessor.componentType);
+    if (elementSize == 0 || accessor.bufferView < 0 || accessor.bufferView >= (int)bufferViews.size()){
+        return nullptr;
+    }
+    auto& view = bufferViews[accessor.bufferView];
+    stride = view.byteStride != 0 ? view.byteStride : elementSize;
+    // offset and count are at most byteLength before the multiply, so the range check cannot wrap
+    if (view.buffer < 0 || accessor.byteOffset > view.byteLength || accessor.count > view.byteLength ||
+            (accessor.count > 0 && accessor.byteOffset + (accessor.count - 1) * stride + elementSize > view.byteLength)){
+        return nullptr;
+    }
+    if (accessor.sparse){
+        LOG_WARNING("Sparse glTF accessors are not supported (accessor %i)", index);
+    }
+    return buffers[view.buffer].first + view.byteOffset + accessor.byteOffset;
+}
+
+bool sre::ModelImporter::GltfModel::readAccessor(int index, std::vector<glm::vec4> &res) {
+    size_t stride;
+    const char* data = getAccessorData(index, stride);
+    if (data == nullptr){
+        return false;
+    }
+    auto& accessor = accessors[index];
+    int size = componentSize(accessor.componentType);
+    bool normalized = accessor.normalized;
+    res.assign(accessor.count, glm::vec4(0,0,0,1));
+    for (size_t i=0;i<accessor.count;i++){
+        const char* src = data + i * stride;
+        for (int c=0;c<accessor.components;c++){
+            const char* component = src + c * size;
+            float value;
+            switch (accessor.componentType){
+                case GltfFloat:
+                    memcpy(&value, component, sizeof(float));
+                    break;
+                case GltfUnsignedByte:
+                    value = (float)(uint8_t)*component;
+                    value = normalized ? value / 255.0f : value;
+                    break;
+                case GltfByte:
+                    value = (float)(int8_t)*component;
+                    value = normalized ? std::max(value / 127.0f, -1.0f) : value;
+                    break;
+                case GltfUnsignedShort: {
+                    uint16_t v;
+                    memcpy(&v, component, sizeof(v));
+                    value = normalized ? v / 65535.0f : (float)v;
+                    break;
+                }
+                case GltfShort: {
+                    int16_t v;
+                    memcpy(&v, component, sizeof(v));
+                    value = normalized ? std::max(v / 32767.0f, -1.0f) : (float)v;
+                    break;
+                }
+                default: {
+                    uint32_t v;
+                    memcpy(&v, component, sizeof(v));
+                    value = (float)v;
+                    break;
+                }
+            }
+            res[i][c] = value;
+        }
+    }
+    return true;
+}
+
+bool sre::ModelImporter::GltfModel::readIndices(int index, std::vector<uint32_t> &res) {
+    size_t stride;
+    const char* data = getAccessorData(index, stride);
+    if (data == nullptr || accessors[index].components != 1){
+        return false;
+    }
+    auto& accessor = accessors[index];
+    res.resize(accessor.count);
+    for (size_t i=0;i<accessor.count;i++){
+        const char* src = data + i * stride;
+        switch (accessor.componentType){
+            case GltfUnsignedByte:
+                res[i] = (uint8_t)*src;
+                break;
+            case GltfUnsignedShort: {
+                uint16_t v;
+                memcpy(&v, src, sizeof(v));
+                res[i] = v;
+                break;
+            }
+            case GltfUnsignedInt:
+                memcpy(&res[i], src, sizeof(uint32_t));
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<Texture> sre::ModelImporter::GltfModel::getTexture(const picojson::value &textureInfo, Texture::SamplerColorspace colorspace) {
+    int textureIndex = integer(member(textureInfo, "index"));
+    if (textureIndex < 0){
+        return nullptr;
+    }
+    if (integer(member(textureInfo, "texCoord"), 0) != 0){
+        LOG_WARNING("Only TEXCOORD_0 is supported (texture %i in %s)", textureIndex, filename.c_str());
+    }
+    auto key = std::make_pair(textureIndex, (int)colorspace);
+    auto cached = textures.find(key);
+    if (cached != textures.end()){
+        return cached->second;
+    }
+    auto& texture = element(member(json, "textures"), textureIndex);
+    auto& image = element(member(json, "images"), integer(member(texture, "source")));
+    auto& sampler = element(member(json, "samplers"), integer(member(texture, "sampler")));
+
+    const char* data = nullptr;
+    size_t size = 0;
+    std::vector<char> embedded;
+    MappedFile imageFile;
+    auto uri = getString(member(image, "uri"));
+    std::string name = getString(member(image, "name"));
+    if (!uri.empty()){
+        if (decodeDataUri(uri, embedded)){
+            data = embedded.data();
+            size = embedded.size();
+        } else if (imageFile.open(joinPath(path, decodeUri(uri)))){
+            data = imageFile.data();
+            size = imageFile.size();
+            name = name.empty() ? uri : name;
+        }
+    } else {
+        int view = integer(member(image, "bufferView"));
+        if (view >= 0 && view < (int)bufferViews.size() && bufferViews[view].buffer >= 0){
+            data = buffers[bufferViews[view].buffer].first + bufferViews[view].byteOffset;
+            size = bufferViews[view].byteLength;
+        }
+    }
+    std::shared_ptr<Texture> res;
+    if (data == nullptr){
+        LOG_WARNING("Cannot load glTF image of texture %i in %s", textureIndex, filename.c_str());
+    } else {
+        // glTF texture coordinates have origin in the upper left corner: the image is not flipped
+        auto&& builder = Texture::create();
+        builder.withFileData(data, (int)size, false);
+        auto decoded = builder.textureTypeData.find(GL_TEXTURE_2D);
+        if (decoded != builder.textureTypeData.end() && !decoded->second.data.empty()){
+            int wrapS = integer(member(sampler, "wrapS"), 10497);
+            Texture::Wrap wrap = wrapS == 33071 ? Texture::Wrap::ClampToEdge : wrapS == 33648 ? Texture::Wrap::Mirror : Texture::Wrap::Repeat;
+            int minFilter = integer(member(sampler, "minFilter"), GltfNearestMipmapNearest);
+            res = builder.withName(name.empty() ? filename + " texture " + std::to_string(textureIndex) : name)
+                    .withSamplerColorspace(colorspace)
+                    .withWrapUV(wrap)
+                    .withFilterSampling(integer(member(sampler, "magFilter"), 0) != GltfNearest)
+                    .withGenerateMipmaps(minFilter >= GltfNearestMipmapNearest)
+                    .build();
+        }
+    }
+    textures[key] = res;
+    return res;
+}
+
+std::shared_ptr<Material> sre::ModelImporter::GltfModel::createMaterial(int materialIndex, bool tangents, bool vertexColors) {
+    auto& material = element(member(json, "materials"), materialIndex);
+    auto& pbr = member(material, "pbrMetallicRoughness");
+    auto& normalInfo = member(material, "normalTexture");
+    auto& occlusionInfo = member(material, "occlusionTexture");
+    // color textures are sRGB, the other textures are sampled without conversion
+    auto baseColorTex = getTexture(member(pbr, "baseColorTexture"), Texture::SamplerColorspace::Linear);
+    auto mrTex = getTexture(member(pbr, "metallicRoughnessTexture"), Texture::SamplerColorspace::Gamma);
+    auto normalTex = getTexture(normalInfo, Texture::SamplerColorspace::Gamma);
+    auto occlusionTex = getTexture(occlusionInfo, Texture::SamplerColorspace::Gamma);
+    auto emissiveTex = getTexture(member(material, "emissiveTexture"), Texture::SamplerColorspace::Linear);
+    auto emissiveFactor = readVector(member(material, "emissiveFactor"), glm::vec3(0));
+
+    std::map<std::string,std::string> specialization;
+    if (!baseColorTex){
+        specialization["S_NO_BASECOLORMAP"] = "1";
+    }
+    if (mrTex){
+        specialization["S_METALROUGHNESSMAP"] = "1";
+    }
+    if (normalTex){
+        specialization["S_NORMALMAP"] = "1";
+        if (tangents){
+            specialization["S_TANGENTS"] = "1";
+        }
+    }
+    if (occlusionTex){
+        specialization["S_OCCLUSIONMAP"] = "1";
+    }
+    if (emissiveTex || emissiveFactor != glm::vec3(0)){
+        specialization["S_EMISSIVEMAP"] = "1";
+    }
+    if (vertexColors){
+        specialization["S_VERTEX_COLOR"] = "1";
+    }
+
+    auto res = Shader::getStandardPBR()->createMaterial(specialization);
+    Color color;
+    color.setFromLinear(readVector(member(pbr, "baseColorFactor"), glm::vec4(1)));
+    res->setColor(color);
+    res->setMetallicRoughness({(float)number(member(pbr, "metallicFactor"), 1), (float)number(member(pbr, "roughnessFactor"), 1)});
+    if (baseColorTex){
+        res->setTexture(baseColorTex);
+    }
+    if (mrTex){
+        res->setMetallicRoughnessTexture(mrTex);
+    }
+    if (normalTex){
+        res->set("normalTex", normalTex);
+        res->set("normalScale", (float)number(member(normalInfo, "scale"), 1));
+    }
+    if (occlusionTex){
+        res->set("occlusionTex", occlusionTex);
+        res->set("occlusionStrength", (float)number(member(occlusionInfo, "strength"), 1));
+    }
+    if (specialization.count("S_EMISSIVEMAP")){
+        res->set("emissiveTex", emissiveTex ? emissiveTex : Texture::getWhiteTexture());
+        res->set("emissiveFactor", glm::vec4(emissiveFactor, 1));
+    }
+    auto name = getString(member(material, "name"));
+    res->setName(name.empty() ? "glTF default material" : name);
+    return res;
+}
+
+std::shared_ptr<sre::Mesh> sre::ModelImporter::importGltf(std::string path, std::string filename) {
+    std::vector<std::shared_ptr<Material>> outModelMaterials;
+    return importGltf(path, filename, outModelMaterials);
+}
+
+std::shared_ptr<sre::Mesh> sre::ModelImporter::importGltf(std::string path, std::string filename, std::vector<std::shared_ptr<Material>> &outModelMaterials) {
+    GltfModel model;
+    model.path = path;
+    model.filename = filename;
+    if (!model.load()){
+        return nullptr;
+    }
+    auto& json = model.json;
+    auto& meshes = member(json, "meshes");
+
+    std::vector<GltfInstance> instances;
+    auto& scenes = member(json, "scenes");
+    auto& scene = element(scenes, integer(member(json, "scene"), 0));
+    if (scene.is<picojson::object>()){
+        auto& nodes = member(scene, "nodes");
+        for (int i=0;i<arraySize(nodes);i++){
+            collectInstances(json, integer(element(nodes, i)), glm::mat4(1), 0, instances);
+        }
+    } else {
+        // no scene: use all meshes untransformed
+        for (int i=0;i<arraySize(meshes);i++){
+            instances.push_back({i, glm::mat4(1)});
+        }
+    }
+
+    auto hasAttribute = [&](const picojson::value& primitive, const char* name){
+        return integer(member(member(primitive, "attributes"), name)) >= 0;
+    };
+    auto addMaterials = [&](int mesh, bool tangents, bool vertexColors){
+        std::map<int, std::shared_ptr<Material>> materials;                 // primitives may share materials
+        auto& primitives = member(element(meshes, mesh), "primitives");
+        for (int i=0;i<arraySize(primitives);i++){
+            auto& primitive = element(primitives, i);
+            bool validTopology;
+            toMeshTopology(integer(member(primitive, "mode"), 4), validTopology);
+            if (!validTopology || !hasAttribute(primitive, "POSITION")){
+                continue;
+            }
+            int material = integer(member(primitive, "material"));
+            if (materials.find(material) == materials.end()){
+                materials[material] = model.createMaterial(material, tangents, vertexColors);
+            }
+            outModelMaterials.push_back(materials[material]);
+        }
+    };
+
+    if (instances.size() == 1 && instances[0].transform == glm::mat4(1)){
+        auto mesh = uploadGltfInterleaved(model, instances[0].mesh);
+        if (mesh){
+            auto& primitive = element(member(element(meshes, instances[0].mesh), "primitives"), 0);
+            addMaterials(instances[0].mesh, hasAttribute(primitive, "TANGENT"), hasAttribute(primitive, "COLOR_0"));
+            return mesh;
+        }
+    }
+
+    // merge the primitives of all mesh instances (vertex attributes are converted to the standard layout)
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec4> uvs;
+    std::vector<glm::vec4> tangents;
+    std::vector<glm::vec4> colors;
+    bool includeNormals = false;
+    bool includeUVs = false;
+    bool includeTangents = false;
+    bool includeColors = false;
+    std::vector<std::vector<uint16_t>> indexSets;
+    std::vector<MeshTopology> topologies;
+    std::vector<int> materialIndices;
+    std::vector<glm::vec4> values;
+    std::vector<uint32_t> indices;
+    for (auto& instance : instances){
+        auto& primitives = member(element(meshes, instance.mesh), "primitives");
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.transform)));
+        bool mirrored = glm::determinant(glm::mat3(instance.transform)) < 0;
+        for (int p=0;p<arraySize(primitives);p++){
+            auto& primitive = element(primitives, p);
+            auto& attributes = member(primitive, "attributes");
+            bool validTopology;
+            MeshTopology topology = toMeshTopology(integer(member(primitive, "mode"), 4), validTopology);
+            if (!validTopology){
+                LOG_WARNING("Unsupported glTF primitive mode %i in %s", integer(member(primitive, "mode"), 4), filename.c_str());
+                continue;
+            }
+            if (!model.readAccessor(integer(member(attributes, "POSITION")), values)){
+                LOG_WARNING("glTF primitive without valid positions in %s", filename.c_str());
+                continue;
+            }
+            size_t base = positions.size();
+            size_t count = values.size();
+            if (base + count > 65536){
+                LOG_ERROR("Cannot import %s. The vertex count exceeds 65536", filename.c_str());
+                return nullptr;
+            }
+            for (auto& value : values){
+                positions.emplace_back(instance.transform * glm::vec4(glm::vec3(value), 1));
+            }
+            normals.resize(base + count, glm::vec3(0));
+            uvs.resize(base + count, glm::vec4(0));
+            tangents.resize(base + count, glm::vec4(0));
+            colors.resize(base + count, glm::vec4(1));
+            if (model.readAccessor(integer(member(attributes, "NORMAL")), values) && values.size() == count){
+                for (size_t i=0;i<count;i++){
+                    normals[base + i] = glm::normalize(normalMatrix * glm::vec3(values[i]));
+                }
+                includeNormals = true;
+            }
+            if (model.readAccessor(integer(member(attributes, "TEXCOORD_0")), values) && values.size() == count){
+                for (size_t i=0;i<count;i++){
+                    uvs[base + i] = glm::vec4(values[i].x, values[i].y, 0, 0);
+                }
+                includeUVs = true;
+            }
+            if (model.readAccessor(integer(member(attributes, "TANGENT")), values) && values.size() == count){
+                for (size_t i=0;i<count;i++){
+                    tangents[base + i] = glm::vec4(glm::normalize(glm::mat3(instance.transform) * glm::vec3(values[i])), values[i].w);
+                }
+                includeTangents = true;
+            }
+            if (model.readAccessor(integer(member(attributes, "COLOR_0")), values) && values.size() == count){
+                std::copy(values.begin(), values.end(), colors.begin() + base);
+                includeColors = true;
+            }
+
+            int indexAccessor = integer(member(primitive, "indices"));
+            if (indexAccessor >= 0){
+                if (!model.readIndices(indexAccessor, indices)){
+                    LOG_WARNING("Invalid glTF indices (accessor %i) in %s", indexAccessor, filename.c_str());
+                    continue;
+                }
+            } else {
+                indices.resize(count);
+                for (size_t i=0;i<count;i++){
+                    indices[i] = (uint32_t)i;
+                }
+            }
+            if (mirrored && topology == MeshTopology::Triangles){
+                for (size_t i=0;i + 2 < indices.size();i += 3){
+                    std::swap(indices[i + 1], indices[i + 2]);          // keep counter clockwise winding
+                }
+            }
+            std::vector<uint16_t> indexSet(indices.size());
+            bool validIndices = true;
+            for (size_t i=0;i<indices.size();i++){
+                validIndices &= indices[i] < count;
+                indexSet[i] = (uint16_t)(base + indices[i]);
+            }
+            if (!validIndices){
+                LOG_WARNING("glTF indices out of range (accessor %i) in %s", indexAccessor, filename.c_str());
+                continue;
+            }
+            indexSets.push_back(std::move(indexSet));
+            topologies.push_back(topology);
+            materialIndices.push_back(integer(member(primitive, "material")));
+        }
+    }
+    if (indexSets.empty()){
+        LOG_ERROR("No meshes found in %s", filename.c_str());
+        return nullptr;
+    }
+
+    auto&& meshBuilder = Mesh::create();
+    meshBuilder.withPositions(positions);
+    if (includeNormals){
+        meshBuilder.withNormals(normals);
+    }
+    if (includeUVs){
+        meshBuilder.withUVs(uvs);
+    }
+    if (includeTangents){
+        meshBuilder.withTangents(tangents);
+    }
+    if (includeColors){
+        meshBuilder.withColors(colors);
+    }
+    std::map<int, std::shared_ptr<Material>> materials;
+    for (int i=0;i<(int)indexSets.size();i++){
+        meshBuilder.withIndices(indexSets[i], topologies[i], i);
+        int material = materialIndices[i];
+        if (materials.find(material) == materials.end()){
+            materials[material] = model.createMaterial(material, includeTangents, includeColors);
+        }
+        outModelMaterials.push_back(materials[material]);
+    }
+    return meshBuilder.withName(filename).build();
+}
+
+std::shared_ptr<sre::Mesh> sre::ModelImporter::uploadGltfInterleaved(GltfModel &model, int meshIndex) {
+    auto& primitives = member(element(member(model.json, "meshes"), meshIndex), "primitives");
+    auto& attributes = member(element(primitives, 0), "attributes");
+    if (arraySize(primitives) == 0 || !attributes.is<picojson::object>()){
+        return nullptr;
+    }
+    // all primitives must share the vertex data and be indexed
+    for (int i=0;i<arraySize(primitives);i++){
+        auto& primitive = element(primitives, i);
+        bool validTopology;
+        toMeshTopology(integer(member(primitive, "mode"), 4), validTopology);
+        if (!validTopology || !(member(primitive, "attributes") == attributes) || integer(member(primitive, "indices")) < 0){
+            return nullptr;
+        }
+    }
+
+    // the attributes must be floats interleaved in a single buffer view
+    std::map<std::string, Mesh::Attribute> meshAttributes;
+    int bufferView = -1;
+    size_t stride = 0;
+    size_t vertexCount = 0;
+    size_t baseOffset = std::numeric_limits<size_t>::max();
+    int positionAccessor = integer(member(attributes, "POSITION"));
+    for (auto& name : gltfAttributeNames){
+        int index = integer(member(attributes, name.first));
+        if (index < 0){
+            continue;
+        }
+        size_t accessorStride;
+        if (model.getAccessorData(index, accessorStride) == nullptr){
+            return nullptr;
+        }
+        auto& accessor = model.accessors[index];
+        if (accessor.componentType != GltfFloat || accessor.normalized || accessor.sparse || accessor.components < 2 ||
+                (bufferView != -1 && (bufferView != accessor.bufferView || vertexCount != accessor.count))){
+            return nullptr;
+        }
+        bufferView = accessor.bufferView;
+        stride = accessorStride;
+        vertexCount = accessor.count;
+        baseOffset = std::min(baseOffset, accessor.byteOffset);
+        static const int attributeTypes[] = {0, 0, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4};
+        meshAttributes[name.second] = {(int)accessor.byteOffset, accessor.components, GL_FLOAT, attributeTypes[accessor.components]};
+    }
+    if (positionAccessor < 0 || meshAttributes.find("position") == meshAttributes.end() ||
+            vertexCount == 0 || vertexCount > 65536 || stride % 4 != 0){
+        return nullptr;
+    }
+    for (auto& attribute : meshAttributes){
+        attribute.second.offset -= (int)baseOffset;
+        if (attribute.second.offset + attribute.second.elementCount * (int)sizeof(float) > (int)stride){
+            return nullptr;                                         // not interleaved
+        }
+    }
+    auto& view = model.bufferViews[bufferView];
+    auto& buffer = model.buffers[view.buffer];
+    size_t vertexOffset = view.byteOffset + baseOffset;
+    if (vertexOffset + vertexCount * stride > buffer.second){
+        return nullptr;                                             // the padding of the last vertex is outside the buffer
+    }
+
+    // index sets are stored after each other in the element buffer (byte offsets)
+    std::vector<uint16_t> elementData;
+    std::vector<std::pair<int,int>> elementBufferOffsetCount;
+    std::vector<MeshTopology> meshTopology;
+    std::vector<uint32_t> indices;
+    const uint16_t* directIndices = nullptr;
+    for (int i=0;i<arraySize(primitives);i++){
+        auto& primitive = element(primitives, i);
+        int indexAccessor = integer(member(primitive, "indices"));
+        if (!model.readIndices(indexAccessor, indices)){
+            return nullptr;
+        }
+        for (auto index : indices){
+            if (index >= vertexCount){
+                return nullptr;
+            }
+        }
+        size_t indexStride;
+        const char* indexData = model.getAccessorData(indexAccessor, indexStride);
+        if (arraySize(primitives) == 1 && model.accessors[indexAccessor].componentType == GltfUnsignedShort && indexStride == sizeof(uint16_t)){
+            directIndices = (const uint16_t*)indexData;             // uploaded directly from the file
+        } else {
+            elementData.insert(elementData.end(), indices.begin(), indices.end());
+        }
+        bool validTopology;
+        meshTopology.push_back(toMeshTopology(integer(member(primitive, "mode"), 4), validTopology));
+        int offset = elementBufferOffsetCount.empty() ? 0 : elementBufferOffsetCount.back().first + elementBufferOffsetCount.back().second * (int)sizeof(uint16_t);
+        elementBufferOffsetCount.emplace_back(offset, (int)indices.size());
+    }
+    int elementCount = directIndices ? (int)indices.size() : (int)elementData.size();
+
+    std::array<glm::vec3,2> bounds;
+    auto& positions = model.accessors[positionAccessor];
+    if (positions.hasMinMax){
+        bounds = {{positions.min, positions.max}};
+    } else {
+        bounds = {{glm::vec3{std::numeric_limits<float>::max()}, glm::vec3{-std::numeric_limits<float>::max()}}};
+        const char* data = buffer.first + vertexOffset + meshAttributes["position"].offset;
+        for (size_t i=0;i<vertexCount;i++){
+            glm::vec3 position;
+            memcpy(&position, data + i * stride, sizeof(glm::vec3));
+            bounds[0] = glm::min(bounds[0], position);
+            bounds[1] = glm::max(bounds[1], position);
+        }
+    }
+
+    return Mesh::createFromInterleavedData(model.filename, buffer.first + vertexOffset, (int)vertexCount, (int)stride,
+                                           std::move(meshAttributes), std::move(meshTopology),
+                                           directIndices ? directIndices : elementData.data(), elementCount,
+                                           std::move(elementBufferOffsetCount), {}, bounds);
+}
@@ -98,6 +98,16 @@ namespace sre {
         return *this;
     }
 
+    RenderPass::RenderPassBuilder &RenderPass::RenderPassBuilder::withLODBias(float bias) {
+        this->lodBias = bias;
+        return *this;
+    }
+
+    RenderPass::RenderPassBuilder &RenderPass::RenderPassBuilder::withFrustumCulling(bool enabled) {
+        this->frustumCulling = enabled;
+        return *this;
+    }
+
     RenderPass::RenderPass(RenderPass::RenderPassBuilder& builder)
         :builder(builder)
     {
@@ -107,6 +117,16 @@ namespace sre {
         if (builder.skybox){
             renderQueue.push_back({}); // reserve empty obj
         }
+        // viewport and projection are known when the pass is created (used for culling and LOD when drawing)
+        glm::vec2 windowSize;
+        if (builder.framebuffer){
+            windowSize = builder.framebuffer->size;
+        } else {
+            windowSize = static_cast<glm::vec2>(Renderer::instance->getDrawableSize());
+        }
+        viewportOffset = static_cast<glm::uvec2>(builder.camera.viewportOffset * windowSize);
+        viewportSize = static_cast<glm::uvec2>(windowSize * builder.camera.viewportSize);
+        projection = builder.camera.getProjectionTransform(viewportSize);
     }
 
     RenderPass::RenderPass(RenderPass &&rp) noexcept {
@@ -139,6 +159,10 @@ namespace sre {
 
     void RenderPass::draw(std::shared_ptr<Mesh>& meshPtr, glm::mat4 modelTransform, std::shared_ptr<Material>& material_ptr) {
         assert(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
+        if (isCulled(meshPtr.get(), modelTransform)){
+            return;
+        }
+        requestTextureMips(meshPtr.get(), modelTransform, material_ptr.get());
         renderQueue.emplace_back(RenderQueueObj{meshPtr, modelTransform, material_ptr});
     }
 
@@ -279,14 +303,6 @@ namespace sre {
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
 
-        glm::vec2 windowSize;
-        if (builder.framebuffer){
-            windowSize = builder.framebuffer->size;
-        } else {
-            windowSize = static_cast<glm::vec2>(Renderer::instance->getDrawableSize());
-        }
-        viewportOffset = static_cast<glm::uvec2>(builder.camera.viewportOffset * windowSize);
-        viewportSize = static_cast<glm::uvec2>(windowSize * builder.camera.viewportSize);
         glEnable(GL_SCISSOR_TEST);
         glScissor(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
         glViewport(viewportOffset.x, viewportOffset.y, viewportSize.x,viewportSize.y);
@@ -309,8 +325,6 @@ namespace sre {
             glClear(clear);
         }
 
-        projection = builder.camera.getProjectionTransform(viewportSize);
-
         if (builder.skybox) {
             // Create an infinite projection
             glm::mat4 inf = builder.camera.getInfiniteProjectionTransform(viewportSize);
@@ -331,11 +345,8 @@ namespace sre {
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         if (builder.framebuffer != nullptr){
             for(auto& tex : builder.framebuffer->textures){
-                if (tex->generateMipmap){
-                    glBindTexture(tex->target,tex->textureId);
-                    glGenerateMipmap(tex->target);
-                    glBindTexture(tex->target,0);
-                }
+                // mipmaps are generated when the texture is sampled (see UniformSet::bind())
+                tex->mipmapsDirty = tex->generateMipmap;
             }
         }
         mIsFinished = true;
@@ -373,9 +384,13 @@ namespace sre {
     void RenderPass::draw(std::shared_ptr<Mesh> &meshPtr, glm::mat4 modelTransform,
                           std::vector<std::shared_ptr<Material>> materials) {
         assert(!mIsFinished && "RenderPass is finished. Can no longer be modified.");
-        assert(meshPtr->indices.size() == 0 || meshPtr->indices.size() == materials.size());
+        assert(meshPtr->getIndexSets() == 0 || meshPtr->getIndexSets() == materials.size());
+        if (isCulled(meshPtr.get(), modelTransform)){
+            return;
+        }
         int subMesh = 0;
         for (auto & mat : materials){
+            requestTextureMips(meshPtr.get(), modelTransform, mat.get());
             renderQueue.emplace_back(RenderQueueObj{meshPtr, modelTransform, mat,subMesh});
             subMesh++;
         }
@@ -397,19 +412,152 @@ namespace sre {
             lastBoundMeshId = -1; // force mesh to rebind
             material->bind();
         }
-        if (mesh->meshId != lastBoundMeshId)
+        if (mesh->getBindKey() != lastBoundMeshId)
         {
             builder.renderStats->stateChangesMesh++;
-            lastBoundMeshId = mesh->meshId;
+            lastBoundMeshId = mesh->getBindKey();
             mesh->bind(shader);
         }
         if (mesh->getIndexSets() == 0){
-            glDrawArrays((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount());
+            auto topology = mesh->getMeshTopology();
+            if (topology == MeshTopology::Triangles){
+                builder.renderStats->triangles += mesh->getVertexCount()/3;
+            }
+            glDrawArrays((GLenum) topology, mesh->arenaVertexOffset, mesh->getVertexCount());
         } else {
             auto offsetCount = mesh->elementBufferOffsetCount[rqObj.subMesh];
+            int lod = -1;
+            if (!mesh->lods.empty()){
+                lod = mesh->selectLOD(projectedSize(mesh, rqObj.modelTransform) * builder.lodBias);
+                if (lod != -1){
+                    offsetCount = mesh->lods[lod].elementBufferOffsetCount[rqObj.subMesh];
+                }
+            }
+            if (lod == -1 && mesh->getMeshletCount(rqObj.subMesh) > 0){
+                drawMeshlets(mesh, rqObj.modelTransform, rqObj.subMesh);
+                return;
+            }
 
             GLsizei indexCount = offsetCount.second;
-            glDrawElements((GLenum) mesh->getMeshTopology(rqObj.subMesh), indexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(offsetCount.first));
+            auto topology = mesh->getMeshTopology(rqObj.subMesh);
+            if (topology == MeshTopology::Triangles){
+                builder.renderStats->triangles += indexCount/3;
+            }
+            drawElements(mesh, (GLenum) topology, indexCount, offsetCount.first);
+        }
+    }
+
+    void RenderPass::drawElements(Mesh* mesh, unsigned int topology, int indexCount, int byteOffset) {
+        if (mesh->geometryArena){
+#ifndef EMSCRIPTEN
+            glDrawElementsBaseVertex(topology, indexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(mesh->getIndexByteOffset() + byteOffset), mesh->arenaVertexOffset);
+#endif
+        } else {
+            glDrawElements(topology, indexCount, GL_UNSIGNED_SHORT, BUFFER_OFFSET(byteOffset));
+        }
+    }
+
+    void RenderPass::getFrustumPlanes(const glm::mat4 &modelTransform, glm::vec4 *planes) {
+        // frustum planes are extracted from the model-view-projection matrix
+        glm::mat4 mvp = glm::transpose(projection * builder.camera.viewTransform * modelTransform);
+        planes[0] = mvp[3] + mvp[0];
+        planes[1] = mvp[3] - mvp[0];
+        planes[2] = mvp[3] + mvp[1];
+        planes[3] = mvp[3] - mvp[1];
+        planes[4] = mvp[3] + mvp[2];
+        planes[5] = mvp[3] - mvp[2];
+        for (int i=0;i<6;i++){
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+        }
+    }
+
+    bool RenderPass::isCulled(Mesh* mesh, const glm::mat4 &modelTransform) {
+        if (!builder.frustumCulling || mesh == nullptr){
+            return false;
+        }
+        auto bounds = mesh->getBoundsMinMax();
+        if (bounds[0].x > bounds[1].x){
+            return false;                                           // no bounds
+        }
+        glm::vec4 planes[6];
+        getFrustumPlanes(modelTransform, planes);
+        for (auto& plane : planes){
+            // the corner of the bounds furthest along the plane normal
+            glm::vec3 corner = glm::mix(bounds[0], bounds[1], glm::greaterThanEqual(glm::vec3(plane), glm::vec3(0)));
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0){
+                builder.renderStats->meshesCulled++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RenderPass::drawMeshlets(Mesh* mesh, const glm::mat4 &modelTransform, int subMesh) {
+        // cull in mesh space
+        glm::mat4 modelView = builder.camera.viewTransform * modelTransform;
+        glm::vec4 planes[6];
+        getFrustumPlanes(modelTransform, planes);
+        glm::vec3 cameraPosition = glm::vec3(glm::inverse(modelView) * glm::vec4(0,0,0,1));
+        bool backFaceCulling = glm::determinant(glm::mat3(modelTransform)) > 0; // mirrored transforms flips the winding order
+
+        auto topology = (GLenum) mesh->getMeshTopology(subMesh);
+        int indexSetOffset = mesh->elementBufferOffsetCount[subMesh].first;
+        int rangeStart = -1;
+        int rangeEnd = -1;
+        bool firstRange = true;
+        auto drawRange = [&](){
+            if (rangeStart == rangeEnd){
+                return;
+            }
+            if (!firstRange){
+                builder.renderStats->drawCalls++;
+            }
+            firstRange = false;
+            builder.renderStats->triangles += (rangeEnd - rangeStart)/3;
+            drawElements(mesh, topology, rangeEnd - rangeStart, indexSetOffset + rangeStart*sizeof(uint16_t));
+        };
+        for (auto& meshlet : mesh->meshlets[subMesh]){
+            if (MeshOptimizer::isMeshletCulled(meshlet, cameraPosition, planes, backFaceCulling)){
+                builder.renderStats->meshletsCulled++;
+                continue;
+            }
+            if (meshlet.indexOffset != rangeEnd){
+                drawRange();
+                rangeStart = meshlet.indexOffset;
+            }
+            rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+        }
+        drawRange();
+    }
+
+    float RenderPass::projectedSize(Mesh* mesh, const glm::mat4 &modelTransform) {
+        auto bounds = mesh->getBoundsMinMax();
+        glm::vec3 center = (bounds[0] + bounds[1])*0.5f;
+        float scale = std::max(glm::length(glm::vec3(modelTransform[0])), std::max(glm::length(glm::vec3(modelTransform[1])), glm::length(glm::vec3(modelTransform[2]))));
+        float radius = glm::length(bounds[1] - center) * scale;
+        glm::vec4 clip = projection * builder.camera.viewTransform * modelTransform * glm::vec4(center, 1.0f);
+        bool perspective = projection[2][3] != 0;
+        if (!perspective){
+            return radius * std::abs(projection[1][1]);
+        }
+        if (clip.w <= radius){
+            return std::numeric_limits<float>::max(); // camera is inside the bounds
+        }
+        return radius * std::abs(projection[1][1]) / clip.w;
+    }
+
+    void RenderPass::requestTextureMips(Mesh* mesh, const glm::mat4 &modelTransform, Material* material) {
+        float screenSize = -1;                              // size of the mesh in pixels (computed for the first streamed texture)
+        for (auto& textureValue : material->uniformMap.textureValues){
+            auto texture = textureValue.second.get();
+            if (texture == nullptr || !texture->streaming){
+                continue;
+            }
+            if (screenSize < 0){
+                // projection and viewport are set in the constructor, so they are valid while drawing
+                screenSize = projectedSize(mesh, modelTransform) * viewportSize.y;
+            }
+            texture->requestMip(screenSize);
         }
     }
 
@@ -18,10 +18,16 @@ __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 #include "sre/VR.hpp"
 
 #include "sre/Renderer.hpp"
+#include "sre/impl/GeometryArena.hpp"
+#include "sre/impl/VertexArrayCache.hpp"
+#include "sre/ResourceCache.hpp"
+#include "sre/AssetLoader.hpp"
+#include "sre/TextureStreamer.hpp"
 #include "sre/Framebuffer.hpp"
 #include "sre/Texture.hpp"
 
 #include "sre/impl/GL.hpp"
+#include <algorithm>
 
 #ifdef EMSCRIPTEN
 #include "emscripten.h"
@@ -44,6 +50,10 @@ namespace sre {
 
 
 		instance = this;
+        vertexArrayCache.reset(new VertexArrayCache());
+        resourceCache.reset(new ResourceCache());
+        assetLoader.reset(new AssetLoader());
+        textureStreamer.reset(new TextureStreamer());
 
         glcontext = SDL_GL_CreateContext(window);
         renderInfo_.graphicsAPIVersion = (char*)glGetString(GL_VERSION);
@@ -95,6 +105,7 @@ namespace sre {
 
 
         renderInfo_.graphicsAPIVendor = (char*)glGetString(GL_VENDOR);
+        initTextureCompressionSupport();
 
         LOG_INFO("OpenGL version %s (%i.%i)",renderInfo_.graphicsAPIVersion.c_str(), renderInfo_.graphicsAPIVersionMajor,renderInfo_.graphicsAPIVersionMinor);
         LOG_INFO("sre version %i.%i.%i", sre_version_major, sre_version_minor , sre_version_point);
@@ -133,22 +144,36 @@ namespace sre {
 
     Renderer::~Renderer() {
 		delete vr;
+        assetLoader.reset();                    // stop worker threads (pending assets are discarded)
+        resourceCache.reset();                  // release retained resources
+        textureStreamer.reset();
+        vertexArrayCache.reset();
+        geometryArenas.clear();
         glDeleteBuffers(1,&globalUniformBuffer);
         SDL_GL_DeleteContext(glcontext);
         instance = nullptr;
     }
 
     void Renderer::swapWindow() {
+        textureStreamer->update();              // upload requested mip levels and evict textures over the budget
         renderStatsLast = renderStats;
         renderStats.frame++;
         renderStats.meshBytesAllocated=0;
         renderStats.meshBytesDeallocated=0;
         renderStats.textureBytesAllocated=0;
         renderStats.textureBytesDeallocated=0;
+        renderStats.textureBytesUpdated=0;
         renderStats.drawCalls=0;
         renderStats.stateChangesShader = 0;
         renderStats.stateChangesMesh = 0;
         renderStats.stateChangesMaterial = 0;
+        renderStats.triangles = 0;
+        renderStats.meshletsCulled = 0;
+        renderStats.meshesCulled = 0;
+        renderStats.textureStreamingUploads = 0;
+        renderStats.textureStreamingEvictions = 0;
+        renderStats.textureUnloads = 0;
+        renderStats.textureReloads = 0;
 #ifndef EMSCRIPTEN
         SDL_GL_SwapWindow(window);
 #endif
@@ -182,6 +207,32 @@ namespace sre {
         return renderInfo_;
     }
 
+    void Renderer::initTextureCompressionSupport(){
+        auto extensions = listExtension();
+        auto has = [&](std::initializer_list<const char*> names){
+            for (auto name : names){
+                if (std::find(extensions.begin(), extensions.end(), name) != extensions.end()){
+                    return true;
+                }
+            }
+            return false;
+        };
+        bool es = renderInfo_.graphicsAPIVersionES;
+        int version = renderInfo_.graphicsAPIVersionMajor*10 + renderInfo_.graphicsAPIVersionMinor;
+        renderInfo_.supportTextureCompressionS3TC = has({"GL_EXT_texture_compression_s3tc", "GL_WEBGL_compressed_texture_s3tc"});
+        renderInfo_.supportTextureCompressionRGTC = (!es && version >= 30) ||
+                has({"GL_ARB_texture_compression_rgtc", "GL_EXT_texture_compression_rgtc"});
+        renderInfo_.supportTextureCompressionBPTC = (!es && version >= 42) ||
+                has({"GL_ARB_texture_compression_bptc", "GL_EXT_texture_compression_bptc"});
+#ifdef EMSCRIPTEN
+        // WebGL 2 does not require ETC2
+        renderInfo_.supportTextureCompressionETC2 = has({"GL_WEBGL_compressed_texture_etc"});
+#else
+        renderInfo_.supportTextureCompressionETC2 = (es && version >= 30) || (!es && version >= 43) ||
+                has({"GL_ARB_ES3_compatibility"});
+#endif
+    }
+
     void Renderer::initGlobalUniformBuffer(){
         if (renderInfo_.graphicsAPIVersionMajor <= 2){
             globalUniformBuffer = 0;
@@ -0,0 +1,243 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/ResourceCache.hpp"
+
+#include <sstream>
+#include <algorithm>
+#include "sre/Texture.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+#include "sre/impl/ParallelFor.hpp"
+
+namespace sre {
+    ResourceCache *ResourceCache::instance() {
+        if (Renderer::instance == nullptr){
+            LOG_FATAL("Cannot use sre::ResourceCache before sre::Renderer is created.");
+        }
+        return Renderer::instance->resourceCache.get();
+    }
+
+    std::shared_ptr<void> ResourceCache::get(const std::string &key, const std::function<std::shared_ptr<void>(int64_t& size)>& create) {
+        auto res = entries.find(key);
+        if (res != entries.end()){
+            auto resource = res->second.resource.lock();
+            if (resource){
+                hits++;
+                retain(key, res->second, resource);
+                return resource;
+            }
+        }
+        misses++;
+        int64_t size = 0;
+        auto resource = create(size);
+        if (resource == nullptr){
+            return resource;
+        }
+        removeExpiredAmortized();
+        auto& entry = entries[key];                         // an expired entry with the same key is reused
+        release(entry);
+        entry.resource = resource;
+        entry.size = size;
+        retain(key, entry, resource);
+        return resource;
+    }
+
+    void ResourceCache::retain(const std::string &key, Entry &entry, const std::shared_ptr<void> &resource) {
+        if (budget == 0 || entry.size > budget){
+            return;
+        }
+        if (entry.retained){
+            retainedList.erase(entry.lru);
+        } else {
+            entry.retained = resource;
+            retainedBytes += entry.size;
+        }
+        retainedList.push_front(key);
+        entry.lru = retainedList.begin();
+        // release least recently used
+        while (retainedBytes > budget){
+            auto& last = entries[retainedList.back()];
+            release(last);
+        }
+    }
+
+    void ResourceCache::release(Entry &entry) {
+        if (!entry.retained){
+            return;
+        }
+        retainedBytes -= entry.size;
+        retainedList.erase(entry.lru);
+        entry.retained.reset();                             // may destroy the resource
+    }
+
+    void ResourceCache::removeExpired() {
+        for (auto iter = entries.begin(); iter != entries.end();){
+            if (iter->second.resource.expired()){
+                iter = entries.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+    }
+
+    void ResourceCache::removeExpiredAmortized() {
+        if (entries.size() < pruneThreshold){
+            return;
+        }
+        removeExpired();
+        pruneThreshold = std::max((size_t)64, entries.size() * 2);
+    }
+
+    std::shared_ptr<Texture> ResourceCache::getTexture(const std::string &filename, bool generateMipmaps) {
+        return getTextureFile(filename, generateMipmaps, [&](){
+            return Texture::create().withFile(filename).withGenerateMipmaps(generateMipmaps).build();
+        });
+    }
+
+    std::vector<std::shared_ptr<Texture>> ResourceCache::getTextures(const std::vector<std::string> &filenames, bool generateMipmaps) {
+        auto cache = instance();
+        std::string suffix = generateMipmaps ? ":mipmaps" : "";
+        // decode the files not in the cache in parallel
+        std::vector<std::unique_ptr<Texture::TextureBuilder>> builders(filenames.size());
+        std::vector<size_t> missing;
+        for (size_t i=0;i<filenames.size();i++){
+            auto entry = cache->entries.find("texture:"+filenames[i]+suffix);
+            if (entry == cache->entries.end() || entry->second.resource.expired()){
+                builders[i].reset(new Texture::TextureBuilder());
+                missing.push_back(i);
+            }
+        }
+        parallelFor(missing.size(), 1, [&](size_t begin, size_t end){
+            for (size_t i = begin; i < end; i++){
+                builders[missing[i]]->withFile(filenames[missing[i]]).withGenerateMipmaps(generateMipmaps);
+            }
+        });
+        std::vector<std::shared_ptr<Texture>> res;
+        for (size_t i=0;i<filenames.size();i++){
+            res.push_back(getTextureFile(filenames[i], generateMipmaps, [&](){
+                auto& builder = builders[i];
+                if (builder == nullptr){
+                    return Texture::create().withFile(filenames[i]).withGenerateMipmaps(generateMipmaps).build();
+                }
+                auto decoded = builder->textureTypeData.find(GL_TEXTURE_2D);
+                if (decoded == builder->textureTypeData.end() || decoded->second.data.empty()){
+                    return std::shared_ptr<Texture>();
+                }
+                return builder->build();
+            }));
+        }
+        return res;
+    }
+
+    std::shared_ptr<Texture> ResourceCache::getTextureFile(const std::string &filename, bool generateMipmaps, std::function<std::shared_ptr<Texture>()> create) {
+        std::string key = "texture:"+filename+(generateMipmaps?":mipmaps":"");
+        return getTexture(key, create);
+    }
+
+    std::shared_ptr<Mesh> ResourceCache::getSphere(int stacks, int slices, float radius) {
+        std::stringstream ss;
+        ss << "sphere:" << stacks << ':' << slices << ':' << radius;
+        return getMesh(ss.str(), [&](){
+            return Mesh::create().withSphere(stacks, slices, radius).build();
+        });
+    }
+
+    std::shared_ptr<Mesh> ResourceCache::getCube(float length) {
+        std::stringstream ss;
+        ss << "cube:" << length;
+        return getMesh(ss.str(), [&](){
+            return Mesh::create().withCube(length).build();
+        });
+    }
+
+    std::shared_ptr<Mesh> ResourceCache::getQuad(float size) {
+        std::stringstream ss;
+        ss << "quad:" << size;
+        return getMesh(ss.str(), [&](){
+            return Mesh::create().withQuad(size).build();
+        });
+    }
+
+    std::shared_ptr<Mesh> ResourceCache::getTorus(int segmentsC, int segmentsA, float radiusC, float radiusA) {
+        std::stringstream ss;
+        ss << "torus:" << segmentsC << ':' << segmentsA << ':' << radiusC << ':' << radiusA;
+        return getMesh(ss.str(), [&](){
+            return Mesh::create().withTorus(segmentsC, segmentsA, radiusC, radiusA).build();
+        });
+    }
+
+    std::shared_ptr<Texture> ResourceCache::getTexture(const std::string &key, std::function<std::shared_ptr<Texture>()> create) {
+        auto res = instance()->get(key, [&](int64_t& size){
+            auto texture = create();
+            size = texture ? texture->getDataSize() : 0;
+            return std::static_pointer_cast<void>(texture);
+        });
+        return std::static_pointer_cast<Texture>(res);
+    }
+
+    std::shared_ptr<Mesh> ResourceCache::getMesh(const std::string &key, std::function<std::shared_ptr<Mesh>()> create) {
+        auto res = instance()->get(key, [&](int64_t& size){
+            auto mesh = create();
+            size = mesh ? mesh->getDataSize() : 0;
+            return std::static_pointer_cast<void>(mesh);
+        });
+        return std::static_pointer_cast<Mesh>(res);
+    }
+
+    void ResourceCache::setBudget(int64_t bytes) {
+        auto cache = instance();
+        cache->budget = std::max(bytes, (int64_t)0);
+        if (cache->budget == 0){
+            purge();
+        }
+        while (cache->retainedBytes > cache->budget){
+            cache->release(cache->entries[cache->retainedList.back()]);
+        }
+    }
+
+    int64_t ResourceCache::getBudget() {
+        return instance()->budget;
+    }
+
+    int64_t ResourceCache::getRetainedBytes() {
+        return instance()->retainedBytes;
+    }
+
+    void ResourceCache::purge() {
+        auto cache = instance();
+        while (!cache->retainedList.empty()){
+            cache->release(cache->entries[cache->retainedList.back()]);
+        }
+        cache->removeExpired();
+    }
+
+    void ResourceCache::clear() {
+        purge();
+        auto cache = instance();
+        cache->entries.clear();
+        cache->pruneThreshold = 64;
+        cache->hits = 0;
+        cache->misses = 0;
+    }
+
+    int ResourceCache::getHits() {
+        return instance()->hits;
+    }
+
+    int ResourceCache::getMisses() {
+        return instance()->misses;
+    }
+
+    int ResourceCache::getEntryCount() {
+        auto cache = instance();
+        cache->removeExpired();
+        return (int)cache->entries.size();
+    }
+}
@@ -10,6 +10,7 @@
 #include <sre/imgui_sre.hpp>
 #include <sre/Log.hpp>
 #include <sre/VR.hpp>
+#include <sre/AssetLoader.hpp>
 #include "sre/SDLRenderer.hpp"
 #define SDL_MAIN_HANDLED
 
@@ -179,6 +180,7 @@ namespace sre{
             deltaTimeEvent = std::chrono::duration_cast<MilliSeconds>(tick - lastTick).count();
             lastTick = tick;
         }
+        AssetLoader::update();                              // upload assets loaded in the background
         frameUpdate(deltaTimeSec);
         {   // time meassure
             auto tick = Clock::now();
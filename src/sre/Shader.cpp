@@ -15,6 +15,7 @@
 #include <regex>
 #include <sre/Log.hpp>
 #include "sre/Renderer.hpp"
+#include "sre/impl/VertexArrayCache.hpp"
 
 
 using namespace std;
@@ -244,6 +245,9 @@ namespace sre {
         shader->name = this->name;
         shader->offset = this->offset;
         shader->shaderSources = this->shaderSources;
+        if (updateShader){
+            Renderer::instance->vertexArrayCache->removeShader(shader->shaderUniqueId); // attribute locations may have changed
+        }
         shader->shaderUniqueId = globalShaderCounter++;
         return std::shared_ptr<Shader>(shader);
     }
@@ -549,6 +553,9 @@ namespace sre {
             r->renderStats.shaderCount--;
 
             r->shaders.erase(std::remove(r->shaders.begin(), r->shaders.end(), this));
+            if (r->vertexArrayCache){
+                r->vertexArrayCache->removeShader(shaderUniqueId);
+            }
 
             glDeleteShader(shaderProgramId);
         }
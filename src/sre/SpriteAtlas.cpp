@@ -34,15 +34,28 @@ SpriteAtlas::SpriteAtlas(std::map<std::string, Sprite>&& sprites, std::shared_pt
 }
 
 std::shared_ptr<SpriteAtlas> SpriteAtlas::create(std::string jsonFile, std::shared_ptr<Texture> texture, bool flipAnchorY) {
-    picojson::value v;
+    std::string json;
+    if (!readJSON(jsonFile, json)){
+        return std::shared_ptr<SpriteAtlas>(nullptr);
+    }
+    return createFromJSON(json, jsonFile, texture, flipAnchorY);
+}
+
+bool SpriteAtlas::readJSON(const std::string& jsonFile, std::string& json) {
     std::ifstream t(jsonFile);
     if (!t){
         cerr << "SpriteAtlas json not found "<<jsonFile<< endl;
-        return std::shared_ptr<SpriteAtlas>(nullptr);
-    } else {
-        t >> v;
+        return false;
     }
-    std::string err = picojson::get_last_error();
+    std::stringstream ss;
+    ss << t.rdbuf();
+    json = ss.str();
+    return true;
+}
+
+std::shared_ptr<SpriteAtlas> SpriteAtlas::createFromJSON(const std::string& json, std::string jsonFile, std::shared_ptr<Texture> texture, bool flipAnchorY) {
+    picojson::value v;
+    std::string err = picojson::parse(v, json);
     if (err != ""){
         cerr << err << endl;
         return std::shared_ptr<SpriteAtlas>(nullptr);
@@ -8,8 +8,14 @@
 #include "sre/Texture.hpp"
 
 #include "sre/impl/GL.hpp"
+#include "sre/impl/BlockCompression.hpp"
+#include "sre/impl/TextureContainer.hpp"
+#include "sre/impl/MipmapGenerator.hpp"
+#include "sre/impl/MappedFile.hpp"
+#include "sre/impl/ParallelFor.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <SDL_surface.h>
 
 #include <SDL_image.h>
@@ -29,8 +35,15 @@
 #endif
 #endif
 #include <fstream>
+#include <cstdio>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 #include "sre/RenderStats.hpp"
 #include "sre/Renderer.hpp"
+#include "sre/TextureStreamer.hpp"
 
 #ifndef GL_SRGB_ALPHA
 #define GL_SRGB_ALPHA 0x8C42
@@ -44,24 +57,6 @@
 
 // anonymous (file local) namespace
 namespace {
-	static std::vector<char> readAllBytes(char const* filename)
-	{
-		using namespace std;
-		ifstream ifs(filename, std::ios::binary | std::ios::ate);
-		ifstream::pos_type pos = ifs.tellg();
-		if (pos<0) {
-            LOG_ERROR("Cannot read texture from %s",filename);
-			return std::vector<char>();
-		}
-		std::vector<char>  result((size_t)pos);
-
-		ifs.seekg(0, ios::beg);
-		ifs.read(&result[0], pos);
-        ifs.close();
-
-		return result;
-	}
-
 	bool isAlpha(SDL_PixelFormat *format)
 	{
 		if (SDL_ISPIXELFORMAT_ALPHA(format->format))
@@ -119,6 +114,78 @@ namespace {
         return ((x != 0) && !(x & (x - 1)));
     }
 
+    GLenum getCompressedFormat(sre::Texture::Compression compression, bool srgb){
+        switch (compression){
+            case sre::Texture::Compression::BC1:
+                return srgb ? 0x8C4D : 0x83F1;                      // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+            case sre::Texture::Compression::BC3:
+                return srgb ? 0x8C4F : 0x83F3;                      // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+            case sre::Texture::Compression::BC5:
+                return 0x8DBD;                                      // GL_COMPRESSED_RG_RGTC2
+            case sre::Texture::Compression::BC7:
+                return srgb ? 0x8E8D : 0x8E8C;                      // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GL_COMPRESSED_RGBA_BPTC_UNORM
+            case sre::Texture::Compression::ETC2_RGB:
+                return srgb ? 0x9275 : 0x9274;                      // GL_COMPRESSED_SRGB8_ETC2, GL_COMPRESSED_RGB8_ETC2
+            case sre::Texture::Compression::ETC2_RGBA:
+                return srgb ? 0x9279 : 0x9278;                      // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, GL_COMPRESSED_RGBA8_ETC2_EAC
+            default:
+                return 0;
+        }
+    }
+
+    // returns false if the file does not exist
+    bool readFile(const std::string& filename, std::vector<char>& data){
+        std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+        if (!ifs){
+            return false;
+        }
+        auto size = ifs.tellg();
+        if (size <= 0){
+            return false;
+        }
+        data.resize((size_t)size);
+        ifs.seekg(0, std::ios::beg);
+        return (bool)ifs.read(data.data(), size);
+    }
+
+    void createDirectory(const std::string& directory){
+#ifdef _WIN32
+        _mkdir(directory.c_str());
+#else
+        mkdir(directory.c_str(), 0755);
+#endif
+    }
+
+    uint64_t hashData(const char* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull){
+        const uint64_t prime = 0x100000001b3ull;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8){
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; i++){
+            hash = (hash ^ (uint8_t)data[i]) * prime;
+        }
+        return hash;
+    }
+
+    const int streamingTailSize = 64;                               // largest mip level (in pixels) uploaded when a streamed texture is built
+
+    // size in bytes of an uncompressed texture (counted as four bytes per pixel)
+    int uncompressedDataSize(int width, int height, bool cubemap, bool mipmapped){
+        int res = width * height * 4;
+        if (mipmapped){
+            res += (int)((1.0f/3.0f) * res);
+        }
+        // six sides
+        if (cubemap){
+            res *= 6;
+        }
+        return res;
+    }
+
 
 }
 
@@ -126,9 +193,10 @@ namespace sre {
 	std::shared_ptr<Texture> whiteTexture;
     std::shared_ptr<Texture> whiteCubemapTexture;
     std::shared_ptr<Texture> sphereTexture;
+    std::string compressionCacheDirectory;
 
-	Texture::Texture(unsigned int textureId, int width, int height, uint32_t target, std::string name)
-    	: width{ width }, height{ height }, target{ target}, textureId{textureId},name{name} {
+	Texture::Texture(unsigned int textureId, int width, int height, uint32_t target, std::string name, int dataSize)
+    	: width{ width }, height{ height }, target{ target}, textureId{textureId},name{name}, dataSize{dataSize} {
         if (! Renderer::instance ){
             LOG_FATAL("Cannot instantiate sre::Texture before sre::Renderer is created.");
         }
@@ -139,7 +207,8 @@ namespace sre {
 		renderStats.textureBytes += datasize;
 		renderStats.textureBytesAllocated += datasize;
 
-        Renderer::instance->textures.emplace_back(this);
+        auto& textures = Renderer::instance->textures;
+        lruEntry = textures.insert(textures.end(), this);
 	}
 
 	Texture::~Texture() {
@@ -152,9 +221,12 @@ namespace sre {
             renderStats.textureBytes -= datasize;
             renderStats.textureBytesDeallocated += datasize;
 
-            r->textures.erase(std::remove(r->textures.begin(), r->textures.end(), this));
+            r->textures.erase(lruEntry);
 
             glDeleteTextures(1, &textureId);
+            if (pixelBuffers[0] != 0){
+                glDeleteBuffers(2, pixelBuffers);
+            }
         }
 
     }
@@ -164,6 +236,11 @@ namespace sre {
         return *this;
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withMipmapFilter(MipmapFilter filter) {
+        mipmapFilter = filter;
+        return *this;
+    }
+
     GLenum Texture::getFormat(SDL_Surface *image) {
         SDL_PixelFormat *format = image->format;
         auto pixelFormat = format->format;
@@ -206,12 +283,26 @@ namespace sre {
         if (name.length()==0){
             name = filename;
         }
-        auto fileData = readAllBytes(filename.c_str());
+        MappedFile file;                                    // decoded directly from the mapped file
+        if (!file.open(filename)){
+            LOG_ERROR("Cannot read texture from %s",filename.c_str());
+        }
+        withFileData(file.data(), (int) file.size());
+        textureTypeData[GL_TEXTURE_2D].resourcename = filename;
+        sourceFile = filename;
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withFileData(const char *data, int size, bool flipY) {
+        sourceFile.clear();
+        if (TextureContainer::isContainer(data, (size_t)size)){
+            return withContainerData(data, size, flipY);
+        }
         GLenum format;
         int width;
         int height;
         int bytesPerPixel;
-        fileData = loadFileFromMemory(fileData.data(), (int) fileData.size(), format, this->transparent, width, height,bytesPerPixel);
+        auto pixels = loadFileFromMemory(data, size, format, this->transparent, width, height, bytesPerPixel, flipY);
 
         textureTypeData[GL_TEXTURE_2D] = {
                 width,
@@ -219,35 +310,111 @@ namespace sre {
                 transparent,
                 bytesPerPixel,
                 format,
-                filename,
-                fileData
+                "memory",
+                std::move(pixels)
         };
 
         return *this;
     }
 
-    Texture::TextureBuilder &Texture::TextureBuilder::withFileCubemap(std::string filename, CubemapSide side){
-        auto fileData = readAllBytes(filename.c_str());
-        GLenum format;
-        int bytesPerPixel;
-        int width;
-        int height;
-        fileData = loadFileFromMemory(fileData.data(), (int) fileData.size(), format,this->transparent, width, height,bytesPerPixel, false);
-
-        textureTypeData[GL_TEXTURE_CUBE_MAP_POSITIVE_X+(unsigned int)side] = {
-                width,
-                height,
-                transparent,
-                bytesPerPixel,
-                format,
-                filename,
-                fileData
-        };
+    Texture::TextureBuilder &Texture::TextureBuilder::withContainerData(const char *data, int size, bool flipY) {
+        std::string resourcename = name.empty() ? "memory" : name;
+        TextureContainer container;
+        auto& textureDef = textureTypeData[GL_TEXTURE_2D];
+        textureDef = {0, 0, false, 4, GL_RGBA, "memory"};
+        if (!container.load(data, (size_t)size, resourcename)){
+            return *this;
+        }
+        auto compression = container.compression;
+        int levelCount = (int)container.levels.size();
+        // rows are stored bottom-up when flipY is true
+        bool flip = flipY == container.topDown;
+
+        if (isCompressionSupported(compression)){
+            if (flip){
+                bool canFlip = true;
+                for (int i=0;i<levelCount;i++){
+                    canFlip &= BlockCompression::canFlipY(compression, std::max(1, container.height >> i));
+                }
+                if (canFlip){
+                    for (int i=0;i<levelCount;i++){
+                        BlockCompression::flipY(compression, container.levels[i].data(), std::max(1, container.width >> i), std::max(1, container.height >> i));
+                    }
+                } else {
+                    LOG_WARNING("Texture %s cannot be flipped. Uploaded as stored in file.", resourcename.c_str());
+                }
+            }
+            textureDef.compression = compression;
+        } else if (BlockCompression::canDecode(compression)){
+            LOG_WARNING("Texture %s: compression not supported by GPU. Decompressing texture.", resourcename.c_str());
+            for (int i=0;i<levelCount;i++){
+                int levelWidth = std::max(1, container.width >> i);
+                int levelHeight = std::max(1, container.height >> i);
+                container.levels[i] = BlockCompression::decode(compression, container.levels[i].data(), levelWidth, levelHeight);
+                if (flip){
+                    invert_image(levelWidth * 4, levelHeight, container.levels[i].data());
+                }
+            }
+        } else {
+            LOG_ERROR("Cannot load texture %s. Compression not supported by GPU.", resourcename.c_str());
+            return *this;
+        }
+        this->transparent = BlockCompression::isTransparent(compression);
+        textureDef.width = container.width;
+        textureDef.height = container.height;
+        textureDef.transparent = this->transparent;
+        textureDef.data = std::move(container.levels[0]);
+        for (int i=1;i<levelCount;i++){
+            textureDef.mipLevels.push_back(std::move(container.levels[i]));
+        }
+        return *this;
+    }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withFileCubemap(std::string filename, CubemapSide side){
+        cubemapFiles[GL_TEXTURE_CUBE_MAP_POSITIVE_X+(unsigned int)side] = filename;
         return *this;
     }
 
+    void Texture::TextureBuilder::decodeCubemapFiles() {
+        std::vector<std::pair<uint32_t, std::string>> files(cubemapFiles.begin(), cubemapFiles.end());
+        cubemapFiles.clear();
+        std::vector<TextureDefinition*> textureDefs;       // created before decoding in parallel
+        for (auto& file : files){
+            textureDefs.push_back(&textureTypeData[file.first]);
+        }
+        std::vector<char> alpha(files.size(), 0);
+        parallelFor(files.size(), 1, [&](size_t begin, size_t end){
+            for (size_t i = begin; i < end; i++){
+                MappedFile file;
+                if (!file.open(files[i].second)){
+                    LOG_ERROR("Cannot read texture from %s",files[i].second.c_str());
+                    continue;
+                }
+                GLenum format = GL_RGBA;
+                bool transparent = false;
+                int width = 0;
+                int height = 0;
+                int bytesPerPixel = 4;
+                auto pixels = loadFileFromMemory(file.data(), (int) file.size(), format, transparent, width, height, bytesPerPixel, false);
+                *textureDefs[i] = {
+                        width,
+                        height,
+                        transparent,
+                        bytesPerPixel,
+                        format,
+                        files[i].second,
+                        std::move(pixels)
+                };
+                alpha[i] = transparent;
+            }
+        });
+        if (!files.empty()){
+            transparent = std::find(alpha.begin(), alpha.end(), 1) != alpha.end();
+        }
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withRGBData(const char *data, int width, int height) {
+        sourceFile.clear();
 
         int bytesPerPixel = 3;
         textureTypeData[GL_TEXTURE_2D] = {
@@ -268,6 +435,7 @@ namespace sre {
     }
 
     Texture::TextureBuilder &Texture::TextureBuilder::withRGBAData(const char *data, int width, int height) {
+        sourceFile.clear();
         int bytesPerPixel = 4;
         textureTypeData[GL_TEXTURE_2D] = {
                 width,
@@ -288,6 +456,7 @@ namespace sre {
     }
     Texture::TextureBuilder &Texture::TextureBuilder::withDepth(int width, int height, DepthPrecision precision) {
         depthPrecision = precision;
+        sourceFile.clear();
         textureTypeData[GL_TEXTURE_2D] = {
                 width,
                 height,
@@ -300,14 +469,21 @@ namespace sre {
     }
 
     std::shared_ptr<Texture> Texture::TextureBuilder::build() {
-        if (textureId == 0){
+        if (built){
             LOG_FATAL("Texture is already build");
         }
+        built = true;
+        decodeCubemapFiles();
+        glGenTextures(1, &textureId);                       // generated on build, so the texture data can be prepared on another thread
         if (name.length() == 0){
             name = "Unnamed Texture";
         }
         std::map<uint32_t, TextureDefinition>::iterator val;
         TextureDefinition* textureDefPtr;
+        Compression compression = Compression::None;
+        bool prebuiltMipmaps = false;
+        int dataSize = 0;
+        std::unique_ptr<StreamingState> streamingState;
         if (depthPrecision != DepthPrecision::None){
             if (renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2){
                 LOG_FATAL("Depth texture not supported");
@@ -346,6 +522,7 @@ namespace sre {
                 textureDefPtr = &td->second;
                 glTexImage2D(target, 0, internalFormat, textureDefPtr->width,
                              textureDefPtr->height, border, format, type, nullptr);
+                dataSize = uncompressedDataSize(textureDefPtr->width, textureDefPtr->height, false, false);
             }
         } else if ((val = textureTypeData.find(GL_TEXTURE_2D)) != textureTypeData.end()){
             auto& textureDef = val->second;
@@ -363,6 +540,14 @@ namespace sre {
 
             GLint border = 0;
 
+            if (this->compression != Compression::None && textureDef.compression == Compression::None && !textureDef.data.empty()){
+                compress(textureDef);
+            }
+            compression = textureDef.compression;
+            prebuiltMipmaps = !textureDef.mipLevels.empty();
+            if (prebuiltMipmaps){
+                generateMipmaps = true;
+            }
             bool isPOT = isPowerOfTwo(textureDef.width) && isPowerOfTwo(textureDef.height);
             if (!isPOT && filterSampling){
                 LOG_WARNING("Texture %s is not power of two (was %i x %i ). filter sampling ",textureDef.resourcename.c_str(), textureDef.width, textureDef.height);
@@ -372,6 +557,18 @@ namespace sre {
                 LOG_WARNING("Texture %s is not power of two (was %i x %i ). mipmapping disabled ",textureDef.resourcename.c_str(), textureDef.width, textureDef.height);
                 generateMipmaps = false;
             }
+            if (compression != Compression::None && generateMipmaps && !prebuiltMipmaps){
+                LOG_WARNING("Texture %s has no mipmaps. Mipmaps cannot be generated for compressed textures",textureDef.resourcename.c_str());
+                generateMipmaps = false;
+            }
+            if (generateMipmaps && !prebuiltMipmaps && !textureDef.data.empty()){
+                generateMipLevels(textureDef);
+                prebuiltMipmaps = true;
+            }
+            prebuiltMipmaps &= generateMipmaps;
+            if (streaming && !prebuiltMipmaps){
+                LOG_WARNING("Texture %s: Streaming requires mipmaps. Texture is not streamed.",textureDef.resourcename.c_str());
+            }
 
             GLenum type = GL_UNSIGNED_BYTE;
             glBindTexture(target, textureId);
@@ -379,7 +576,46 @@ namespace sre {
             if (this->dumpDebug){
                 textureDef.dumpDebug();
             }
-            glTexImage2D(target, mipmapLevel, internalFormat, textureDef.width, textureDef.height, border, textureDef.format, type, dataPtr);
+            int levelCount = 1 + (prebuiltMipmaps ? (int)textureDef.mipLevels.size() : 0);
+            if (streaming && prebuiltMipmaps){
+                // keep the mip levels on the CPU. The smallest levels are uploaded when the texture is created
+                streamingState.reset(new StreamingState());
+                streamingState->levels.reserve((size_t)levelCount);
+                streamingState->levels.push_back(std::move(textureDef.data));
+                for (auto& level : textureDef.mipLevels){
+                    streamingState->levels.push_back(std::move(level));
+                }
+                textureDef.mipLevels.clear();
+                streamingState->internalFormat = (uint32_t)internalFormat;
+                streamingState->format = textureDef.format;
+                int tailMip = levelCount - 1;
+                while (tailMip > 0 && std::max(textureDef.width >> (tailMip - 1), textureDef.height >> (tailMip - 1)) <= streamingTailSize){
+                    tailMip--;
+                }
+                streamingState->tailMip = tailMip;
+                streamingState->residentMip = levelCount;                         // nothing resident
+                streamingState->requestedMip = tailMip;
+            } else if (compression != Compression::None){
+                GLenum compressedFormat = getCompressedFormat(compression, samplerColorspace == SamplerColorspace::Linear);
+                for (int level = 0; level < levelCount; level++){
+                    auto& levelData = level == 0 ? textureDef.data : textureDef.mipLevels[level-1];
+                    glCompressedTexImage2D(target, level, compressedFormat, std::max(1, textureDef.width >> level), std::max(1, textureDef.height >> level),
+                                           border, (GLsizei)levelData.size(), levelData.data());
+                    dataSize += (int)levelData.size();
+                }
+            } else {
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);          // rows are tightly packed (small RGB levels are not 4 byte aligned)
+                glTexImage2D(target, mipmapLevel, internalFormat, textureDef.width, textureDef.height, border, textureDef.format, type, dataPtr);
+                for (int level = 1; level < levelCount; level++){
+                    glTexImage2D(target, level, internalFormat, std::max(1, textureDef.width >> level), std::max(1, textureDef.height >> level),
+                                 border, textureDef.format, type, textureDef.mipLevels[level-1].data());
+                }
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                dataSize = uncompressedDataSize(textureDef.width, textureDef.height, false, generateMipmaps);
+            }
+            if (prebuiltMipmaps && !streamingState && !(renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2)){
+                glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);   // the mip chain in the file may be incomplete
+            }
         } else {
             for (int i=0;i<6;i++){
                 if ((val = textureTypeData.find(GL_TEXTURE_CUBE_MAP_POSITIVE_X+i)) != textureTypeData.end()) {
@@ -402,8 +638,19 @@ namespace sre {
                     if (this->dumpDebug){
                         textureDef.dumpDebug();
                     }
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // rows are tightly packed
                     glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (unsigned int) i, mipmapLevel, internalFormat,
                                  textureDef.width, textureDef.height, border, textureDef.format, type, dataPtr);
+                    if (generateMipmaps && dataPtr != nullptr && isPowerOfTwo(textureDef.width) && isPowerOfTwo(textureDef.height)){
+                        auto mipLevels = MipmapGenerator::generate(textureDef.data.data(), textureDef.width, textureDef.height, textureDef.bytesPerPixel,
+                                                                   samplerColorspace == SamplerColorspace::Linear, mipmapFilter);
+                        for (int level = 1; level <= (int)mipLevels.size(); level++){
+                            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + (unsigned int) i, level, internalFormat, std::max(1, textureDef.width >> level),
+                                         std::max(1, textureDef.height >> level), border, textureDef.format, type, mipLevels[level-1].data());
+                        }
+                        prebuiltMipmaps = true;
+                    }
+                    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
                 }
             }
         }
@@ -411,18 +658,39 @@ namespace sre {
             LOG_FATAL("Texture contain no data");
             return {};
         }
+        if (target == GL_TEXTURE_CUBE_MAP){
+            bool mipmapped = generateMipmaps && isPowerOfTwo(textureDefPtr->width) && isPowerOfTwo(textureDefPtr->height);
+            dataSize = uncompressedDataSize(textureDefPtr->width, textureDefPtr->height, true, mipmapped);
+        }
 
         // build texture
-        Texture * res = new Texture(textureId, textureDefPtr->width, textureDefPtr->height, target, name);
+        Texture * res = new Texture(textureId, textureDefPtr->width, textureDefPtr->height, target, name, dataSize);
         res->generateMipmap = this->generateMipmaps;
+        res->compression = compression;
 		res->transparent = this->transparent;
 		res->samplerColorspace = this->samplerColorspace;
 		res->depthPrecision = this->depthPrecision;
 		res->wrapUV = this->wrapUV;
-        if (this->generateMipmaps){
+        res->mipmapFilter = this->mipmapFilter;
+        if (target == GL_TEXTURE_2D && !streamingState){
+            res->sourceFile = sourceFile;
+        }
+        if (target == GL_TEXTURE_2D && depthPrecision == DepthPrecision::None && compression == Compression::None){
+            res->pixelFormat = textureDefPtr->format;
+        }
+        if (pixelBuffers && renderInfo().graphicsAPIVersionMajor < 3){
+            LOG_WARNING("Texture %s: Pixel buffers not supported. Using direct uploads.", name.c_str());
+            pixelBuffers = false;
+        }
+        res->usePixelBuffers = pixelBuffers;
+        if (this->generateMipmaps && !prebuiltMipmaps){
             res->invokeGenerateMipmap();
         }
         res->updateTextureSampler(filterSampling, wrapUV);
+        if (streamingState){
+            res->streaming = std::move(streamingState);
+            res->setResidentMip(res->streaming->tailMip);
+        }
 		
         textureId = 0;
         return std::shared_ptr<Texture>(res);
@@ -440,6 +708,111 @@ namespace sre {
 		return *this;
 	}
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withCompression(Compression compression) {
+        this->compression = compression;
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withStreaming(bool enable) {
+        this->streaming = enable;
+        if (enable){
+            generateMipmaps = true;
+        }
+        return *this;
+    }
+
+    Texture::TextureBuilder &Texture::TextureBuilder::withPixelBuffers(bool enable) {
+        this->pixelBuffers = enable;
+        return *this;
+    }
+
+    void Texture::TextureBuilder::generateMipLevels(TextureDefinition &textureDef) {
+        textureDef.mipLevels = MipmapGenerator::generate(textureDef.data.data(), textureDef.width, textureDef.height, textureDef.bytesPerPixel,
+                                                         samplerColorspace == SamplerColorspace::Linear, mipmapFilter);
+    }
+
+    void Texture::TextureBuilder::prepareMipmaps() {
+        auto val = textureTypeData.find(GL_TEXTURE_2D);
+        if (!generateMipmaps || depthPrecision != DepthPrecision::None || compression != Compression::None || val == textureTypeData.end()){
+            return;                                         // compressed textures generate the mip levels when encoding
+        }
+        auto& textureDef = val->second;
+        if (textureDef.data.empty() || !textureDef.mipLevels.empty() || textureDef.compression != Compression::None ||
+            !isPowerOfTwo(textureDef.width) || !isPowerOfTwo(textureDef.height)){
+            return;
+        }
+        generateMipLevels(textureDef);                      // build() uses the levels as prebuilt mipmaps
+    }
+
+    void Texture::TextureBuilder::compress(TextureDefinition &textureDef) {
+        if (!BlockCompression::canEncode(compression)){
+            LOG_WARNING("Texture %s: Cannot encode compression format %i. Texture is not compressed.", name.c_str(), (int)compression);
+            return;
+        }
+        if (!isCompressionSupported(compression)){
+            LOG_WARNING("Texture %s: Compression format %i not supported by GPU. Texture is not compressed.", name.c_str(), (int)compression);
+            return;
+        }
+        int width = textureDef.width;
+        int height = textureDef.height;
+        int bytesPerPixel = textureDef.bytesPerPixel;
+        bool mipmaps = textureDef.mipLevels.empty() && generateMipmaps && isPowerOfTwo(width) && isPowerOfTwo(height);
+
+        TextureContainer container;
+        std::string cacheFile;
+        if (!compressionCacheDirectory.empty()){
+            const uint32_t encoderVersion = 1;                  // increment when the encoder output changes
+            uint32_t key[] = {encoderVersion, (uint32_t)width, (uint32_t)height, (uint32_t)bytesPerPixel, (uint32_t)compression,
+                              (uint32_t)mipmaps, (uint32_t)mipmapFilter, (uint32_t)samplerColorspace, (uint32_t)textureDef.mipLevels.size()};
+            uint64_t hash = hashData(reinterpret_cast<const char*>(key), sizeof(key));
+            hash = hashData(textureDef.data.data(), textureDef.data.size(), hash);
+            for (auto& level : textureDef.mipLevels){
+                hash = hashData(level.data(), level.size(), hash);
+            }
+            char filename[32];
+            snprintf(filename, sizeof(filename), "%016llx.ktx", (unsigned long long)hash);
+            cacheFile = compressionCacheDirectory + "/" + filename;
+            std::vector<char> fileData;
+            if (readFile(cacheFile, fileData) && container.load(fileData.data(), fileData.size(), cacheFile) &&
+                    container.compression == compression && container.width == width && container.height == height){
+                textureDef.data = std::move(container.levels[0]);
+                textureDef.mipLevels.assign(std::make_move_iterator(container.levels.begin() + 1), std::make_move_iterator(container.levels.end()));
+                textureDef.compression = compression;
+                return;
+            }
+        }
+
+        container.width = width;
+        container.height = height;
+        container.compression = compression;
+        container.levels.push_back(BlockCompression::encode(compression, textureDef.data.data(), width, height, bytesPerPixel));
+        for (size_t i=0;i<textureDef.mipLevels.size();i++){
+            int level = (int)i + 1;
+            container.levels.push_back(BlockCompression::encode(compression, textureDef.mipLevels[i].data(),
+                                                                std::max(1, width >> level), std::max(1, height >> level), bytesPerPixel));
+        }
+        if (mipmaps){
+            auto mipLevels = MipmapGenerator::generate(textureDef.data.data(), width, height, bytesPerPixel,
+                                                       samplerColorspace == SamplerColorspace::Linear, mipmapFilter);
+            for (size_t i=0;i<mipLevels.size();i++){
+                int level = (int)i + 1;
+                container.levels.push_back(BlockCompression::encode(compression, mipLevels[i].data(),
+                                                                    std::max(1, width >> level), std::max(1, height >> level), bytesPerPixel));
+            }
+        }
+        if (!cacheFile.empty()){
+            createDirectory(compressionCacheDirectory);
+            auto fileData = container.saveKTX();
+            std::ofstream out(cacheFile, std::ios::binary);
+            if (!out.write(fileData.data(), fileData.size())){
+                LOG_WARNING("Cannot write texture cache %s", cacheFile.c_str());
+            }
+        }
+        textureDef.data = std::move(container.levels[0]);
+        textureDef.mipLevels.assign(std::make_move_iterator(container.levels.begin() + 1), std::make_move_iterator(container.levels.end()));
+        textureDef.compression = compression;
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withWhiteCubemapData(int width, int height) {
 		auto one = (char)0xff;
         std::vector<char> dataOwned (width * height * 4, one);
@@ -462,7 +835,6 @@ namespace sre {
 	}
 
     Texture::TextureBuilder::TextureBuilder() {
-        glGenTextures(1, &textureId);
         if (renderInfo().supportTextureSamplerSRGB == false) {
             samplerColorspace = SamplerColorspace::Gamma;
         }
@@ -567,6 +939,14 @@ namespace sre {
         return Texture::TextureBuilder();
     }
 
+    void Texture::updateMipmaps() {
+        if (mipmapsDirty){
+            glBindTexture(target, textureId);
+            glGenerateMipmap(target);
+            mipmapsDirty = false;
+        }
+    }
+
     void Texture::invokeGenerateMipmap() {
         if ((!isPowerOfTwo((unsigned int)width) || !isPowerOfTwo((unsigned int)height))) {
             LOG_WARNING("Ignore mipmaps for textures not power of two");
@@ -577,17 +957,261 @@ namespace sre {
     }
 
 	int Texture::getDataSize() {
-		int res = width * height * 4;
-		if (generateMipmap){
-			res += (int)((1.0f/3.0f) * res);
-		}
-		// six sides
-		if (target == GL_TEXTURE_CUBE_MAP){
-			res *= 6;
-		}
-		return res;
+		return dataSize;
 	}
 
+    bool Texture::isStreaming() {
+        return streaming != nullptr;
+    }
+
+    int Texture::getResidentMipLevel() {
+        return streaming ? streaming->residentMip : 0;
+    }
+
+    int Texture::getRequestedMipLevel() {
+        return streaming ? streaming->requestedMip : 0;
+    }
+
+    int Texture::streamingDataSize(int mip) {
+        if (compression == Compression::None){
+            return uncompressedDataSize(std::max(1, width >> mip), std::max(1, height >> mip), false, true);
+        }
+        int res = 0;
+        for (int level = mip; level < (int)streaming->levels.size(); level++){
+            res += (int)streaming->levels[level].size();
+        }
+        return res;
+    }
+
+    void Texture::setResidentMip(int mip) {
+        auto& state = *streaming;
+        mip = std::min(std::max(mip, 0), state.tailMip);
+        if (mip == state.residentMip){
+            return;
+        }
+        // upload to a new texture object, since the size of GL level 0 changes
+        GLuint newTextureId;
+        glGenTextures(1, &newTextureId);
+        glBindTexture(target, newTextureId);
+        int levelCount = (int)state.levels.size();
+        GLenum compressedFormat = getCompressedFormat(compression, samplerColorspace == SamplerColorspace::Linear);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);                  // rows are tightly packed
+        for (int level = mip; level < levelCount; level++){
+            auto& levelData = state.levels[level];
+            int levelWidth = std::max(1, width >> level);
+            int levelHeight = std::max(1, height >> level);
+            if (compression != Compression::None){
+                glCompressedTexImage2D(target, level - mip, compressedFormat, levelWidth, levelHeight, 0, (GLsizei)levelData.size(), levelData.data());
+            } else {
+                glTexImage2D(target, level - mip, state.internalFormat, levelWidth, levelHeight, 0, state.format, GL_UNSIGNED_BYTE, levelData.data());
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (!(renderInfo().graphicsAPIVersionES && renderInfo().graphicsAPIVersionMajor <= 2)){
+            glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1 - mip);
+        }
+        glDeleteTextures(1, &textureId);
+        textureId = newTextureId;
+        updateTextureSampler(filterSampling, wrapUV);
+
+        // update stats
+        int newDataSize = streamingDataSize(mip);
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        renderStats.textureBytes += newDataSize - dataSize;
+        renderStats.textureBytesAllocated += newDataSize;
+        renderStats.textureBytesDeallocated += dataSize;
+        dataSize = newDataSize;
+        state.residentMip = mip;
+    }
+
+    bool Texture::isLoaded() {
+        return textureId != 0;
+    }
+
+    int Texture::getLastUsedFrame() {
+        return lastUsedFrame;
+    }
+
+    unsigned int Texture::getNativeTextureId() {
+        markUsed();
+        updateMipmaps();
+        return textureId;
+    }
+
+    bool Texture::isReloadable() {
+        return !sourceFile.empty();
+    }
+
+    void Texture::markUsed() {
+        auto r = Renderer::instance;
+        int frame = r->renderStats.frame;
+        if (lastUsedFrame == frame){
+            return;
+        }
+        lastUsedFrame = frame;
+        r->textures.splice(r->textures.end(), r->textures, lruEntry);     // most recently used last
+        if (textureId == 0 && isReloadable()){
+            reload();
+        }
+    }
+
+    void Texture::unload() {
+        if (textureId == 0 || !isReloadable()){
+            return;
+        }
+        glDeleteTextures(1, &textureId);
+        textureId = 0;
+
+        // update stats
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        renderStats.textureBytes -= dataSize;
+        renderStats.textureBytesDeallocated += dataSize;
+        renderStats.textureUnloads++;
+        dataSize = 0;
+    }
+
+    void Texture::reload() {
+        auto builder = create();
+        builder.withFile(sourceFile);
+        auto& textureDef = builder.textureTypeData[GL_TEXTURE_2D];
+        if (textureDef.data.empty() || textureDef.width != width || textureDef.height != height){
+            LOG_ERROR("Cannot reload texture %s from %s", name.c_str(), sourceFile.c_str());
+            sourceFile.clear();
+            return;
+        }
+        auto loaded = builder.withName(name)
+                .withGenerateMipmaps(generateMipmap)
+                .withMipmapFilter(mipmapFilter)
+                .withSamplerColorspace(samplerColorspace)
+                .withCompression(compression)
+                .withFilterSampling(filterSampling)
+                .withWrapUV(wrapUV)
+                .build();
+        // take the GL texture object (the temporary texture is released with the empty texture object)
+        std::swap(textureId, loaded->textureId);
+        std::swap(dataSize, loaded->dataSize);
+        Renderer::instance->renderStats.textureReloads++;
+    }
+
+    void Texture::disableReload() {
+        if (textureId == 0 && isReloadable()){
+            reload();
+        }
+        sourceFile.clear();
+    }
+
+    void Texture::updateRegion(int x, int y, int width, int height, const char *data, int mipLevel) {
+        if (pixelFormat == 0 || streaming){
+            LOG_ERROR("Cannot update texture %s. Only uncompressed 2D textures (not streamed) can be updated.", name.c_str());
+            return;
+        }
+        int mipCount = 1;
+        if (generateMipmap){
+            while ((std::max(this->width, this->height) >> mipCount) > 0){
+                mipCount++;
+            }
+        }
+        if (mipLevel < 0 || mipLevel >= mipCount){
+            LOG_ERROR("Cannot update texture %s. Invalid mip level %i (mip levels %i).", name.c_str(), mipLevel, mipCount);
+            return;
+        }
+        int levelWidth = std::max(1, this->width >> mipLevel);
+        int levelHeight = std::max(1, this->height >> mipLevel);
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > levelWidth || y + height > levelHeight){
+            LOG_ERROR("Cannot update texture %s. Region %i,%i (%ix%i) is outside mip level %i.", name.c_str(), x, y, width, height, mipLevel);
+            return;
+        }
+        disableReload();                                    // the content no longer matches the file
+        int size = width * height * (pixelFormat == GL_RGB ? 3 : 4);
+        glBindTexture(target, textureId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (usePixelBuffers){
+            if (pixelBuffers[0] == 0){
+                glGenBuffers(2, pixelBuffers);
+            }
+            if (size > pixelBufferSize){
+                // update stats (both buffers)
+                int allocated = 2 * (size - pixelBufferSize);
+                RenderStats& renderStats = Renderer::instance->renderStats;
+                renderStats.textureBytes += allocated;
+                renderStats.textureBytesAllocated += allocated;
+                dataSize += allocated;
+                pixelBufferSize = size;
+            }
+            // write to the other buffer, since the previous upload may still be in progress
+            pixelBufferIndex = (pixelBufferIndex + 1) % 2;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[pixelBufferIndex]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, pixelBufferSize, nullptr, GL_STREAM_DRAW);  // orphan the previous storage
+#ifdef EMSCRIPTEN
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+#else
+            void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (dst != nullptr){
+                memcpy(dst, data, (size_t)size);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            } else {
+                glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+            }
+#endif
+            glTexSubImage2D(target, mipLevel, x, y, width, height, pixelFormat, GL_UNSIGNED_BYTE, nullptr);  // copied from the bound buffer
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            glTexSubImage2D(target, mipLevel, x, y, width, height, pixelFormat, GL_UNSIGNED_BYTE, data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (mipLevel == 0 && generateMipmap){
+            mipmapsDirty = true;                            // regenerated when bound
+        }
+        Renderer::instance->renderStats.textureBytesUpdated += size;
+    }
+
+    void Texture::requestMip(float screenSize) {
+        auto& state = *streaming;
+        int frame = Renderer::instance->renderStats.frame;
+        float mipLevel = (float)state.tailMip;
+        if (screenSize > 0){
+            mipLevel = std::log2(std::max(width, height) / screenSize) + TextureStreamer::getMipBias();
+        }
+        int mip = (int)std::min(std::max(mipLevel, 0.0f), (float)state.tailMip);
+        if (state.lastRequestFrame != frame){
+            state.lastRequestFrame = frame;
+            state.requestedMip = mip;
+        } else {
+            state.requestedMip = std::min(state.requestedMip, mip);
+        }
+    }
+
+    Texture::Compression Texture::getCompression() {
+        return compression;
+    }
+
+    void Texture::setCompressionCacheDirectory(const std::string &directory) {
+        compressionCacheDirectory = directory;
+    }
+
+    const std::string &Texture::getCompressionCacheDirectory() {
+        return compressionCacheDirectory;
+    }
+
+    bool Texture::isCompressionSupported(Compression compression) {
+        auto& info = renderInfo();
+        switch (compression){
+            case Compression::None:
+                return true;
+            case Compression::BC1:
+            case Compression::BC3:
+                return info.supportTextureCompressionS3TC;
+            case Compression::BC5:
+                return info.supportTextureCompressionRGTC;
+            case Compression::BC7:
+                return info.supportTextureCompressionBPTC;
+            case Compression::ETC2_RGB:
+            case Compression::ETC2_RGBA:
+                return info.supportTextureCompressionETC2;
+        }
+        return false;
+    }
+
     bool Texture::isCubemap() {
         return target == GL_TEXTURE_CUBE_MAP;
     }
@@ -624,41 +1248,62 @@ namespace sre {
 
     std::vector<char> Texture::loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY){
 #ifndef EMSCRIPTEN
-        static bool initialized = false;
-        if (!initialized) {
-            initialized = true;
+        // initialized once (thread safe, since textures may be decoded by AssetLoader worker threads)
+        static bool initialized = [](){
             int flags = IMG_INIT_PNG;
             int initted = IMG_Init(flags);
             if ((initted & flags) != flags) {
                 LOG_ERROR("IMG_Init: Failed to init required png support!\nIMG_Init() returned %s",IMG_GetError());
                 // handle error
             }
-        }
+            return true;
+        }();
+        (void)initialized;
 #endif
 
         SDL_RWops *source = SDL_RWFromConstMem(data, dataSize);
-        SDL_Surface *res_texture = IMG_Load_RW(source, 1);
-        if (res_texture == nullptr) {
+        SDL_Surface *image = IMG_Load_RW(source, 1);
+        if (image == nullptr) {
             LOG_ERROR("Cannot load texture. IMG_Load_RW returned %s", IMG_GetError());
             return {};
         }
-        alpha = isAlpha( res_texture->format );
-
-        SDL_Surface *formattedSurf = SDL_ConvertSurfaceFormat(res_texture,
-                                                              alpha ?SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_RGB24, 0);
-        width = formattedSurf->w;
-        height = formattedSurf->h;
-        format = getFormat(formattedSurf);
-
-        bytesPerPixel = format == GL_RGB ? 3 : 4;
-        auto pixels = static_cast<char *>(formattedSurf->pixels);
-        if (invertY){
-            invert_image(width*bytesPerPixel, height, pixels);
+        alpha = isAlpha( image->format );
+        Uint32 pixelFormat = alpha ? SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_RGB24;
+        width = image->w;
+        height = image->h;
+        format = alpha ? GL_RGBA : GL_RGB;
+        bytesPerPixel = alpha ? 4 : 3;
+
+        // the decoded image is written once into the result (rows in upload order)
+        size_t rowSize = (size_t)width * bytesPerPixel;
+        std::vector<char> res(rowSize * height);
+        if (image->format->format == pixelFormat){
+            SDL_LockSurface(image);
+            for (int y=0;y<height;y++){
+                int dstY = invertY ? height - 1 - y : y;
+                memcpy(res.data() + rowSize * dstY, static_cast<char*>(image->pixels) + (size_t)image->pitch * y, rowSize);
+            }
+            SDL_UnlockSurface(image);
+        } else {
+            // convert by blitting into a surface using the result as pixel storage
+            int bpp;
+            Uint32 rMask, gMask, bMask, aMask;
+            SDL_PixelFormatEnumToMasks(pixelFormat, &bpp, &rMask, &gMask, &bMask, &aMask);
+            SDL_Surface* target = SDL_CreateRGBSurfaceFrom(res.data(), width, height, bpp, (int)rowSize, rMask, gMask, bMask, aMask);
+            SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);
+            SDL_SetColorKey(image, SDL_FALSE, 0);           // copy color keyed pixels (alpha comes from the palette)
+            if (invertY){
+                for (int y=0;y<height;y++){
+                    SDL_Rect srcRect{0, y, width, 1};
+                    SDL_Rect dstRect{0, height - 1 - y, width, 1};
+                    SDL_BlitSurface(image, &srcRect, target, &dstRect);
+                }
+            } else {
+                SDL_BlitSurface(image, nullptr, target, nullptr);
+            }
+            SDL_FreeSurface(target);
         }
-
-        std::vector<char> res(pixels, pixels+width*bytesPerPixel*height);
-        SDL_FreeSurface(formattedSurf);
-        SDL_FreeSurface(res_texture);
+        SDL_FreeSurface(image);
 
         return res;
     }
@@ -671,6 +1316,8 @@ namespace sre {
         std::cout << "BytesPerPixel "<<bytesPerPixel<<std::endl;
         std::cout << "Format "<<format<<std::endl;
         std::cout << "Resourcename "<<resourcename<<std::endl;
+        std::cout << "Compression "<<(int)compression<<std::endl;
+        std::cout << "Mip levels "<<mipLevels.size()<<std::endl;
         std::cout << "Data";
         // store formatting
         std::ios_base::fmtflags oldFlags = std::cout.flags();
@@ -0,0 +1,155 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/TextureStreamer.hpp"
+
+#include <algorithm>
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+
+namespace sre {
+    TextureStreamer *TextureStreamer::instance() {
+        if (Renderer::instance == nullptr){
+            LOG_FATAL("Cannot use sre::TextureStreamer before sre::Renderer is created.");
+        }
+        return Renderer::instance->textureStreamer.get();
+    }
+
+    void TextureStreamer::setBudget(int64_t bytes) {
+        instance()->budget = std::max(bytes, (int64_t)0);
+    }
+
+    int64_t TextureStreamer::getBudget() {
+        return instance()->budget;
+    }
+
+    void TextureStreamer::setUploadLimit(int64_t bytes) {
+        instance()->uploadLimit = std::max(bytes, (int64_t)0);
+    }
+
+    int64_t TextureStreamer::getUploadLimit() {
+        return instance()->uploadLimit;
+    }
+
+    void TextureStreamer::setMipBias(float bias) {
+        instance()->mipBias = bias;
+    }
+
+    float TextureStreamer::getMipBias() {
+        return instance()->mipBias;
+    }
+
+    void TextureStreamer::evictAll() {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        for (auto tex : Renderer::instance->textures){
+            if (tex->streaming && tex->streaming->residentMip < tex->streaming->tailMip){
+                renderStats.textureStreamingEvictions += tex->streaming->tailMip - tex->streaming->residentMip;
+                tex->setResidentMip(tex->streaming->tailMip);
+            } else if (!tex->streaming && tex->isReloadable()){
+                tex->unload();
+            }
+        }
+    }
+
+    int64_t TextureStreamer::evict(const std::vector<Texture*>& leastRecentlyUsed, int64_t bytes, int frame, Texture* exclude) {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        int64_t released = 0;
+        for (auto tex : leastRecentlyUsed){
+            if (released >= bytes){
+                break;
+            }
+            if (tex == exclude){
+                continue;
+            }
+            if (!tex->streaming){
+                if (tex->lastUsedFrame != frame && tex->isLoaded()){       // reloaded from file when used again
+                    released += tex->getDataSize();
+                    tex->unload();
+                }
+                continue;
+            }
+            auto& state = *tex->streaming;
+            int maxMip = state.lastRequestFrame == frame ? state.requestedMip : state.tailMip; // keep what is needed this frame
+            if (state.residentMip >= maxMip){
+                continue;
+            }
+            int mip = state.residentMip;
+            do {
+                mip++;
+            } while (mip < maxMip && tex->dataSize - tex->streamingDataSize(mip) < bytes - released);
+            released += tex->dataSize - tex->streamingDataSize(mip);
+            renderStats.textureStreamingEvictions += mip - state.residentMip;
+            tex->setResidentMip(mip);
+        }
+        return released;
+    }
+
+    void TextureStreamer::update() {
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        int frame = renderStats.frame;
+        std::vector<Texture*> evictable;                    // least recently used first (the order of Renderer::textures)
+        for (auto tex : Renderer::instance->textures){
+            if (tex->streaming || tex->isReloadable()){
+                evictable.push_back(tex);
+            }
+        }
+
+        if (budget > 0 && renderStats.textureBytes > budget){
+            evict(evictable, renderStats.textureBytes - budget, frame, nullptr);
+        }
+
+        // upload one more mip level of the streamed textures used this frame
+        int64_t uploaded = 0;
+        for (auto iter = evictable.rbegin(); iter != evictable.rend(); iter++){
+            auto tex = *iter;
+            if (tex->lastUsedFrame != frame){
+                break;                                      // remaining textures are not used this frame
+            }
+            if (!tex->streaming){
+                continue;
+            }
+            auto& state = *tex->streaming;
+            if (state.lastRequestFrame != frame || state.requestedMip >= state.residentMip){
+                continue;
+            }
+            int mip = state.residentMip - 1;
+            int size = tex->streamingDataSize(mip);
+            if (uploaded > 0 && uploaded + size > uploadLimit){
+                continue;
+            }
+            if (budget > 0){
+                int64_t required = renderStats.textureBytes + size - tex->dataSize - budget;
+                if (required > 0 && evict(evictable, required, frame, tex) < required){
+                    continue;
+                }
+            }
+            tex->setResidentMip(mip);
+            uploaded += size;
+            renderStats.textureStreamingUploads++;
+        }
+
+        // update stats
+        renderStats.textureBudget = budget;
+        renderStats.textureStreamingCount = 0;
+        renderStats.textureStreamingPending = 0;
+        renderStats.textureStreamingMissingMips = 0;
+        renderStats.textureUnloadedCount = 0;
+        for (auto tex : evictable){
+            if (!tex->streaming){
+                renderStats.textureUnloadedCount += tex->isLoaded() ? 0 : 1;
+                continue;
+            }
+            renderStats.textureStreamingCount++;
+            auto& state = *tex->streaming;
+            if (state.lastRequestFrame == frame && state.requestedMip < state.residentMip){
+                renderStats.textureStreamingPending++;
+                renderStats.textureStreamingMissingMips += state.residentMip - state.requestedMip;
+            }
+        }
+    }
+}
@@ -0,0 +1,812 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/BlockCompression.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include "sre/impl/ParallelFor.hpp"
+#include "sre/impl/Simd.hpp"
+
+namespace sre {
+    namespace {
+        typedef uint8_t Pixels[16][4];                                      // RGBA of a 4x4 block (row by row)
+
+        uint8_t clamp255(int v){
+            return (uint8_t)std::min(255, std::max(0, v));
+        }
+
+        // BC1 color block (also used as the color part of BC3)
+        void decodeBC1(const uint8_t* b, Pixels& out, bool allowTransparent){
+            int c0 = b[0] | (b[1] << 8);
+            int c1 = b[2] | (b[3] << 8);
+            int palette[4][4];
+            for (int i=0;i<2;i++){
+                int c = i==0 ? c0 : c1;
+                int r = (c >> 11) & 31;
+                int g = (c >> 5) & 63;
+                int bl = c & 31;
+                palette[i][0] = (r << 3) | (r >> 2);
+                palette[i][1] = (g << 2) | (g >> 4);
+                palette[i][2] = (bl << 3) | (bl >> 2);
+                palette[i][3] = 255;
+            }
+            bool fourColors = c0 > c1 || !allowTransparent;
+            for (int i=0;i<3;i++){
+                if (fourColors){
+                    palette[2][i] = (2*palette[0][i] + palette[1][i]) / 3;
+                    palette[3][i] = (palette[0][i] + 2*palette[1][i]) / 3;
+                } else {
+                    palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+                    palette[3][i] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = fourColors ? 255 : 0;
+            uint32_t indices = b[4] | (b[5] << 8) | (b[6] << 16) | ((uint32_t)b[7] << 24);
+            for (int i=0;i<16;i++){
+                int* c = palette[(indices >> (2*i)) & 3];
+                for (int j=0;j<4;j++){
+                    out[i][j] = (uint8_t)c[j];
+                }
+            }
+        }
+
+        // BC4 single channel block (alpha of BC3, red and green of BC5)
+        void decodeBC4(const uint8_t* b, Pixels& out, int channel){
+            int a0 = b[0];
+            int a1 = b[1];
+            int palette[8] = {a0, a1};
+            if (a0 > a1){
+                for (int i=1;i<7;i++){
+                    palette[i+1] = ((7-i)*a0 + i*a1) / 7;
+                }
+            } else {
+                for (int i=1;i<5;i++){
+                    palette[i+1] = ((5-i)*a0 + i*a1) / 5;
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+            uint64_t indices = 0;
+            for (int i=0;i<6;i++){
+                indices |= (uint64_t)b[2+i] << (8*i);
+            }
+            for (int i=0;i<16;i++){
+                out[i][channel] = (uint8_t)palette[(indices >> (3*i)) & 7];
+            }
+        }
+
+        const int etcModifiers[8][2] = {{2,8},{5,17},{9,29},{13,42},{18,60},{24,80},{33,106},{47,183}};
+        const int etcDistances[8] = {3,6,11,16,23,32,41,64};
+
+        const int eacModifiers[16][8] = {
+                {-3,-6,-9,-15,2,5,8,14},
+                {-3,-7,-10,-13,2,6,9,12},
+                {-2,-5,-8,-13,1,4,7,12},
+                {-2,-4,-6,-13,1,3,5,12},
+                {-3,-6,-8,-12,2,5,7,11},
+                {-3,-7,-9,-11,2,6,8,10},
+                {-4,-7,-8,-11,3,6,7,10},
+                {-3,-5,-8,-11,2,4,7,10},
+                {-2,-6,-8,-10,1,5,7,9},
+                {-2,-5,-8,-10,1,4,7,9},
+                {-2,-4,-8,-10,1,3,7,9},
+                {-2,-5,-7,-10,1,4,6,9},
+                {-3,-4,-7,-10,2,3,6,9},
+                {-1,-2,-3,-10,0,1,2,9},
+                {-4,-6,-8,-9,3,5,7,8},
+                {-3,-5,-7,-9,2,4,6,8}
+        };
+
+        int extend4(int v){ return (v << 4) | v; }
+        int extend5(int v){ return (v << 3) | (v >> 2); }
+        int extend6(int v){ return (v << 2) | (v >> 4); }
+        int extend7(int v){ return (v << 1) | (v >> 6); }
+        int signed3(uint32_t v){ return (int)(v ^ 4) - 4; }
+
+        // ETC2 RGB block (individual, differential, T, H and planar mode). The block is stored big endian and the
+        // pixel indices are stored column by column
+        void decodeETC2(const uint8_t* b, Pixels& out){
+            uint32_t hi = ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+            uint32_t lo = ((uint32_t)b[4] << 24) | (b[5] << 16) | (b[6] << 8) | b[7];
+            bool diff = ((hi >> 1) & 1) != 0;
+            bool flip = (hi & 1) != 0;
+            int base[2][3];
+            if (diff){
+                int r = (hi >> 27) & 31, g = (hi >> 19) & 31, bl = (hi >> 11) & 31;
+                int r2 = r + signed3(hi >> 24 & 7);
+                int g2 = g + signed3(hi >> 16 & 7);
+                int b2 = bl + signed3(hi >> 8 & 7);
+                if (r2 < 0 || r2 > 31 || g2 < 0 || g2 > 31){
+                    // T mode (red overflow) or H mode (green overflow)
+                    bool tMode = r2 < 0 || r2 > 31;
+                    int c[2][3];
+                    int distance;
+                    if (tMode){
+                        c[0][0] = extend4((((hi >> 27) & 3) << 2) | ((hi >> 24) & 3));
+                        c[0][1] = extend4((hi >> 20) & 15);
+                        c[0][2] = extend4((hi >> 16) & 15);
+                        c[1][0] = extend4((hi >> 12) & 15);
+                        c[1][1] = extend4((hi >> 8) & 15);
+                        c[1][2] = extend4((hi >> 4) & 15);
+                        distance = etcDistances[(((hi >> 2) & 3) << 1) | (hi & 1)];
+                    } else {
+                        c[0][0] = extend4((hi >> 27) & 15);
+                        c[0][1] = extend4((((hi >> 24) & 7) << 1) | ((hi >> 20) & 1));
+                        c[0][2] = extend4((((hi >> 19) & 1) << 3) | ((hi >> 15) & 7));
+                        c[1][0] = extend4((hi >> 11) & 15);
+                        c[1][1] = extend4((hi >> 7) & 15);
+                        c[1][2] = extend4((hi >> 3) & 15);
+                        int c0 = (c[0][0] << 16) | (c[0][1] << 8) | c[0][2];
+                        int c1 = (c[1][0] << 16) | (c[1][1] << 8) | c[1][2];
+                        distance = etcDistances[(((hi >> 2) & 1) << 2) | ((hi & 1) << 1) | (c0 >= c1 ? 1 : 0)];
+                    }
+                    uint8_t paint[4][3];
+                    for (int i=0;i<3;i++){
+                        if (tMode){
+                            paint[0][i] = (uint8_t)c[0][i];
+                            paint[1][i] = clamp255(c[1][i] + distance);
+                            paint[2][i] = (uint8_t)c[1][i];
+                            paint[3][i] = clamp255(c[1][i] - distance);
+                        } else {
+                            paint[0][i] = clamp255(c[0][i] + distance);
+                            paint[1][i] = clamp255(c[0][i] - distance);
+                            paint[2][i] = clamp255(c[1][i] + distance);
+                            paint[3][i] = clamp255(c[1][i] - distance);
+                        }
+                    }
+                    for (int p=0;p<16;p++){
+                        int x = p / 4, y = p % 4;
+                        int index = (((lo >> (16+p)) & 1) << 1) | ((lo >> p) & 1);
+                        memcpy(out[y*4+x], paint[index], 3);
+                        out[y*4+x][3] = 255;
+                    }
+                    return;
+                }
+                if (b2 < 0 || b2 > 31){
+                    // planar mode
+                    int ro = extend6((hi >> 25) & 63);
+                    int go = extend7((((hi >> 24) & 1) << 6) | ((hi >> 17) & 63));
+                    int bo = extend6((((hi >> 16) & 1) << 5) | (((hi >> 11) & 3) << 3) | ((hi >> 7) & 7));
+                    int rh = extend6((((hi >> 2) & 31) << 1) | (hi & 1));
+                    int gh = extend7((lo >> 25) & 127);
+                    int bh = extend6((lo >> 19) & 63);
+                    int rv = extend6((lo >> 13) & 63);
+                    int gv = extend7((lo >> 6) & 127);
+                    int bv = extend6(lo & 63);
+                    for (int y=0;y<4;y++){
+                        for (int x=0;x<4;x++){
+                            uint8_t* p = out[y*4+x];
+                            p[0] = clamp255((x*(rh-ro) + y*(rv-ro) + 4*ro + 2) >> 2);
+                            p[1] = clamp255((x*(gh-go) + y*(gv-go) + 4*go + 2) >> 2);
+                            p[2] = clamp255((x*(bh-bo) + y*(bv-bo) + 4*bo + 2) >> 2);
+                            p[3] = 255;
+                        }
+                    }
+                    return;
+                }
+                base[0][0] = extend5(r); base[0][1] = extend5(g); base[0][2] = extend5(bl);
+                base[1][0] = extend5(r2); base[1][1] = extend5(g2); base[1][2] = extend5(b2);
+            } else {
+                base[0][0] = extend4((hi >> 28) & 15); base[1][0] = extend4((hi >> 24) & 15);
+                base[0][1] = extend4((hi >> 20) & 15); base[1][1] = extend4((hi >> 16) & 15);
+                base[0][2] = extend4((hi >> 12) & 15); base[1][2] = extend4((hi >> 8) & 15);
+            }
+            const int* table[2] = {etcModifiers[(hi >> 5) & 7], etcModifiers[(hi >> 2) & 7]};
+            for (int p=0;p<16;p++){
+                int x = p / 4, y = p % 4;
+                int subBlock = flip ? (y >= 2) : (x >= 2);
+                int modifier = table[subBlock][(lo >> p) & 1];
+                if ((lo >> (16+p)) & 1){
+                    modifier = -modifier;
+                }
+                uint8_t* c = out[y*4+x];
+                for (int i=0;i<3;i++){
+                    c[i] = clamp255(base[subBlock][i] + modifier);
+                }
+                c[3] = 255;
+            }
+        }
+
+        // EAC alpha block of ETC2 RGBA
+        void decodeEAC(const uint8_t* b, Pixels& out){
+            int base = b[0];
+            int multiplier = b[1] >> 4;
+            const int* table = eacModifiers[b[1] & 15];
+            uint64_t indices = 0;
+            for (int i=2;i<8;i++){
+                indices = (indices << 8) | b[i];
+            }
+            for (int p=0;p<16;p++){
+                int x = p / 4, y = p % 4;
+                out[y*4+x][3] = clamp255(base + table[(indices >> (45 - 3*p)) & 7] * multiplier);
+            }
+        }
+
+        void decodeBlock(Texture::Compression compression, const uint8_t* b, Pixels& out){
+            switch (compression){
+                case Texture::Compression::BC1:
+                    decodeBC1(b, out, true);
+                    break;
+                case Texture::Compression::BC3:
+                    decodeBC1(b+8, out, false);
+                    decodeBC4(b, out, 3);
+                    break;
+                case Texture::Compression::BC5:
+                    decodeBC4(b, out, 0);
+                    decodeBC4(b+8, out, 1);
+                    for (int i=0;i<16;i++){
+                        out[i][2] = 0;
+                        out[i][3] = 255;
+                    }
+                    break;
+                case Texture::Compression::ETC2_RGB:
+                    decodeETC2(b, out);
+                    break;
+                case Texture::Compression::ETC2_RGBA:
+                    decodeETC2(b+8, out);
+                    decodeEAC(b, out);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Reverse the first rowCount rows of a BC1 color block
+        void flipBC1(uint8_t* b, int rowCount){
+            std::reverse(b+4, b+4+rowCount);
+        }
+
+        // Reverse the first rowCount rows of a BC4 block (rows of 12 bits)
+        void flipBC4(uint8_t* b, int rowCount){
+            uint64_t indices = 0;
+            for (int i=0;i<6;i++){
+                indices |= (uint64_t)b[2+i] << (8*i);
+            }
+            uint64_t res = indices;
+            for (int row=0;row<rowCount;row++){
+                uint64_t bits = (indices >> (12*row)) & 0xfff;
+                int dst = rowCount - 1 - row;
+                res = (res & ~(0xfffull << (12*dst))) | (bits << (12*dst));
+            }
+            for (int i=0;i<6;i++){
+                b[2+i] = (uint8_t)(res >> (8*i));
+            }
+        }
+
+        void flipBlock(Texture::Compression compression, uint8_t* b, int rowCount){
+            switch (compression){
+                case Texture::Compression::BC1:
+                    flipBC1(b, rowCount);
+                    break;
+                case Texture::Compression::BC3:
+                    flipBC4(b, rowCount);
+                    flipBC1(b+8, rowCount);
+                    break;
+                case Texture::Compression::BC5:
+                    flipBC4(b, rowCount);
+                    flipBC4(b+8, rowCount);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // Encoding
+
+        // Read a 4x4 block from RGB or RGBA data (edge pixels are repeated for partial blocks)
+        void loadBlock(const char* data, int width, int height, int bytesPerPixel, int bx, int by, Pixels& out){
+            for (int y=0;y<4;y++){
+                int sy = std::min(by*4 + y, height - 1);
+                for (int x=0;x<4;x++){
+                    int sx = std::min(bx*4 + x, width - 1);
+                    auto src = reinterpret_cast<const uint8_t*>(data) + ((size_t)sy * width + sx) * bytesPerPixel;
+                    uint8_t* dst = out[y*4+x];
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = src[2];
+                    dst[3] = bytesPerPixel == 4 ? src[3] : (uint8_t)255;
+                }
+            }
+        }
+
+        uint16_t to565(float r, float g, float b){
+            int r5 = (int)(std::min(255.0f, std::max(0.0f, r)) * 31 / 255 + 0.5f);
+            int g6 = (int)(std::min(255.0f, std::max(0.0f, g)) * 63 / 255 + 0.5f);
+            int b5 = (int)(std::min(255.0f, std::max(0.0f, b)) * 31 / 255 + 0.5f);
+            return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+        }
+
+        void from565(uint16_t c, int* out){
+            int r = (c >> 11) & 31;
+            int g = (c >> 5) & 63;
+            int b = c & 31;
+            out[0] = (r << 3) | (r >> 2);
+            out[1] = (g << 2) | (g >> 4);
+            out[2] = (b << 3) | (b >> 2);
+        }
+
+        // BC1 palette in four color mode
+        void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][3]){
+            from565(c0, palette[0]);
+            from565(c1, palette[1]);
+            for (int i=0;i<3;i++){
+                palette[2][i] = (2*palette[0][i] + palette[1][i]) / 3;
+                palette[3][i] = (palette[0][i] + 2*palette[1][i]) / 3;
+            }
+        }
+
+        // Choose the palette index of each pixel by projecting the pixels on the line between the two endpoints
+        uint32_t bc1Indices(const Pixels& px, const int palette[4][3]){
+            int dir[3] = {palette[0][0] - palette[1][0], palette[0][1] - palette[1][1], palette[0][2] - palette[1][2]};
+            int stops[4];
+            for (int i=0;i<4;i++){
+                stops[i] = palette[i][0]*dir[0] + palette[i][1]*dir[1] + palette[i][2]*dir[2];
+            }
+            // palette order along dir is 0, 2, 3, 1. Thresholds are the midpoints (doubled to stay in integers)
+            int t0 = stops[0] + stops[2];
+            int t1 = stops[2] + stops[3];
+            int t2 = stops[3] + stops[1];
+            const uint32_t indexFromCount[4] = {1, 3, 2, 0};
+            uint32_t indices = 0;
+#ifdef SRE_SSE2
+            __m128i dirv = _mm_setr_epi16((short)dir[0], (short)dir[1], (short)dir[2], 0, (short)dir[0], (short)dir[1], (short)dir[2], 0);
+            __m128i zero = _mm_setzero_si128();
+            __m128i t0v = _mm_set1_epi32(t0 - 1);
+            __m128i t1v = _mm_set1_epi32(t1 - 1);
+            __m128i t2v = _mm_set1_epi32(t2 - 1);
+            for (int i=0;i<16;i+=4){
+                __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px[i]));
+                __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(p, zero), dirv);  // r*dr+g*dg, b*db for pixel i, i+1
+                __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(p, zero), dirv);  // pixel i+2, i+3
+                __m128 a = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2,0,2,0));
+                __m128 b = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3,1,3,1));
+                __m128i dots = _mm_slli_epi32(_mm_add_epi32(_mm_castps_si128(a), _mm_castps_si128(b)), 1);
+                __m128i count = _mm_add_epi32(_mm_add_epi32(_mm_cmpgt_epi32(dots, t0v), _mm_cmpgt_epi32(dots, t1v)), _mm_cmpgt_epi32(dots, t2v));
+                int32_t counts[4];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(counts), count);
+                for (int j=0;j<4;j++){
+                    indices |= indexFromCount[-counts[j]] << (2*(i+j));
+                }
+            }
+#else
+            for (int i=0;i<16;i++){
+                int dot = 2*(px[i][0]*dir[0] + px[i][1]*dir[1] + px[i][2]*dir[2]);
+                int count = (dot >= t0) + (dot >= t1) + (dot >= t2);
+                indices |= indexFromCount[count] << (2*i);
+            }
+#endif
+            return indices;
+        }
+
+        int bc1Error(const Pixels& px, const int palette[4][3], uint32_t indices){
+            int error = 0;
+            for (int i=0;i<16;i++){
+                const int* c = palette[(indices >> (2*i)) & 3];
+                for (int j=0;j<3;j++){
+                    int d = px[i][j] - c[j];
+                    error += d*d;
+                }
+            }
+            return error;
+        }
+
+        // Least squares endpoints for the given indices
+        bool bc1Refine(const Pixels& px, uint32_t indices, uint16_t& c0, uint16_t& c1){
+            const float weight[4] = {1, 0, 2/3.0f, 1/3.0f};
+            float aa = 0, bb = 0, ab = 0;
+            float ax[3] = {0,0,0}, bx[3] = {0,0,0};
+            for (int i=0;i<16;i++){
+                float a = weight[(indices >> (2*i)) & 3];
+                float b = 1 - a;
+                aa += a*a;
+                bb += b*b;
+                ab += a*b;
+                for (int j=0;j<3;j++){
+                    ax[j] += a*px[i][j];
+                    bx[j] += b*px[i][j];
+                }
+            }
+            float det = aa*bb - ab*ab;
+            if (std::abs(det) < 1e-4f){
+                return false;
+            }
+            float e0[3], e1[3];
+            for (int j=0;j<3;j++){
+                e0[j] = (ax[j]*bb - bx[j]*ab) / det;
+                e1[j] = (bx[j]*aa - ax[j]*ab) / det;
+            }
+            c0 = to565(e0[0], e0[1], e0[2]);
+            c1 = to565(e1[0], e1[1], e1[2]);
+            return true;
+        }
+
+        void encodeBC1(const Pixels& px, uint8_t* out){
+            // principal axis of the colors (power iteration on the covariance matrix)
+            float mean[3] = {0,0,0};
+            for (int i=0;i<16;i++){
+                for (int j=0;j<3;j++){
+                    mean[j] += px[i][j] / 16.0f;
+                }
+            }
+            float cov[3][3] = {};
+            for (int i=0;i<16;i++){
+                float d[3] = {px[i][0] - mean[0], px[i][1] - mean[1], px[i][2] - mean[2]};
+                for (int j=0;j<3;j++){
+                    for (int k=0;k<3;k++){
+                        cov[j][k] += d[j]*d[k];
+                    }
+                }
+            }
+            float axis[3] = {1, 1, 1};
+            for (int iteration=0;iteration<4;iteration++){
+                float v[3];
+                for (int j=0;j<3;j++){
+                    v[j] = cov[j][0]*axis[0] + cov[j][1]*axis[1] + cov[j][2]*axis[2];
+                }
+                float length = std::max(std::abs(v[0]), std::max(std::abs(v[1]), std::abs(v[2])));
+                if (length < 1e-6f){
+                    break;
+                }
+                for (int j=0;j<3;j++){
+                    axis[j] = v[j] / length;
+                }
+            }
+            // use the extreme pixels along the axis as endpoints
+            int minIndex = 0, maxIndex = 0;
+            float minDot = 1e30f, maxDot = -1e30f;
+            for (int i=0;i<16;i++){
+                float dot = px[i][0]*axis[0] + px[i][1]*axis[1] + px[i][2]*axis[2];
+                if (dot < minDot){ minDot = dot; minIndex = i; }
+                if (dot > maxDot){ maxDot = dot; maxIndex = i; }
+            }
+            uint16_t c0 = to565(px[maxIndex][0], px[maxIndex][1], px[maxIndex][2]);
+            uint16_t c1 = to565(px[minIndex][0], px[minIndex][1], px[minIndex][2]);
+            int palette[4][3];
+            bc1Palette(c0, c1, palette);
+            uint32_t indices = bc1Indices(px, palette);
+            int error = bc1Error(px, palette, indices);
+
+            uint16_t r0, r1;
+            if (c0 != c1 && bc1Refine(px, indices, r0, r1)){
+                bc1Palette(r0, r1, palette);
+                uint32_t refinedIndices = bc1Indices(px, palette);
+                int refinedError = bc1Error(px, palette, refinedIndices);
+                if (refinedError < error){
+                    c0 = r0;
+                    c1 = r1;
+                    indices = refinedIndices;
+                }
+            }
+            // four color mode requires c0 > c1
+            if (c0 < c1){
+                std::swap(c0, c1);
+                indices ^= 0x55555555;
+            } else if (c0 == c1){
+                indices = 0;
+            }
+            out[0] = (uint8_t)c0; out[1] = (uint8_t)(c0 >> 8);
+            out[2] = (uint8_t)c1; out[3] = (uint8_t)(c1 >> 8);
+            for (int i=0;i<4;i++){
+                out[4+i] = (uint8_t)(indices >> (8*i));
+            }
+        }
+
+        void encodeBC4(const Pixels& px, int channel, uint8_t* out){
+            int minValue = 255, maxValue = 0;
+            for (int i=0;i<16;i++){
+                minValue = std::min(minValue, (int)px[i][channel]);
+                maxValue = std::max(maxValue, (int)px[i][channel]);
+            }
+            // eight value mode (a0 > a1): index 0 = max, 1 = min, 2..7 interpolated from max to min
+            out[0] = (uint8_t)maxValue;
+            out[1] = (uint8_t)minValue;
+            uint64_t indices = 0;
+            int range = maxValue - minValue;
+            if (range > 0){
+                for (int i=0;i<16;i++){
+                    int t = ((maxValue - px[i][channel]) * 14 + range) / (2 * range);
+                    uint64_t index = t == 0 ? 0 : (t == 7 ? 1 : t + 1);
+                    indices |= index << (3*i);
+                }
+            }
+            for (int i=0;i<6;i++){
+                out[2+i] = (uint8_t)(indices >> (8*i));
+            }
+        }
+
+        // Best modifier table and indices for a sub block of an ETC block. Returns the squared error
+        int etcSubBlock(const Pixels& px, const int* pixels, const int* base, int& table, int* indices){
+            int bestError = 0x7fffffff;
+            for (int t=0;t<8;t++){
+                int modifiers[4] = {etcModifiers[t][0], etcModifiers[t][1], -etcModifiers[t][0], -etcModifiers[t][1]};
+                int error = 0;
+                int tableIndices[8];
+                for (int i=0;i<8 && error < bestError;i++){
+                    const uint8_t* p = px[pixels[i]];
+                    int best = 0x7fffffff;
+                    for (int m=0;m<4;m++){
+                        int e = 0;
+                        for (int j=0;j<3;j++){
+                            int d = p[j] - clamp255(base[j] + modifiers[m]);
+                            e += d*d;
+                        }
+                        if (e < best){
+                            best = e;
+                            tableIndices[i] = m;
+                        }
+                    }
+                    error += best;
+                }
+                if (error < bestError){
+                    bestError = error;
+                    table = t;
+                    std::copy(tableIndices, tableIndices+8, indices);
+                }
+            }
+            return bestError;
+        }
+
+        // ETC2 RGB block using the individual and differential modes (ETC1 compatible)
+        void encodeETC2(const Pixels& px, uint8_t* out){
+            int bestError = 0x7fffffff;
+            uint32_t bestHi = 0, bestLo = 0;
+            for (int flip=0;flip<2;flip++){
+                int pixels[2][8];                                           // pixel (y*4+x) of each sub block
+                int count[2] = {0, 0};
+                float average[2][3] = {};
+                for (int y=0;y<4;y++){
+                    for (int x=0;x<4;x++){
+                        int subBlock = flip ? (y >= 2) : (x >= 2);
+                        pixels[subBlock][count[subBlock]++] = y*4+x;
+                        for (int j=0;j<3;j++){
+                            average[subBlock][j] += px[y*4+x][j] / 8.0f;
+                        }
+                    }
+                }
+                for (int differential=0;differential<2;differential++){
+                    int quantized[2][3];
+                    int base[2][3];
+                    bool valid = true;
+                    for (int s=0;s<2;s++){
+                        for (int j=0;j<3;j++){
+                            if (differential){
+                                quantized[s][j] = (int)(average[s][j] * 31 / 255 + 0.5f);
+                                base[s][j] = extend5(quantized[s][j]);
+                            } else {
+                                quantized[s][j] = (int)(average[s][j] * 15 / 255 + 0.5f);
+                                base[s][j] = extend4(quantized[s][j]);
+                            }
+                        }
+                    }
+                    if (differential){
+                        for (int j=0;j<3;j++){
+                            int d = quantized[1][j] - quantized[0][j];
+                            valid &= d >= -4 && d <= 3;
+                        }
+                    }
+                    if (!valid){
+                        continue;
+                    }
+                    int table[2];
+                    int indices[2][8];
+                    int error = etcSubBlock(px, pixels[0], base[0], table[0], indices[0]) +
+                                etcSubBlock(px, pixels[1], base[1], table[1], indices[1]);
+                    if (error >= bestError){
+                        continue;
+                    }
+                    bestError = error;
+                    if (differential){
+                        bestHi = (quantized[0][0] << 27) | (((quantized[1][0] - quantized[0][0]) & 7) << 24) |
+                                 (quantized[0][1] << 19) | (((quantized[1][1] - quantized[0][1]) & 7) << 16) |
+                                 (quantized[0][2] << 11) | (((quantized[1][2] - quantized[0][2]) & 7) << 8) | 2;
+                    } else {
+                        bestHi = ((uint32_t)quantized[0][0] << 28) | (quantized[1][0] << 24) |
+                                 (quantized[0][1] << 20) | (quantized[1][1] << 16) |
+                                 (quantized[0][2] << 12) | (quantized[1][2] << 8);
+                    }
+                    bestHi |= (table[0] << 5) | (table[1] << 2) | flip;
+                    bestLo = 0;
+                    for (int s=0;s<2;s++){
+                        for (int i=0;i<8;i++){
+                            int p = (pixels[s][i] % 4) * 4 + pixels[s][i] / 4;  // indices are stored column by column
+                            bestLo |= (uint32_t)(indices[s][i] >> 1) << (16 + p);
+                            bestLo |= (uint32_t)(indices[s][i] & 1) << p;
+                        }
+                    }
+                }
+            }
+            for (int i=0;i<4;i++){
+                out[i] = (uint8_t)(bestHi >> (24 - 8*i));
+                out[4+i] = (uint8_t)(bestLo >> (24 - 8*i));
+            }
+        }
+
+        // EAC alpha block of ETC2 RGBA
+        void encodeEAC(const Pixels& px, uint8_t* out){
+            int minValue = 255, maxValue = 0;
+            for (int i=0;i<16;i++){
+                minValue = std::min(minValue, (int)px[i][3]);
+                maxValue = std::max(maxValue, (int)px[i][3]);
+            }
+            int bestError = 0x7fffffff;
+            uint64_t bestBlock = 0;
+            for (int t=0;t<16 && bestError > 0;t++){
+                const int* table = eacModifiers[t];
+                int tableMin = *std::min_element(table, table+8);
+                int tableMax = *std::max_element(table, table+8);
+                int multiplier = (maxValue - minValue + (tableMax - tableMin) / 2) / (tableMax - tableMin);
+                for (int m = std::max(1, multiplier - 1); m <= std::min(15, multiplier + 1); m++){
+                    int base = clamp255((int)((minValue + maxValue) / 2.0f - (tableMin + tableMax) * m / 2.0f + 0.5f));
+                    int error = 0;
+                    uint64_t indices = 0;
+                    for (int p=0;p<16;p++){
+                        int value = px[(p % 4) * 4 + p / 4][3];             // column by column
+                        int best = 0x7fffffff, bestIndex = 0;
+                        for (int i=0;i<8;i++){
+                            int d = value - clamp255(base + table[i] * m);
+                            if (d*d < best){
+                                best = d*d;
+                                bestIndex = i;
+                            }
+                        }
+                        error += best;
+                        indices |= (uint64_t)bestIndex << (45 - 3*p);
+                    }
+                    if (error < bestError){
+                        bestError = error;
+                        bestBlock = ((uint64_t)base << 56) | ((uint64_t)m << 52) | ((uint64_t)t << 48) | indices;
+                    }
+                }
+            }
+            for (int i=0;i<8;i++){
+                out[i] = (uint8_t)(bestBlock >> (56 - 8*i));
+            }
+        }
+
+        void encodeBlock(Texture::Compression compression, const Pixels& px, uint8_t* out){
+            switch (compression){
+                case Texture::Compression::BC1:
+                    encodeBC1(px, out);
+                    break;
+                case Texture::Compression::BC3:
+                    encodeBC4(px, 3, out);
+                    encodeBC1(px, out+8);
+                    break;
+                case Texture::Compression::BC5:
+                    encodeBC4(px, 0, out);
+                    encodeBC4(px, 1, out+8);
+                    break;
+                case Texture::Compression::ETC2_RGB:
+                    encodeETC2(px, out);
+                    break;
+                case Texture::Compression::ETC2_RGBA:
+                    encodeEAC(px, out);
+                    encodeETC2(px, out+8);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    int BlockCompression::blockSize(Texture::Compression compression) {
+        switch (compression){
+            case Texture::Compression::BC1:
+            case Texture::Compression::ETC2_RGB:
+                return 8;
+            case Texture::Compression::BC3:
+            case Texture::Compression::BC5:
+            case Texture::Compression::BC7:
+            case Texture::Compression::ETC2_RGBA:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    size_t BlockCompression::levelSize(Texture::Compression compression, int width, int height) {
+        size_t blocksX = (size_t)std::max(1, (width + 3) / 4);
+        size_t blocksY = (size_t)std::max(1, (height + 3) / 4);
+        return blocksX * blocksY * blockSize(compression);
+    }
+
+    bool BlockCompression::isTransparent(Texture::Compression compression) {
+        return compression == Texture::Compression::BC3 ||
+               compression == Texture::Compression::BC7 ||
+               compression == Texture::Compression::ETC2_RGBA;
+    }
+
+    bool BlockCompression::canDecode(Texture::Compression compression) {
+        return compression != Texture::Compression::None && compression != Texture::Compression::BC7;
+    }
+
+    std::vector<char> BlockCompression::decode(Texture::Compression compression, const char *data, int width, int height) {
+        if (!canDecode(compression)){
+            return {};
+        }
+        std::vector<char> res((size_t)width * height * 4);
+        int blocksX = (width + 3) / 4;
+        int blocksY = (height + 3) / 4;
+        int size = blockSize(compression);
+        parallelFor((size_t)blocksY, 16, [&](size_t begin, size_t end){
+            Pixels pixels;
+            for (size_t by = begin; by < end; by++){
+                for (int bx = 0; bx < blocksX; bx++){
+                    auto block = reinterpret_cast<const uint8_t*>(data) + (by * blocksX + bx) * size;
+                    decodeBlock(compression, block, pixels);
+                    int rows = std::min(4, height - (int)by * 4);
+                    int columns = std::min(4, width - bx * 4);
+                    for (int y = 0; y < rows; y++){
+                        char* dst = res.data() + (((by * 4 + y) * width) + bx * 4) * 4;
+                        memcpy(dst, pixels[y*4], (size_t)columns * 4);
+                    }
+                }
+            }
+        });
+        return res;
+    }
+
+    bool BlockCompression::canEncode(Texture::Compression compression) {
+        return compression != Texture::Compression::None && compression != Texture::Compression::BC7;
+    }
+
+    std::vector<char> BlockCompression::encode(Texture::Compression compression, const char *data, int width, int height, int bytesPerPixel) {
+        if (!canEncode(compression)){
+            return {};
+        }
+        int blocksX = std::max(1, (width + 3) / 4);
+        int blocksY = std::max(1, (height + 3) / 4);
+        int size = blockSize(compression);
+        std::vector<char> res((size_t)blocksX * blocksY * size);
+        parallelFor((size_t)blocksY, 4, [&](size_t begin, size_t end){
+            Pixels pixels;
+            for (size_t by = begin; by < end; by++){
+                for (int bx = 0; bx < blocksX; bx++){
+                    loadBlock(data, width, height, bytesPerPixel, bx, (int)by, pixels);
+                    encodeBlock(compression, pixels, reinterpret_cast<uint8_t*>(res.data()) + (by * blocksX + bx) * size);
+                }
+            }
+        });
+        return res;
+    }
+
+    bool BlockCompression::canFlipY(Texture::Compression compression, int height) {
+        bool format = compression == Texture::Compression::BC1 ||
+                      compression == Texture::Compression::BC3 ||
+                      compression == Texture::Compression::BC5;
+        // the image rows must align with the block rows (images smaller than a block are flipped inside the block)
+        return format && (height % 4 == 0 || height < 4);
+    }
+
+    bool BlockCompression::flipY(Texture::Compression compression, char *data, int width, int height) {
+        if (!canFlipY(compression, height)){
+            return false;
+        }
+        int size = blockSize(compression);
+        int blocksX = std::max(1, (width + 3) / 4);
+        int blocksY = std::max(1, (height + 3) / 4);
+        auto blocks = reinterpret_cast<uint8_t*>(data);
+        size_t rowSize = (size_t)blocksX * size;
+        int rowCount = std::min(4, height);
+        for (int i=0;i<blocksX*blocksY;i++){
+            flipBlock(compression, blocks + i * size, rowCount);
+        }
+        std::vector<uint8_t> temp(rowSize);
+        for (int by=0;by<blocksY/2;by++){
+            uint8_t* a = blocks + by * rowSize;
+            uint8_t* b = blocks + (blocksY - 1 - by) * rowSize;
+            memcpy(temp.data(), a, rowSize);
+            memcpy(a, b, rowSize);
+            memcpy(b, temp.data(), rowSize);
+        }
+        return true;
+    }
+}
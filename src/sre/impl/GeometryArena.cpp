@@ -0,0 +1,224 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/GeometryArena.hpp"
+
+#include <algorithm>
+#include "sre/impl/GL.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/Log.hpp"
+
+namespace {
+    const int initialVertexCapacity = 65536;
+    const int initialIndexCapacity = 65536*3;
+}
+
+namespace sre {
+    int GeometryArena::arenaIdCount = 0;
+
+    void GeometryArena::FreeList::reset(int capacity, int used) {
+        this->capacity = capacity;
+        this->used = used;
+        freeBlocks.clear();
+        if (capacity > used){
+            freeBlocks[used] = capacity - used;
+        }
+    }
+
+    int GeometryArena::FreeList::allocate(int size) {
+        for (auto iter = freeBlocks.begin(); iter != freeBlocks.end(); iter++){
+            if (iter->second >= size){
+                int offset = iter->first;
+                int remaining = iter->second - size;
+                freeBlocks.erase(iter);
+                if (remaining > 0){
+                    freeBlocks[offset + size] = remaining;
+                }
+                used += size;
+                return offset;
+            }
+        }
+        return -1;
+    }
+
+    void GeometryArena::FreeList::free(int offset, int size) {
+        if (size == 0){
+            return;
+        }
+        used -= size;
+        auto iter = freeBlocks.emplace(offset, size).first;
+        // merge with next block
+        auto next = std::next(iter);
+        if (next != freeBlocks.end() && iter->first + iter->second == next->first){
+            iter->second += next->second;
+            freeBlocks.erase(next);
+        }
+        // merge with previous block
+        if (iter != freeBlocks.begin()){
+            auto prev = std::prev(iter);
+            if (prev->first + prev->second == iter->first){
+                prev->second += iter->second;
+                freeBlocks.erase(iter);
+            }
+        }
+    }
+
+    GeometryArena::GeometryArena(const std::string& layoutKey, int bytesPerVertex)
+    :layoutKey(layoutKey), bytesPerVertex(bytesPerVertex), id(arenaIdCount++)
+    {
+    }
+
+    GeometryArena::~GeometryArena() {
+        if (vertexBufferId != 0){
+            glDeleteBuffers(1, &vertexBufferId);
+        }
+        if (elementBufferId != 0){
+            glDeleteBuffers(1, &elementBufferId);
+        }
+    }
+
+    bool GeometryArena::isSupported() {
+        auto& info = renderInfo();
+        return !info.graphicsAPIVersionES && (info.graphicsAPIVersionMajor > 3 || (info.graphicsAPIVersionMajor == 3 && info.graphicsAPIVersionMinor >= 2));
+    }
+
+    std::shared_ptr<GeometryArena> GeometryArena::get(const std::string &layoutKey, int bytesPerVertex) {
+        auto& arenas = Renderer::instance->geometryArenas;
+        auto res = arenas.find(layoutKey);
+        if (res != arenas.end()){
+            return res->second;
+        }
+        auto arena = std::shared_ptr<GeometryArena>(new GeometryArena(layoutKey, bytesPerVertex));
+        arenas[layoutKey] = arena;
+        return arena;
+    }
+
+    void GeometryArena::allocate(Mesh *mesh, const void* vertexData, int vertexCount, const uint16_t* indexData, int indexCount) {
+        int vertexOffset = vertices.allocate(vertexCount);
+        int indexOffset = indexCount > 0 ? indices.allocate(indexCount) : 0;
+        if (vertexOffset == -1 || indexOffset == -1){
+            if (vertexOffset != -1){
+                vertices.free(vertexOffset, vertexCount);
+            }
+            if (indexCount > 0 && indexOffset != -1){
+                indices.free(indexOffset, indexCount);
+            }
+            // grow (and defragment)
+            int vertexCapacity = std::max(initialVertexCapacity, vertices.capacity);
+            while (vertexCapacity < vertices.used + vertexCount){
+                vertexCapacity *= 2;
+            }
+            int indexCapacity = std::max(initialIndexCapacity, indices.capacity);
+            while (indexCapacity < indices.used + indexCount){
+                indexCapacity *= 2;
+            }
+            resize(vertexCapacity, indexCapacity);
+            vertexOffset = vertices.allocate(vertexCount);
+            indexOffset = indexCount > 0 ? indices.allocate(indexCount) : 0;
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBufferId);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)vertexOffset*bytesPerVertex, (GLsizeiptr)vertexCount*bytesPerVertex, vertexData);
+        if (indexCount > 0){
+            glBindBuffer(GL_COPY_WRITE_BUFFER, elementBufferId);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)indexOffset*sizeof(uint16_t), indexCount*sizeof(uint16_t), indexData);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        mesh->arenaVertexOffset = vertexOffset;
+        mesh->arenaIndexOffset = indexOffset;
+        mesh->arenaIndexCount = indexCount;
+        meshes.push_back(mesh);
+    }
+
+    void GeometryArena::free(Mesh *mesh) {
+        vertices.free(mesh->arenaVertexOffset, mesh->vertexCount);
+        if (mesh->arenaIndexCount > 0){
+            indices.free(mesh->arenaIndexOffset, mesh->arenaIndexCount);
+        }
+        meshes.erase(std::remove(meshes.begin(), meshes.end(), mesh), meshes.end());
+    }
+
+    void GeometryArena::defragment() {
+        resize(vertices.capacity, indices.capacity);
+    }
+
+    void GeometryArena::resize(int vertexCapacity, int indexCapacity) {
+        GLuint newBuffers[2];
+        glGenBuffers(2, newBuffers);
+        glBindVertexArray(0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[0]);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexCapacity*bytesPerVertex, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[1]);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)indexCapacity*sizeof(uint16_t), nullptr, GL_STATIC_DRAW);
+
+        // copy meshes packed in allocation order
+        int vertexOffset = 0;
+        int indexOffset = 0;
+        for (auto mesh : meshes){
+            glBindBuffer(GL_COPY_READ_BUFFER, vertexBufferId);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[0]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)mesh->arenaVertexOffset*bytesPerVertex, (GLintptr)vertexOffset*bytesPerVertex, (GLsizeiptr)mesh->vertexCount*bytesPerVertex);
+            mesh->arenaVertexOffset = vertexOffset;
+            vertexOffset += mesh->vertexCount;
+            if (mesh->arenaIndexCount > 0){
+                glBindBuffer(GL_COPY_READ_BUFFER, elementBufferId);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffers[1]);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)mesh->arenaIndexOffset*sizeof(uint16_t), (GLintptr)indexOffset*sizeof(uint16_t), (GLsizeiptr)mesh->arenaIndexCount*sizeof(uint16_t));
+                mesh->arenaIndexOffset = indexOffset;
+                indexOffset += mesh->arenaIndexCount;
+            }
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (vertexBufferId != 0){
+            glDeleteBuffers(1, &vertexBufferId);
+            glDeleteBuffers(1, &elementBufferId);
+        }
+        vertexBufferId = newBuffers[0];
+        elementBufferId = newBuffers[1];
+        vertices.reset(vertexCapacity, vertexOffset);
+        indices.reset(indexCapacity, indexOffset);
+
+        LOG_INFO("Geometry arena %i resized to %i vertices and %i indices", id, vertexCapacity, indexCapacity);
+    }
+
+    const std::string &GeometryArena::getLayoutKey() {
+        return layoutKey;
+    }
+
+    int GeometryArena::getBytesPerVertex() {
+        return bytesPerVertex;
+    }
+
+    int GeometryArena::getVertexCapacity() {
+        return vertices.capacity;
+    }
+
+    int GeometryArena::getVerticesUsed() {
+        return vertices.used;
+    }
+
+    int GeometryArena::getIndexCapacity() {
+        return indices.capacity;
+    }
+
+    int GeometryArena::getIndicesUsed() {
+        return indices.used;
+    }
+
+    int GeometryArena::getMeshCount() {
+        return (int)meshes.size();
+    }
+
+    int GeometryArena::getDataSize() {
+        return vertices.capacity*bytesPerVertex + indices.capacity*(int)sizeof(uint16_t);
+    }
+}
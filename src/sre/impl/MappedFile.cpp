@@ -0,0 +1,144 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/MappedFile.hpp"
+
+#include <algorithm>
+
+#if defined(EMSCRIPTEN)
+#include <fstream>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sre {
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string &filename) {
+        close();
+#if defined(EMSCRIPTEN)
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file){
+            return false;
+        }
+        std::streamsize fileSize = file.tellg();
+        file.seekg(0, std::ios::beg);
+        buffer.resize((size_t)fileSize);
+        if (fileSize > 0 && !file.read(buffer.data(), fileSize)){
+            buffer.clear();
+            return false;
+        }
+        ptr = buffer.data();
+        length = buffer.size();
+        return true;
+#elif defined(_WIN32)
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE){
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)){
+            CloseHandle(file);
+            return false;
+        }
+        fileHandle = file;
+        length = (size_t)fileSize.QuadPart;
+        if (length == 0){
+            ptr = buffer.data();
+            return true;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr){
+            close();
+            return false;
+        }
+        mappingHandle = mapping;
+        ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (ptr == nullptr){
+            close();
+            return false;
+        }
+        return true;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1){
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1){
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)st.st_size;
+        if (length == 0){
+            ::close(fd);
+            ptr = buffer.data();
+            return true;
+        }
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);                                                // the mapping keeps the file open
+        if (mapped == MAP_FAILED){
+            length = 0;
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        ptr = (const char*)mapped;
+        return true;
+#endif
+    }
+
+    void MappedFile::close() {
+#if defined(EMSCRIPTEN)
+        buffer.clear();
+#elif defined(_WIN32)
+        if (ptr != nullptr && length > 0){
+            UnmapViewOfFile(ptr);
+        }
+        if (mappingHandle != nullptr){
+            CloseHandle((HANDLE)mappingHandle);
+            mappingHandle = nullptr;
+        }
+        if (fileHandle != nullptr){
+            CloseHandle((HANDLE)fileHandle);
+            fileHandle = nullptr;
+        }
+#else
+        if (ptr != nullptr && length > 0){
+            munmap((void*)ptr, length);
+        }
+#endif
+        ptr = nullptr;
+        length = 0;
+    }
+
+    void MappedFile::discard(size_t offset, size_t size) {
+#if !defined(EMSCRIPTEN) && !defined(_WIN32)
+        // only whole pages inside the range can be released
+        size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+        size_t end = std::min(offset + size, length) / pageSize * pageSize;
+        if (ptr != nullptr && begin < end){
+            madvise((void*)(ptr + begin), end - begin, MADV_DONTNEED);
+        }
+#endif
+    }
+
+    const char *MappedFile::data() const {
+        return ptr;
+    }
+
+    size_t MappedFile::size() const {
+        return length;
+    }
+}
@@ -0,0 +1,231 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/MipmapGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "sre/impl/ParallelFor.hpp"
+#include "sre/impl/Simd.hpp"
+
+namespace sre {
+    namespace {
+#ifdef SRE_SSE2
+        typedef __m128 Vec4;
+        inline Vec4 load(const float* p){ return _mm_loadu_ps(p); }
+        inline void store(float* p, Vec4 v){ _mm_storeu_ps(p, v); }
+        inline Vec4 zero(){ return _mm_setzero_ps(); }
+        inline Vec4 add(Vec4 a, Vec4 b){ return _mm_add_ps(a, b); }
+        inline Vec4 mul(Vec4 a, float s){ return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+        struct Vec4 { float v[4]; };
+        inline Vec4 load(const float* p){ return {{p[0], p[1], p[2], p[3]}}; }
+        inline void store(float* p, Vec4 a){ for (int i=0;i<4;i++) p[i] = a.v[i]; }
+        inline Vec4 zero(){ return {{0, 0, 0, 0}}; }
+        inline Vec4 add(Vec4 a, Vec4 b){ for (int i=0;i<4;i++) a.v[i] += b.v[i]; return a; }
+        inline Vec4 mul(Vec4 a, float s){ for (int i=0;i<4;i++) a.v[i] *= s; return a; }
+#endif
+
+        const size_t minRowsPerTask = 16;
+        const int rowsPerBand = 16;                         // destination rows filtered at a time (bounds the temporary rows)
+
+        float srgbToLinear(float v){
+            return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float v){
+            return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1 / 2.4f) - 0.055f;
+        }
+
+        const float* srgbToLinearTable(){
+            static std::vector<float> table = [](){
+                std::vector<float> res(256);
+                for (int i=0;i<256;i++){
+                    res[i] = srgbToLinear(i / 255.0f);
+                }
+                return res;
+            }();
+            return table.data();
+        }
+
+        const float* unormToFloatTable(){
+            static std::vector<float> table = [](){
+                std::vector<float> res(256);
+                for (int i=0;i<256;i++){
+                    res[i] = i / 255.0f;
+                }
+                return res;
+            }();
+            return table.data();
+        }
+
+        // linear value (16 bit precision) to sRGB byte
+        const uint8_t* linearToSrgbTable(){
+            static std::vector<uint8_t> table = [](){
+                std::vector<uint8_t> res(65536);
+                for (int i=0;i<65536;i++){
+                    res[i] = (uint8_t)(linearToSrgb(i / 65535.0f) * 255 + 0.5f);
+                }
+                return res;
+            }();
+            return table.data();
+        }
+
+        // converts 8 bit RGB or RGBA pixels to linear RGBA and back (alpha is always linear)
+        struct PixelFormat {
+            int bytesPerPixel;
+            bool srgb;
+            const float* toLinear;
+            const float* toFloat;
+            const uint8_t* toSrgb;
+
+            PixelFormat(int bytesPerPixel, bool srgb)
+                    :bytesPerPixel(bytesPerPixel), srgb(srgb), toLinear(srgb ? srgbToLinearTable() : unormToFloatTable()),
+                     toFloat(unormToFloatTable()), toSrgb(linearToSrgbTable()) {
+            }
+
+            Vec4 decode(const uint8_t* p) const {
+                float v[4] = {toLinear[p[0]], toLinear[p[1]], toLinear[p[2]], bytesPerPixel == 4 ? toFloat[p[3]] : 1.0f};
+                return load(v);
+            }
+
+            void encode(uint8_t* p, Vec4 value) const {
+                float v[4];
+                store(v, value);
+                for (int c=0;c<bytesPerPixel;c++){
+                    float f = std::min(1.0f, std::max(0.0f, v[c]));
+                    p[c] = (srgb && c < 3) ? toSrgb[(int)(f * 65535 + 0.5f)] : (uint8_t)(f * 255 + 0.5f);
+                }
+            }
+        };
+
+        std::vector<char> downsampleBox(const uint8_t* src, int srcWidth, int srcHeight, const PixelFormat& format){
+            int dstWidth = std::max(1, srcWidth / 2);
+            int dstHeight = std::max(1, srcHeight / 2);
+            int bpp = format.bytesPerPixel;
+            std::vector<char> res((size_t)dstWidth * dstHeight * bpp);
+            auto dst = reinterpret_cast<uint8_t*>(res.data());
+            parallelFor((size_t)dstHeight, minRowsPerTask, [&](size_t begin, size_t end){
+                for (size_t y = begin; y < end; y++){
+                    const uint8_t* row0 = src + (size_t)std::min((int)y * 2, srcHeight - 1) * srcWidth * bpp;
+                    const uint8_t* row1 = src + (size_t)std::min((int)y * 2 + 1, srcHeight - 1) * srcWidth * bpp;
+                    for (int x=0;x<dstWidth;x++){
+                        int x0 = std::min(x * 2, srcWidth - 1) * bpp;
+                        int x1 = std::min(x * 2 + 1, srcWidth - 1) * bpp;
+                        Vec4 sum = add(add(format.decode(row0 + x0), format.decode(row0 + x1)),
+                                       add(format.decode(row1 + x0), format.decode(row1 + x1)));
+                        format.encode(dst + ((size_t)y * dstWidth + x) * bpp, mul(sum, 0.25f));
+                    }
+                }
+            });
+            return res;
+        }
+
+        // Kaiser windowed sinc. Eight taps centered between the two source pixels of each destination pixel
+        const int kaiserTaps = 8;
+
+        double besselI0(double x){
+            double sum = 1, term = 1;
+            for (int k=1;k<32;k++){
+                term *= (x / (2 * k)) * (x / (2 * k));
+                sum += term;
+            }
+            return sum;
+        }
+
+        const float* kaiserWeights(){
+            static std::vector<float> weights = [](){
+                const double alpha = 4;
+                const double radius = kaiserTaps / 2;
+                const double pi = 3.14159265358979323846;
+                std::vector<float> res(kaiserTaps);
+                double sum = 0;
+                for (int i=0;i<kaiserTaps;i++){
+                    double d = (i - kaiserTaps/2 + 1) - 0.5;                    // distance in source pixels
+                    double x = d / 2;                                           // scaled to destination pixels
+                    double sinc = x == 0 ? 1 : std::sin(pi * x) / (pi * x);
+                    double t = d / radius;
+                    double window = besselI0(alpha * std::sqrt(std::max(0.0, 1 - t*t))) / besselI0(alpha);
+                    res[i] = (float)(sinc * window);
+                    sum += res[i];
+                }
+                for (auto& w : res){
+                    w = (float)(w / sum);
+                }
+                return res;
+            }();
+            return weights.data();
+        }
+
+        // separable filter. The horizontal pass is computed for the source rows of a band of destination rows at a time
+        std::vector<char> downsampleKaiser(const uint8_t* src, int srcWidth, int srcHeight, const PixelFormat& format){
+            const float* weights = kaiserWeights();
+            int dstWidth = std::max(1, srcWidth / 2);
+            int dstHeight = std::max(1, srcHeight / 2);
+            int bpp = format.bytesPerPixel;
+            std::vector<char> res((size_t)dstWidth * dstHeight * bpp);
+            auto dst = reinterpret_cast<uint8_t*>(res.data());
+            parallelFor((size_t)dstHeight, minRowsPerTask, [&](size_t begin, size_t end){
+                std::vector<float> rows;                    // horizontally filtered source rows (RGBA float)
+                for (int bandBegin = (int)begin; bandBegin < (int)end; bandBegin += rowsPerBand){
+                    int bandEnd = std::min((int)end, bandBegin + rowsPerBand);
+                    int firstRow = srcHeight == 1 ? 0 : bandBegin * 2 - kaiserTaps/2 + 1;
+                    int lastRow = srcHeight == 1 ? 0 : (bandEnd - 1) * 2 + kaiserTaps/2;
+                    rows.resize((size_t)(lastRow - firstRow + 1) * dstWidth * 4);
+                    // horizontal pass
+                    for (int r = firstRow; r <= lastRow; r++){
+                        const uint8_t* srcRow = src + (size_t)std::min(std::max(r, 0), srcHeight - 1) * srcWidth * bpp;
+                        float* row = rows.data() + (size_t)(r - firstRow) * dstWidth * 4;
+                        for (int x=0;x<dstWidth;x++){
+                            Vec4 sum = zero();
+                            if (srcWidth == 1){
+                                sum = format.decode(srcRow);
+                            } else {
+                                for (int i=0;i<kaiserTaps;i++){
+                                    int sx = std::min(std::max(x * 2 + i - kaiserTaps/2 + 1, 0), srcWidth - 1);
+                                    sum = add(sum, mul(format.decode(srcRow + sx * bpp), weights[i]));
+                                }
+                            }
+                            store(row + x * 4, sum);
+                        }
+                    }
+                    // vertical pass
+                    for (int y = bandBegin; y < bandEnd; y++){
+                        for (int x=0;x<dstWidth;x++){
+                            Vec4 sum = zero();
+                            if (srcHeight == 1){
+                                sum = load(rows.data() + x * 4);
+                            } else {
+                                for (int i=0;i<kaiserTaps;i++){
+                                    int r = y * 2 + i - kaiserTaps/2 + 1;
+                                    sum = add(sum, mul(load(rows.data() + ((size_t)(r - firstRow) * dstWidth + x) * 4), weights[i]));
+                                }
+                            }
+                            format.encode(dst + ((size_t)y * dstWidth + x) * bpp, sum);
+                        }
+                    }
+                }
+            });
+            return res;
+        }
+    }
+
+    std::vector<std::vector<char>> MipmapGenerator::generate(const char *data, int width, int height, int bytesPerPixel, bool srgb, Texture::MipmapFilter filter) {
+        std::vector<std::vector<char>> levels;
+        PixelFormat format(bytesPerPixel, srgb);
+        auto src = reinterpret_cast<const uint8_t*>(data);
+        while (width > 1 || height > 1){
+            levels.push_back(filter == Texture::MipmapFilter::Kaiser ? downsampleKaiser(src, width, height, format)
+                                                                     : downsampleBox(src, width, height, format));
+            src = reinterpret_cast<const uint8_t*>(levels.back().data());
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return levels;
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/ParallelFor.hpp"
+
+#include <algorithm>
+#include <vector>
+#ifndef EMSCRIPTEN
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#endif
+
+namespace sre {
+#ifndef EMSCRIPTEN
+    namespace {
+        thread_local bool isPoolWorker = false;
+
+        // blocks of a single parallelFor call. Blocks are claimed using an atomic counter by the calling thread and
+        // the workers, so the call completes even if all workers are busy
+        struct Batch {
+            const std::function<void(size_t, size_t)>* fn;
+            size_t count;
+            size_t blockSize;
+            size_t blocks;
+            std::atomic<size_t> nextBlock{0};
+            std::atomic<size_t> finishedBlocks{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            // process blocks until none are left
+            void run(){
+                size_t processed = 0;
+                for (size_t b = nextBlock++; b < blocks; b = nextBlock++){
+                    size_t begin = b * blockSize;
+                    (*fn)(begin, std::min(count, begin + blockSize));
+                    processed++;
+                }
+                if (processed > 0 && (finishedBlocks += processed) == blocks){
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        };
+
+        // worker threads created on first use and reused by all parallelFor calls
+        class ThreadPool {
+        public:
+            explicit ThreadPool(int threadCount){
+                for (int i=0;i<threadCount;i++){
+                    workers.emplace_back([this](){
+                        isPoolWorker = true;
+                        workerLoop();
+                    });
+                }
+            }
+
+            ~ThreadPool(){
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopWorkers = true;
+                }
+                condition.notify_all();
+                for (auto& worker : workers){
+                    worker.join();
+                }
+            }
+
+            void submit(const std::shared_ptr<Batch>& batch, size_t helpers){
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (size_t i=0;i<helpers;i++){
+                        queue.push_back(batch);
+                    }
+                }
+                condition.notify_all();
+            }
+        private:
+            void workerLoop(){
+                while (true){
+                    std::shared_ptr<Batch> batch;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [&](){ return stopWorkers || !queue.empty(); });
+                        if (stopWorkers){
+                            return;
+                        }
+                        batch = queue.front();
+                        queue.pop_front();
+                    }
+                    batch->run();                           // no-op if the blocks were already claimed
+                }
+            }
+
+            std::vector<std::thread> workers;
+            std::deque<std::shared_ptr<Batch>> queue;
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool stopWorkers = false;
+        };
+
+        ThreadPool& threadPool(){
+            static ThreadPool pool(parallelForThreadCount() - 1); // the calling thread is also used
+            return pool;
+        }
+    }
+#endif
+
+    int parallelForThreadCount(){
+#ifdef EMSCRIPTEN
+        return 1;
+#else
+        static int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+        return threadCount;
+#endif
+    }
+
+    void parallelFor(size_t count, size_t minBlockSize, const std::function<void(size_t begin, size_t end)>& fn){
+        minBlockSize = std::max(minBlockSize, (size_t)1);
+        size_t blocks = std::min(count / minBlockSize, (size_t)parallelForThreadCount());
+#ifndef EMSCRIPTEN
+        if (isPoolWorker){
+            blocks = 1;                                     // nested call: waiting for the pool could deadlock
+        }
+#endif
+        if (blocks < 2){
+            if (count > 0){
+                fn(0, count);
+            }
+            return;
+        }
+#ifndef EMSCRIPTEN
+        auto batch = std::make_shared<Batch>();
+        batch->fn = &fn;
+        batch->count = count;
+        batch->blockSize = (count + blocks - 1) / blocks;
+        batch->blocks = (count + batch->blockSize - 1) / batch->blockSize;
+        threadPool().submit(batch, batch->blocks - 1);
+        batch->run();                                       // the calling thread processes blocks too
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&](){ return batch->finishedBlocks == batch->blocks; });
+#endif
+    }
+}
@@ -0,0 +1,360 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/TextureContainer.hpp"
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "sre/impl/BlockCompression.hpp"
+#include "sre/Log.hpp"
+
+namespace sre {
+    namespace {
+        const uint8_t ktxIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+        const uint8_t ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        const uint32_t ddsMagic = 0x20534444;                           // "DDS "
+
+        uint32_t readU32(const char* data, size_t offset, bool swap = false){
+            auto p = reinterpret_cast<const uint8_t*>(data) + offset;
+            if (swap){
+                return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+            }
+            return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+
+        uint64_t readU64(const char* data, size_t offset){
+            return readU32(data, offset) | ((uint64_t)readU32(data, offset + 4) << 32);
+        }
+
+        uint32_t fourCC(const char* s){
+            return s[0] | (s[1] << 8) | (s[2] << 16) | ((uint32_t)s[3] << 24);
+        }
+
+        Texture::Compression fromGLInternalFormat(uint32_t format){
+            switch (format){
+                case 0x83F0: // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                case 0x83F1: // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+                case 0x8C4C: // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                case 0x8C4D: // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+                    return Texture::Compression::BC1;
+                case 0x83F3: // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+                case 0x8C4F: // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                    return Texture::Compression::BC3;
+                case 0x8DBD: // GL_COMPRESSED_RG_RGTC2
+                    return Texture::Compression::BC5;
+                case 0x8E8C: // GL_COMPRESSED_RGBA_BPTC_UNORM
+                case 0x8E8D: // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+                    return Texture::Compression::BC7;
+                case 0x8D64: // GL_ETC1_RGB8_OES (ETC2 is backwards compatible)
+                case 0x9274: // GL_COMPRESSED_RGB8_ETC2
+                case 0x9275: // GL_COMPRESSED_SRGB8_ETC2
+                    return Texture::Compression::ETC2_RGB;
+                case 0x9278: // GL_COMPRESSED_RGBA8_ETC2_EAC
+                case 0x9279: // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+                    return Texture::Compression::ETC2_RGBA;
+                default:
+                    return Texture::Compression::None;
+            }
+        }
+
+        Texture::Compression fromVkFormat(uint32_t format){
+            switch (format){
+                case 131: // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+                case 132: // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+                case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+                case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+                    return Texture::Compression::BC1;
+                case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+                case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+                    return Texture::Compression::BC3;
+                case 141: // VK_FORMAT_BC5_UNORM_BLOCK
+                    return Texture::Compression::BC5;
+                case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+                case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+                    return Texture::Compression::BC7;
+                case 147: // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+                case 148: // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+                    return Texture::Compression::ETC2_RGB;
+                case 151: // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+                case 152: // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+                    return Texture::Compression::ETC2_RGBA;
+                default:
+                    return Texture::Compression::None;
+            }
+        }
+
+        Texture::Compression fromDXGIFormat(uint32_t format){
+            switch (format){
+                case 70: // DXGI_FORMAT_BC1_TYPELESS
+                case 71: // DXGI_FORMAT_BC1_UNORM
+                case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+                    return Texture::Compression::BC1;
+                case 76: // DXGI_FORMAT_BC3_TYPELESS
+                case 77: // DXGI_FORMAT_BC3_UNORM
+                case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+                    return Texture::Compression::BC3;
+                case 82: // DXGI_FORMAT_BC5_TYPELESS
+                case 83: // DXGI_FORMAT_BC5_UNORM
+                    return Texture::Compression::BC5;
+                case 97: // DXGI_FORMAT_BC7_TYPELESS
+                case 98: // DXGI_FORMAT_BC7_UNORM
+                case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+                    return Texture::Compression::BC7;
+                default:
+                    return Texture::Compression::None;
+            }
+        }
+
+        // GL internal format and base internal format written to KTX files
+        void toGLInternalFormat(Texture::Compression compression, uint32_t& internalFormat, uint32_t& baseInternalFormat){
+            switch (compression){
+                case Texture::Compression::BC1:
+                    internalFormat = 0x83F0; baseInternalFormat = 0x1907;       // GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB
+                    break;
+                case Texture::Compression::BC3:
+                    internalFormat = 0x83F3; baseInternalFormat = 0x1908;       // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA
+                    break;
+                case Texture::Compression::BC5:
+                    internalFormat = 0x8DBD; baseInternalFormat = 0x8227;       // GL_COMPRESSED_RG_RGTC2, GL_RG
+                    break;
+                case Texture::Compression::BC7:
+                    internalFormat = 0x8E8C; baseInternalFormat = 0x1908;       // GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA
+                    break;
+                case Texture::Compression::ETC2_RGB:
+                    internalFormat = 0x9274; baseInternalFormat = 0x1907;       // GL_COMPRESSED_RGB8_ETC2, GL_RGB
+                    break;
+                case Texture::Compression::ETC2_RGBA:
+                    internalFormat = 0x9278; baseInternalFormat = 0x1908;       // GL_COMPRESSED_RGBA8_ETC2_EAC, GL_RGBA
+                    break;
+                default:
+                    internalFormat = 0; baseInternalFormat = 0;
+                    break;
+            }
+        }
+
+        void writeU32(std::vector<char>& data, uint32_t value){
+            for (int i=0;i<4;i++){
+                data.push_back((char)(value >> (8*i)));
+            }
+        }
+
+        // Find the value of key in KTX key/value data. Each entry is a 32 bit size followed by key\0value and padding
+        std::string findKeyValue(const char* data, size_t offset, size_t length, const char* key, bool swap){
+            size_t end = offset + length;
+            size_t keyLength = strlen(key);
+            while (offset + 4 <= end){
+                size_t entrySize = readU32(data, offset, swap);
+                offset += 4;
+                if (entrySize > end - offset){
+                    break;
+                }
+                if (entrySize > keyLength && memcmp(data + offset, key, keyLength + 1) == 0){
+                    std::string value(data + offset + keyLength + 1, entrySize - keyLength - 1);
+                    return value.substr(0, value.find('\0'));
+                }
+                offset += (entrySize + 3) & ~(size_t)3;
+            }
+            return "";
+        }
+    }
+
+    bool TextureContainer::isContainer(const char *data, size_t size) {
+        return size >= 12 && (memcmp(data, ktxIdentifier, 12) == 0 || memcmp(data, ktx2Identifier, 12) == 0 ||
+                              readU32(data, 0) == ddsMagic);
+    }
+
+    bool TextureContainer::load(const char *data, size_t size, const std::string& name) {
+        levels.clear();
+        compression = Texture::Compression::None;
+        int levelCount;
+        std::vector<std::pair<size_t, size_t>> levelRanges;                 // offset and size of each level
+        // checked before the level offsets are read, since the level sizes are computed by shifting the size
+        auto validSize = [&](){
+            if (width <= 0 || height <= 0){
+                LOG_ERROR("Cannot load texture %s. Invalid size %i x %i", name.c_str(), width, height);
+                return false;
+            }
+            int maxLevelCount = 1;
+            while ((std::max(width, height) >> maxLevelCount) > 0){
+                maxLevelCount++;
+            }
+            if (levelCount > maxLevelCount){
+                LOG_ERROR("Cannot load texture %s. %i mip levels (max %i for %i x %i)", name.c_str(), levelCount, maxLevelCount, width, height);
+                return false;
+            }
+            return true;
+        };
+        if (size >= 64 && memcmp(data, ktxIdentifier, 12) == 0){
+            bool swap = readU32(data, 12) != 0x04030201;
+            uint32_t glType = readU32(data, 16, swap);
+            uint32_t glInternalFormat = readU32(data, 28, swap);
+            width = (int)readU32(data, 36, swap);
+            height = (int)readU32(data, 40, swap);
+            uint32_t depth = readU32(data, 44, swap);
+            uint32_t arrayElements = readU32(data, 48, swap);
+            uint32_t faces = readU32(data, 52, swap);
+            levelCount = std::max(1, (int)readU32(data, 56, swap));
+            uint32_t keyValueBytes = readU32(data, 60, swap);
+            if (!validSize()){
+                return false;
+            }
+            if (glType != 0 || (compression = fromGLInternalFormat(glInternalFormat)) == Texture::Compression::None){
+                LOG_ERROR("Cannot load texture %s. Unsupported KTX format 0x%x", name.c_str(), glInternalFormat);
+                return false;
+            }
+            if (depth > 1 || arrayElements > 0 || faces != 1){
+                LOG_ERROR("Cannot load texture %s. Only 2D KTX textures are supported", name.c_str());
+                return false;
+            }
+            if (64 + (size_t)keyValueBytes > size){
+                LOG_ERROR("Cannot load texture %s. Invalid KTX file", name.c_str());
+                return false;
+            }
+            // data is stored bottom-up (OpenGL convention) unless the orientation says otherwise
+            topDown = findKeyValue(data, 64, keyValueBytes, "KTXorientation", swap).find("T=d") != std::string::npos;
+            size_t offset = 64 + keyValueBytes;
+            for (int i=0;i<levelCount && offset + 4 <= size;i++){
+                size_t imageSize = readU32(data, offset, swap);
+                offset += 4;
+                levelRanges.emplace_back(offset, imageSize);
+                offset += (imageSize + 3) & ~(size_t)3;
+            }
+        } else if (size >= 80 && memcmp(data, ktx2Identifier, 12) == 0){
+            uint32_t vkFormat = readU32(data, 12);
+            width = (int)readU32(data, 20);
+            height = (int)readU32(data, 24);
+            uint32_t depth = readU32(data, 28);
+            uint32_t layers = readU32(data, 32);
+            uint32_t faces = readU32(data, 36);
+            levelCount = std::max(1, (int)readU32(data, 40));
+            uint32_t supercompression = readU32(data, 44);
+            uint32_t keyValueOffset = readU32(data, 56);
+            uint32_t keyValueBytes = readU32(data, 60);
+            if (!validSize()){
+                return false;
+            }
+            if ((compression = fromVkFormat(vkFormat)) == Texture::Compression::None){
+                LOG_ERROR("Cannot load texture %s. Unsupported KTX2 format %u", name.c_str(), vkFormat);
+                return false;
+            }
+            if (supercompression != 0){
+                LOG_ERROR("Cannot load texture %s. Supercompressed KTX2 files are not supported", name.c_str());
+                return false;
+            }
+            if (depth > 1 || layers > 0 || faces != 1){
+                LOG_ERROR("Cannot load texture %s. Only 2D KTX2 textures are supported", name.c_str());
+                return false;
+            }
+            if (80 + (size_t)levelCount * 24 > size || (size_t)keyValueOffset + keyValueBytes > size){
+                LOG_ERROR("Cannot load texture %s. Invalid KTX2 file", name.c_str());
+                return false;
+            }
+            // default orientation is "rd" (top-down)
+            auto orientation = findKeyValue(data, keyValueOffset, keyValueBytes, "KTXorientation", false);
+            topDown = orientation.size() < 2 || orientation[1] != 'u';
+            for (int i=0;i<levelCount;i++){
+                levelRanges.emplace_back((size_t)readU64(data, 80 + i * 24), (size_t)readU64(data, 80 + i * 24 + 8));
+            }
+        } else if (size >= 128 && readU32(data, 0) == ddsMagic){
+            height = (int)readU32(data, 12);
+            width = (int)readU32(data, 16);
+            uint32_t flags = readU32(data, 8);
+            levelCount = (flags & 0x20000) ? std::max(1, (int)readU32(data, 28)) : 1; // DDSD_MIPMAPCOUNT
+            if (!validSize()){
+                return false;
+            }
+            uint32_t format = readU32(data, 84);
+            uint32_t caps2 = readU32(data, 112);
+            size_t offset = 128;
+            if (format == fourCC("DX10")){
+                if (size < 148){
+                    LOG_ERROR("Cannot load texture %s. Invalid DDS file", name.c_str());
+                    return false;
+                }
+                uint32_t dxgiFormat = readU32(data, 128);
+                uint32_t miscFlag = readU32(data, 136);
+                uint32_t arraySize = readU32(data, 140);
+                compression = fromDXGIFormat(dxgiFormat);
+                if (compression == Texture::Compression::None){
+                    LOG_ERROR("Cannot load texture %s. Unsupported DDS format %u", name.c_str(), dxgiFormat);
+                    return false;
+                }
+                if (arraySize > 1 || (miscFlag & 0x4)){                    // D3D11_RESOURCE_MISC_TEXTURECUBE
+                    LOG_ERROR("Cannot load texture %s. Only 2D DDS textures are supported", name.c_str());
+                    return false;
+                }
+                offset = 148;
+            } else if (format == fourCC("DXT1")){
+                compression = Texture::Compression::BC1;
+            } else if (format == fourCC("DXT5")){
+                compression = Texture::Compression::BC3;
+            } else if (format == fourCC("ATI2") || format == fourCC("BC5U")){
+                compression = Texture::Compression::BC5;
+            } else {
+                LOG_ERROR("Cannot load texture %s. Unsupported DDS format %.4s", name.c_str(), data + 84);
+                return false;
+            }
+            if (caps2 & 0x200){                                             // DDSCAPS2_CUBEMAP
+                LOG_ERROR("Cannot load texture %s. Only 2D DDS textures are supported", name.c_str());
+                return false;
+            }
+            topDown = true;
+            for (int i=0;i<levelCount;i++){
+                size_t levelSize = BlockCompression::levelSize(compression, std::max(1, width >> i), std::max(1, height >> i));
+                levelRanges.emplace_back(offset, levelSize);
+                offset += levelSize;
+            }
+        } else {
+            LOG_ERROR("Cannot load texture %s. Unknown texture container", name.c_str());
+            return false;
+        }
+
+        if ((int)levelRanges.size() < levelCount){
+            LOG_ERROR("Cannot load texture %s. Invalid mip levels", name.c_str());
+            return false;
+        }
+        for (int i=0;i<(int)levelRanges.size();i++){
+            size_t expectedSize = BlockCompression::levelSize(compression, std::max(1, width >> i), std::max(1, height >> i));
+            size_t offset = levelRanges[i].first;
+            if (levelRanges[i].second < expectedSize || offset > size || expectedSize > size - offset){
+                LOG_ERROR("Cannot load texture %s. Mip level %i is truncated", name.c_str(), i);
+                return false;
+            }
+            levels.emplace_back(data + offset, data + offset + expectedSize);
+        }
+        if (levels.empty()){
+            LOG_ERROR("Cannot load texture %s. No image data", name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<char> TextureContainer::saveKTX() const {
+        uint32_t internalFormat, baseInternalFormat;
+        toGLInternalFormat(compression, internalFormat, baseInternalFormat);
+        std::vector<char> res(ktxIdentifier, ktxIdentifier + 12);
+        uint32_t header[13] = {
+                0x04030201,                                             // endianness
+                0, 1, 0,                                                // glType, glTypeSize, glFormat (compressed)
+                internalFormat, baseInternalFormat,
+                (uint32_t)width, (uint32_t)height, 0,                   // depth
+                0, 1,                                                   // array elements, faces
+                (uint32_t)levels.size(),
+                0                                                       // key/value bytes
+        };
+        for (auto value : header){
+            writeU32(res, value);
+        }
+        for (auto& level : levels){
+            writeU32(res, (uint32_t)level.size());
+            res.insert(res.end(), level.begin(), level.end());
+            res.resize((res.size() + 3) & ~(size_t)3);                  // mip padding
+        }
+        return res;
+    }
+}
@@ -14,6 +14,10 @@ namespace sre {
         for (const auto & t : textureValues) {
 
             glActiveTexture(GL_TEXTURE0 + textureSlot);
+            t.second->markUsed();                           // records the last used frame (and reloads unloaded textures)
+            if (t.second->mipmapsDirty){
+                t.second->updateMipmaps();
+            }
             glBindTexture(t.second->target, t.second->textureId);
             glUniform1i(t.first, textureSlot);
             textureSlot++;
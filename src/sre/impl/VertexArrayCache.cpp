@@ -0,0 +1,122 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/VertexArrayCache.hpp"
+
+#include "sre/impl/GL.hpp"
+#include "sre/impl/GeometryArena.hpp"
+#include "sre/Mesh.hpp"
+#include "sre/Shader.hpp"
+#include "sre/Renderer.hpp"
+
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
+namespace sre {
+    VertexArrayCache::~VertexArrayCache() {
+        clear();
+    }
+
+    bool VertexArrayCache::isVertexAttribBindingSupported() {
+#ifdef EMSCRIPTEN
+        return false;
+#else
+        auto& info = renderInfo();
+        return !info.graphicsAPIVersionES && (info.graphicsAPIVersionMajor > 4 || (info.graphicsAPIVersionMajor == 4 && info.graphicsAPIVersionMinor >= 3));
+#endif
+    }
+
+    int VertexArrayCache::getLayoutId(const std::string &layoutKey) {
+        auto res = layoutIds.find(layoutKey);
+        if (res != layoutIds.end()){
+            return res->second;
+        }
+        int id = (int)layoutIds.size();
+        layoutIds[layoutKey] = id;
+        return id;
+    }
+
+    void VertexArrayCache::bind(Mesh *mesh, Shader *shader) {
+        if (vertexAttribBinding == -1){
+            vertexAttribBinding = isVertexAttribBindingSupported() ? 1 : 0;
+        }
+        unsigned int vertexBuffer = mesh->geometryArena ? mesh->geometryArena->vertexBufferId : mesh->vertexBufferId;
+        unsigned int elementBuffer = mesh->geometryArena ? mesh->geometryArena->elementBufferId : mesh->elementBufferId;
+
+        auto key = std::make_pair(mesh->layoutId, shader->shaderUniqueId);
+        auto res = vertexArrays.find(key);
+        if (res == vertexArrays.end()){
+            auto& vertexArray = vertexArrays[key];
+            create(vertexArray, mesh, shader, vertexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+            return;
+        }
+        auto& vertexArray = res->second;
+        glBindVertexArray(vertexArray.vaoID);
+        if (vertexAttribBinding){
+#ifndef EMSCRIPTEN
+            glBindVertexBuffer(0, vertexBuffer, 0, vertexArray.stride);
+#endif
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+            for (auto& p : vertexArray.pointers){
+                if (p.integer){
+                    glVertexAttribIPointer(p.location, p.elementCount, p.dataType, vertexArray.stride, BUFFER_OFFSET(p.offset));
+                } else {
+                    glVertexAttribPointer(p.location, p.elementCount, p.dataType, GL_FALSE, vertexArray.stride, BUFFER_OFFSET(p.offset));
+                }
+            }
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    }
+
+    void VertexArrayCache::create(VertexArray &vertexArray, Mesh *mesh, Shader *shader, unsigned int vertexBuffer) {
+        glGenVertexArrays(1, &vertexArray.vaoID);
+        glBindVertexArray(vertexArray.vaoID);
+        vertexArray.stride = mesh->totalBytesPerVertex;
+        mesh->setVertexAttributePointers(shader, &vertexArray.pointers);
+#ifndef EMSCRIPTEN
+        if (vertexAttribBinding){
+            // replace the attribute pointers with a vertex format using binding point 0
+            for (auto& p : vertexArray.pointers){
+                if (p.integer){
+                    glVertexAttribIFormat(p.location, p.elementCount, p.dataType, p.offset);
+                } else {
+                    glVertexAttribFormat(p.location, p.elementCount, p.dataType, GL_FALSE, p.offset);
+                }
+                glVertexAttribBinding(p.location, 0);
+            }
+            glBindVertexBuffer(0, vertexBuffer, 0, vertexArray.stride);
+        }
+#endif
+    }
+
+    void VertexArrayCache::removeShader(long shaderUniqueId) {
+        for (auto iter = vertexArrays.begin(); iter != vertexArrays.end();){
+            if (iter->first.second == shaderUniqueId){
+                glDeleteVertexArrays(1, &(iter->second.vaoID));
+                iter = vertexArrays.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+    }
+
+    void VertexArrayCache::clear() {
+        for (auto& vertexArray : vertexArrays){
+            glDeleteVertexArrays(1, &(vertexArray.second.vaoID));
+        }
+        vertexArrays.clear();
+    }
+
+    int VertexArrayCache::getVertexArrayCount() {
+        return (int)vertexArrays.size();
+    }
+
+    int VertexArrayCache::getLayoutCount() {
+        return (int)layoutIds.size();
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergensen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/impl/VertexWelder.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace sre {
+    VertexWelder::VertexWelder(int keyWords, int expectedCount)
+    :keyWords(keyWords)
+    {
+        size_t tableSize = 16;
+        while (tableSize < (size_t)expectedCount * 2){
+            tableSize *= 2;
+        }
+        table.assign(tableSize, -1);
+        mask = tableSize - 1;
+        keys.reserve((size_t)expectedCount * keyWords);
+    }
+
+    uint64_t VertexWelder::hash(const uint32_t *key) const {
+        // multiply-rotate per word followed by the murmur3 finalizer, which avalanches all bits. Small integer keys
+        // (such as obj indices) are distributed over the whole table
+        uint64_t h = 0x9e3779b97f4a7c15ull ^ (uint64_t)keyWords;
+        for (int i=0;i<keyWords;i++){
+            h = (h ^ key[i]) * 0xff51afd7ed558ccdull;
+            h = (h << 31) | (h >> 33);
+        }
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    int VertexWelder::insert(const uint32_t *key) {
+        if ((size_t)(count + 1) * 2 > table.size()){
+            grow();
+        }
+        size_t keyBytes = keyWords * sizeof(uint32_t);
+        for (uint64_t slot = hash(key) & mask;; slot = (slot + 1) & mask){
+            int32_t index = table[slot];
+            if (index == -1){
+                table[slot] = count;
+                keys.insert(keys.end(), key, key + keyWords);
+                return count++;
+            }
+            if (memcmp(keys.data() + (size_t)index * keyWords, key, keyBytes) == 0){
+                return index;
+            }
+        }
+    }
+
+    int VertexWelder::size() const {
+        return count;
+    }
+
+    const uint32_t *VertexWelder::getKey(int index) const {
+        return keys.data() + (size_t)index * keyWords;
+    }
+
+    void VertexWelder::clear() {
+        count = 0;
+        keys.clear();
+        std::fill(table.begin(), table.end(), -1);
+    }
+
+    void VertexWelder::grow() {
+        table.assign(table.size() * 2, -1);
+        mask = table.size() - 1;
+        for (int i=0;i<count;i++){
+            uint64_t slot = hash(getKey(i)) & mask;
+            while (table[slot] != -1){
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = i;
+        }
+    }
+}
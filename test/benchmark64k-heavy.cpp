@@ -6,6 +6,7 @@
 #include "sre/Renderer.hpp"
 #include "sre/Material.hpp"
 #include "sre/SDLRenderer.hpp"
+#include "sre/ResourceCache.hpp"
 
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -35,14 +36,7 @@ public:
         renderTime.resize(BOX_GRID_DIM+1,0);
         stateChanges.resize(BOX_GRID_DIM+1,0);
         drawCalls.resize(BOX_GRID_DIM+1,0);
-        meshes = {
-                Mesh::create().withCube(0.25f).build(),
-                Mesh::create().withSphere().build(),
-                Mesh::create().withTorus().build(),
-                Mesh::create().withQuad().build(),
-                Mesh::create().withCube(0.35f).build(),
-        };
-
+        createMeshes();
 
         materials = {
                 Shader::getUnlit()->createMaterial(),
@@ -57,9 +51,9 @@ public:
         for (int i = 0;i<materials.size();i++){
             // explicit use
             if (i % 2==0){
-                materials[i]->setTexture(Texture::create().withFile("test_data/t_explosionsheet.png").withGenerateMipmaps(true).build());
+                materials[i]->setTexture(ResourceCache::getTexture("test_data/t_explosionsheet.png", true));
             } else {
-                materials[i]->setTexture(Texture::create().withFile("test_data/gamma-test.png").withGenerateMipmaps(true).build());
+                materials[i]->setTexture(ResourceCache::getTexture("test_data/gamma-test.png", true));
             }
         }
 
@@ -158,6 +152,9 @@ public:
 
         }
         ImGui::Checkbox("Camera in center",&cameraInCenter);
+        if (ImGui::Checkbox("Geometry arena",&useGeometryArena)){
+            createMeshes();
+        }
 
         if (benchmarkCount >= 0){
             ImGui::LabelText("","Benchmark running");
@@ -184,12 +181,22 @@ public:
         inspector.gui();
 
     }
+    void createMeshes(){
+        meshes = {
+                Mesh::create().withCube(0.25f).withGeometryArena(useGeometryArena).build(),
+                Mesh::create().withSphere().withGeometryArena(useGeometryArena).build(),
+                Mesh::create().withTorus().withGeometryArena(useGeometryArena).build(),
+                Mesh::create().withQuad().withGeometryArena(useGeometryArena).build(),
+                Mesh::create().withCube(0.35f).withGeometryArena(useGeometryArena).build(),
+        };
+    }
 private:
     int gridSize = BOX_GRID_DIM/2;
     float eyeRadius = 30;
     float eyeRotation = 0;
     glm::vec3 eyePosition = {0, eyeRadius, 0};
     bool cameraInCenter = false;
+    bool useGeometryArena = false;
     SDLRenderer r;
     Camera *camera;
     WorldLights worldLights;
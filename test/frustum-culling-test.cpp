@@ -0,0 +1,88 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Inspector.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+using namespace sre;
+
+// A grid of cubes from 2 to 200 units around the camera. The camera rotates, so cubes behind the camera or outside the
+// field of view are culled, while visible cubes (also the distant ones) are drawn. Enabling and disabling the culling
+// must not change the image.
+class FrustumCullingTest {
+public:
+    FrustumCullingTest(){
+        r.init();
+
+        camera.setPerspectiveProjection(60,0.1,500);
+        mesh = Mesh::create().withCube(0.5f).build();
+        for (int i=0;i<4;i++){                              // colored by distance to the camera
+            materials.push_back(Shader::getStandardBlinnPhong()->createMaterial());
+            materials.back()->setColor(Color(1.0f - i*0.25f, 0.25f + i*0.25f, 0.5f));
+        }
+        worldLights.setAmbientLight({0.3f,0.3f,0.3f});
+        worldLights.addLight(Light::create().withDirectionalLight(glm::normalize(glm::vec3(1,1,1))).build());
+        for (int x=-gridSize;x<=gridSize;x++){
+            for (int z=-gridSize;z<=gridSize;z++){
+                if (x == 0 && z == 0){
+                    continue;
+                }
+                positions.push_back(glm::vec3(x*spacing, 0, z*spacing));
+            }
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void render(){
+        rotation += speed * 0.016f;
+        camera.lookAt({0,1,0},{std::sin(rotation),1,std::cos(rotation)},{0,1,0});
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withFrustumCulling(culling)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+
+        for (auto& pos : positions){
+            int distance = std::min((int)(glm::length(pos) / (gridSize*spacing) * 4), 3);
+            renderPass.draw(mesh, glm::translate(pos), materials[distance]);
+        }
+
+        ImGui::Checkbox("Frustum culling", &culling);
+        ImGui::DragFloat("Speed", &speed, 0.01f, 0, 2);
+        auto& stats = Renderer::instance->getRenderStats();
+        ImGui::LabelText("Drawn / culled","%i / %i",stats.drawCalls,stats.meshesCulled);
+        ImGui::LabelText("Objects","%i",(int)positions.size());
+        inspector.update();
+        inspector.gui();
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    WorldLights worldLights;
+    Inspector inspector;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<glm::vec3> positions;
+    const int gridSize = 50;
+    const float spacing = 2;
+    bool culling = true;
+    float rotation = 0;
+    float speed = 0.3f;
+};
+
+int main() {
+    new FrustumCullingTest();
+    return 0;
+}
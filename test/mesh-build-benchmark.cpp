@@ -0,0 +1,123 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+
+using namespace sre;
+
+// Measures the mesh build throughput (interleaving, bounds computation and upload) in vertices per second
+// and compares it with loading the same mesh from a binary .sremesh file (optionally compressed).
+// Also measures welding the duplicate vertices of a non-indexed sphere
+class MeshBuildBenchmark {
+public:
+    MeshBuildBenchmark(){
+        r.init();
+
+        camera.lookAt({0,0,3},{0,0,0},{0,1,0});
+        camera.setPerspectiveProjection(60,0.1,100);
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void benchmark(){
+        std::vector<glm::vec3> positions(vertexCount);
+        std::vector<glm::vec3> normals(vertexCount, glm::vec3(0,0,1));
+        std::vector<glm::vec4> uvs(vertexCount);
+        for (int i=0;i<vertexCount;i++){
+            positions[i] = glm::vec3(i%1000, (i/1000)%1000, i/1000000);
+            uvs[i] = glm::vec4(positions[i]*0.001f, 1);
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        mesh = Mesh::create()
+                .withPositions(positions)
+                .withNormals(normals)
+                .withUVs(uvs)
+                .build();
+        auto end = std::chrono::high_resolution_clock::now();
+        buildSeconds = std::chrono::duration<double>(end - start).count();
+        builtVertexCount = vertexCount;
+        std::cout << "Mesh build "<<vertexCount<<" vertices: "<<(buildSeconds*1000)<<" ms ("<<(vertexCount/buildSeconds)<<" vertices/sec)"<<std::endl;
+        loadSeconds = 0;
+    }
+
+    void benchmarkBinary(){
+        if (!mesh->saveBinary("benchmark.sremesh", compress)){
+            return;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        auto loadedMesh = Mesh::loadBinary("benchmark.sremesh");
+        auto end = std::chrono::high_resolution_clock::now();
+        if (loadedMesh){
+            mesh = loadedMesh;
+            loadSeconds = std::chrono::duration<double>(end - start).count();
+            std::cout << "Mesh binary load "<<mesh->getVertexCount()<<" vertices: "<<(loadSeconds*1000)<<" ms ("<<(mesh->getVertexCount()/loadSeconds)<<" vertices/sec)"<<std::endl;
+        }
+    }
+
+    void benchmarkWeld(){
+        auto sphere = Mesh::create().withSphere(128, 256).build();
+        weldVerticesBefore = sphere->getVertexCount();
+        auto start = std::chrono::high_resolution_clock::now();
+        sphere->weld();
+        auto end = std::chrono::high_resolution_clock::now();
+        weldSeconds = std::chrono::duration<double>(end - start).count();
+        weldVerticesAfter = sphere->getVertexCount();
+        std::cout << "Mesh weld "<<weldVerticesBefore<<" -> "<<weldVerticesAfter<<" vertices: "<<(weldSeconds*1000)<<" ms"<<std::endl;
+    }
+
+    void render(){
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+
+        ImGui::DragInt("Vertices",&vertexCount,10000,1000,10000000);
+        if (ImGui::Button("Build mesh")){
+            benchmark();
+        }
+        if (mesh){
+            ImGui::LabelText("Build time","%.2f ms",buildSeconds*1000);
+            ImGui::LabelText("Throughput","%.2f M vertices/sec",builtVertexCount/buildSeconds/1000000);
+            ImGui::Checkbox("Compress",&compress);
+            ImGui::SameLine();
+            if (ImGui::Button("Save and load binary")){
+                benchmarkBinary();
+            }
+            if (loadSeconds > 0){
+                ImGui::LabelText("Binary load time","%.2f ms",loadSeconds*1000);
+                ImGui::LabelText("Binary throughput","%.2f M vertices/sec",builtVertexCount/loadSeconds/1000000);
+            }
+        }
+        if (ImGui::Button("Weld sphere")){
+            benchmarkWeld();
+        }
+        if (weldSeconds > 0){
+            ImGui::LabelText("Weld time","%.2f ms",weldSeconds*1000);
+            ImGui::LabelText("Weld vertices","%i -> %i",weldVerticesBefore,weldVerticesAfter);
+        }
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    std::shared_ptr<Mesh> mesh;
+    int vertexCount = 3000000;
+    int builtVertexCount = 0;
+    double buildSeconds = 0;
+    double loadSeconds = 0;
+    bool compress = false;
+    double weldSeconds = 0;
+    int weldVerticesBefore = 0;
+    int weldVerticesAfter = 0;
+};
+
+int main() {
+    new MeshBuildBenchmark();
+    return 0;
+}
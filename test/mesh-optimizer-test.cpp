@@ -0,0 +1,121 @@
+#include <iostream>
+#include <vector>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/MeshOptimizer.hpp"
+
+#include <glm/gtx/euler_angles.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace sre;
+
+// Renders a mesh with and without MeshBuilder::withOptimize() and shows the vertex cache statistics.
+// With LODs enabled the level of detail is selected based on the camera distance
+class MeshOptimizerTest {
+public:
+    MeshOptimizerTest(){
+        r.init();
+
+        camera.lookAt({0,0,3},{0,0,0},{0,1,0});
+        camera.setPerspectiveProjection(60,0.1,100);
+
+        material = Shader::getStandardBlinnPhong()->createMaterial();
+        material->setColor({1.0f,1.0f,1.0f,1.0f});
+        material->setSpecularity(Color(1,1,1,20.0f));
+
+        worldLights.setAmbientLight({0.1,0.1,0.1});
+        worldLights.addLight(Light::create().withDirectionalLight({1, 1,1}).build());
+
+        updateMesh();
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    void updateMesh(){
+        std::vector<float> lodRatios;
+        if (lods){
+            lodRatios = {0.5f, 0.25f, 0.125f};
+        }
+        int meshletVertices = meshlets ? 64 : 0;
+        switch (primitive){
+            case 0:
+                mesh = Mesh::create().withSphere(64,128).withOptimize(optimize).withLODs(lodRatios).withMeshlets(meshletVertices).build();
+                break;
+            case 1:
+                mesh = Mesh::create().withTorus(96,48).withOptimize(optimize).withLODs(lodRatios).withMeshlets(meshletVertices).build();
+                break;
+            default:
+                std::cout << "Err"<<std::endl;
+        }
+
+        stats.clear();
+        for (int i=0;i<mesh->getIndexSets();i++){
+            stats.push_back(MeshOptimizer::analyzeVertexCache(mesh->getIndices(i), mesh->getVertexCount()));
+        }
+    }
+
+    void render(){
+        camera.lookAt({0,0,distance},{0,0,0},{0,1,0});
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withWorldLights(&worldLights)
+                .withClearColor(true, {0, 0, 0, 1})
+                .withLODBias(lodBias)
+                .build();
+        renderPass.draw(mesh, glm::eulerAngleY(glm::radians((float)i*0.5f)), material);
+
+        bool changed = ImGui::Combo("Primitive",&primitive,"Sphere\0Torus\0");
+        changed |= ImGui::Checkbox("Optimize",&optimize);
+        changed |= ImGui::Checkbox("LODs",&lods);
+        changed |= ImGui::Checkbox("Meshlets",&meshlets);
+        ImGui::DragFloat("Distance",&distance,0.1f,1.5f,100.0f);
+        ImGui::DragFloat("LOD bias",&lodBias,0.01f,0.1f,4.0f);
+        if (changed){
+            updateMesh();
+        }
+        ImGui::LabelText("Vertices","%i",mesh->getVertexCount());
+        if (stats.empty()){
+            ImGui::LabelText("ACMR","Non-indexed");
+        }
+        for (auto& s : stats){
+            ImGui::LabelText("ACMR","%.3f",s.acmr);
+            ImGui::LabelText("ATVR","%.3f",s.atvr);
+        }
+        for (int lod=0;lod<mesh->getLODCount();lod++){
+            ImGui::LabelText(("LOD "+std::to_string(lod)).c_str(),"%i triangles",mesh->getLODIndicesSize(lod)/3);
+        }
+        ImGui::LabelText("Meshlets","%i (%i culled)",mesh->getMeshletCount(),meshletsCulled);
+        ImGui::LabelText("Triangles","%i",triangles);
+        renderPass.finish();
+        meshletsCulled = Renderer::instance->getRenderStats().meshletsCulled;
+        triangles = Renderer::instance->getRenderStats().triangles;
+        i++;
+    }
+private:
+    int primitive = 0;
+    bool optimize = true;
+    bool lods = false;
+    bool meshlets = false;
+    int meshletsCulled = 0;
+    int triangles = 0;
+    float distance = 3;
+    float lodBias = 1;
+    SDLRenderer r;
+    Camera camera;
+    WorldLights worldLights;
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Material> material;
+    std::vector<MeshOptimizer::VertexCacheStats> stats;
+    int i=0;
+};
+
+int main() {
+    new MeshOptimizerTest();
+    return 0;
+}
@@ -18,6 +18,7 @@
 #include <glm/gtx/rotate_vector.hpp>
 #include <sre/SpriteAtlas.hpp>
 #include <sre/Inspector.hpp>
+#include <sre/ModelImporter.hpp>
 
 using namespace sre;
 
@@ -71,6 +72,7 @@ public:
             Mesh::create().withCube().build(),
             Mesh::create().withTorus(48,48).build()
         }};
+        loadGltf();                                         // test_data/BoomBoxCube.gltf (external .bin buffer and textures)
 
         r.frameRender = [&](){
             render();
@@ -124,7 +126,11 @@ public:
                 .withWorldLights(lightCount==0?(&lightsSingle):(&lightsDuo))
                 .withClearColor(true, {.2f,.2f,.2f,1})
                 .build();
-        renderPass.draw(meshes[meshType],glm::mat4(1), material);
+        if (meshType == 3){
+            renderPass.draw(gltfMesh, glm::mat4(1), gltfMaterials);
+        } else {
+            renderPass.draw(meshes[meshType],glm::mat4(1), material);
+        }
 
         renderGUI();
         renderPass.finish();
@@ -190,7 +196,11 @@ public:
 
         }
         if (ImGui::CollapsingHeader("Model")){
-            ImGui::Combo("Mesh",&meshType, "Sphere\0Cube\0Torus\0");
+            ImGui::Combo("Mesh",&meshType, gltfMesh ? "Sphere\0Cube\0Torus\0glTF\0" : "Sphere\0Cube\0Torus\0");
+            ImGui::InputText("glTF file", gltfStr, maxTextSize);
+            if (ImGui::Button("Load glTF")){
+                loadGltf();
+            }
         }
         if (ImGui::CollapsingHeader("Shader")){
             updatedMat |= ImGui::Checkbox("pbrShader", &pbrShader);
@@ -217,6 +227,20 @@ public:
         inspector.gui();
     }
 
+    // load a .gltf or .glb file (e.g. BoomBox.glb from the Khronos glTF sample models). Uses the materials of the file
+    void loadGltf(){
+        std::string file = gltfStr;
+        auto separator = file.find_last_of("/\\");
+        std::string path = separator == std::string::npos ? "." : file.substr(0, separator);
+        std::vector<std::shared_ptr<Material>> materials;
+        auto mesh = ModelImporter::importGltf(path, file.substr(separator + 1), materials);
+        if (mesh){
+            gltfMesh = mesh;
+            gltfMaterials = materials;
+            meshType = 3;
+        }
+    }
+
     void updateLight(){
         lightsSingle.clear();
         lightsDuo.clear();
@@ -262,6 +286,9 @@ private:
 
     int meshType = 0;
     std::vector<std::shared_ptr<sre::Mesh>> meshes;
+    char gltfStr[maxTextSize] = "test_data/BoomBoxCube.gltf";
+    std::shared_ptr<sre::Mesh> gltfMesh;
+    std::vector<std::shared_ptr<Material>> gltfMaterials;
 
     int lightCount = 0;
     float lightDistance = 10;
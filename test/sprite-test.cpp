@@ -18,6 +18,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 #include <sre/SpriteAtlas.hpp>
+#include <sre/DynamicAtlas.hpp>
 #include <sre/Inspector.hpp>
 
 
@@ -43,6 +44,15 @@ public:
 
         atlas3 = SpriteAtlas::create("test_data/circle-slices-cropped.json","test_data/circle-slices-cropped.png");
 
+        // pack images loaded one by one and sprites of the other atlases into a dynamic atlas
+        dynamicAtlas = DynamicAtlas::create().withPageSize(512).build();
+        for (auto filename : {"basn0g08.png", "basn2c08.png", "basn3p04.png", "basn4a08.png", "basn6a08.png"}){
+            dynamicAtlas->addFile(filename, std::string("test_data/")+filename);
+        }
+        for (auto& name : atlas3->getNames()){
+            dynamicAtlas->add(name, atlas3->get(name));
+        }
+
         circle = Mesh::create().withSphere(32,64,512/2).build();
 
         quad = Mesh::create().withName("Tex mesh") .withPositions({{0,0,0}}).withUVs({{0,0,0,0}}).build();
@@ -119,6 +129,7 @@ public:
         ImGui::DragInt("sprite2 OrderInBatch", &spriteIndex2,1,0,10);
         ImGui::Checkbox("useSameAtlas", &useSameAtlas);
         ImGui::Checkbox("useAddSprites", &useAddSprites);
+        ImGui::Checkbox("Dynamic atlas", &showDynamicAtlas);
 
         sprite.setColor(color);
         sprite.setScale(scale);
@@ -143,6 +154,20 @@ public:
 
         renderPass.draw(sb);
 
+        if (showDynamicAtlas){
+            // all sprites of the dynamic atlas (drawn using one draw call per atlas page)
+            auto builder = SpriteBatch::create();
+            int i = 0;
+            for (auto& name : dynamicAtlas->getNames()){
+                auto dynamicSprite = dynamicAtlas->get(name);
+                dynamicSprite.setPosition({50 + (i%8)*80, 50 + (i/8)*80});
+                builder.addSprite(dynamicSprite);
+                i++;
+            }
+            renderPass.draw(builder.build());
+            ImGui::LabelText("Dynamic atlas pages", "%i (%.0f%% used)", dynamicAtlas->getPageCount(), dynamicAtlas->getPageUsage(0)*100);
+        }
+
         std::vector<glm::vec3> lines;
         auto spriteCorners = sprite.getTrimmedCorners();
         for (int i=0;i<4;i++){
@@ -170,6 +195,8 @@ private:
     Camera camera;
     bool useSameAtlas = false;
     bool useAddSprites = false;
+    bool showDynamicAtlas = false;
+    std::shared_ptr<DynamicAtlas> dynamicAtlas;
     std::shared_ptr<SpriteBatch> world;
 
     std::shared_ptr<Mesh> circle;
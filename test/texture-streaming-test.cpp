@@ -0,0 +1,110 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/TextureStreamer.hpp"
+#include "sre/Inspector.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+using namespace sre;
+
+// A corridor of quads using large streamed textures. Textures close to the camera are uploaded in full resolution,
+// distant textures keep their small mip levels. Lower the budget to see the least recently used textures evicted.
+class TextureStreamingTest {
+public:
+    TextureStreamingTest(){
+        r.init();
+
+        camera.setPerspectiveProjection(60,0.1,200);
+        mesh = Mesh::create().withQuad(1).build();
+        for (int i=0;i<textureCount;i++){
+            materials.push_back(Shader::getUnlit()->createMaterial());
+            materials.back()->setTexture(createTexture(i));
+        }
+
+        r.frameRender = [&](){
+            render();
+        };
+
+        r.startEventLoop();
+    }
+
+    std::shared_ptr<Texture> createTexture(int index){
+        const int size = 1024;
+        std::vector<char> data(size*size*4);
+        glm::u8vec3 color((index*97)%256, (index*57+128)%256, (index*31+64)%256);
+        for (int y=0;y<size;y++){
+            for (int x=0;x<size;x++){
+                bool checker = ((x/32)+(y/32))%2 == 0;
+                char* p = &data[(y*size+x)*4];
+                p[0] = checker ? color.r : (char)255;
+                p[1] = checker ? color.g : (char)255;
+                p[2] = checker ? color.b : (char)255;
+                p[3] = (char)255;
+            }
+        }
+        return Texture::create()
+                .withRGBAData(data.data(), size, size)
+                .withStreaming(true)
+                .withName(std::string("Streamed ")+std::to_string(index))
+                .build();
+    }
+
+    void render(){
+        position += speed * 0.016f;
+        if (position > textureCount*spacing){
+            position = 0;
+        }
+        camera.lookAt({0,0,-position},{0,0,-position-1},{0,1,0});
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+
+        for (int i=0;i<textureCount;i++){
+            float side = i%2 == 0 ? -1.0f : 1.0f;
+            auto transform = glm::translate(glm::vec3(side*1.5f, 0, -i*spacing)) * glm::rotate(-side*glm::radians(90.0f), glm::vec3(0,1,0));
+            renderPass.draw(mesh, transform, materials[i]);
+        }
+
+        if (ImGui::DragFloat("Budget MB", &budgetMB, 1, 0, 512)){
+            TextureStreamer::setBudget((int)(budgetMB*1000*1000));
+        }
+        if (ImGui::DragFloat("Mip bias", &mipBias, 0.1f, -2, 4)){
+            TextureStreamer::setMipBias(mipBias);
+        }
+        ImGui::DragFloat("Speed", &speed, 0.1f, 0, 50);
+        auto& stats = Renderer::instance->getRenderStats();
+        ImGui::LabelText("Texture memory","%.1f MB",stats.textureBytes/1000000.0f);
+        ImGui::LabelText("Pending","%i textures (%i mips)",stats.textureStreamingPending,stats.textureStreamingMissingMips);
+        ImGui::LabelText("Uploads / evictions","%i / %i",stats.textureStreamingUploads,stats.textureStreamingEvictions);
+        int bestMip = materials[0]->getTexture()->getResidentMipLevel();
+        for (auto& material : materials){
+            bestMip = std::min(bestMip, material->getTexture()->getResidentMipLevel());
+        }
+        ImGui::LabelText("Best resident mip","%i",bestMip);         // 0 when the closest textures are loaded in full resolution
+        inspector.update();
+        inspector.gui();
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    Inspector inspector;
+    std::shared_ptr<Mesh> mesh;
+    std::vector<std::shared_ptr<Material>> materials;
+    const int textureCount = 64;
+    const float spacing = 2.5f;
+    float position = 0;
+    float speed = 5;
+    float budgetMB = 0;
+    float mipBias = 0;
+};
+
+int main() {
+    new TextureStreamingTest();
+    return 0;
+}
@@ -19,6 +19,7 @@
 #include <glm/gtx/string_cast.hpp>
 #include <sre/SpriteAtlas.hpp>
 #include <sre/Inspector.hpp>
+#include <sre/AssetLoader.hpp>
 
 
 using namespace sre;
@@ -28,6 +29,7 @@ public:
 	TextureTestExample()
     {
         r.init();
+        Texture::setCompressionCacheDirectory("texture_cache");
 
         camera.setOrthographicProjection(3,-2,2);
 
@@ -47,10 +49,12 @@ public:
 			"basn6a16.png"
 		};
         
+		// textures are decoded in the background and uploaded by the SDLRenderer event loop
 		for (const auto s : filenames)
 		{
-			std::cout << "Load " << s << std::endl;
-			textures.push_back(Texture::create().withFile(std::string("test_data/")+s).build());
+			textures.push_back(AssetLoader::loadTexture(std::string("test_data/")+s, false, [s](std::shared_ptr<Texture> texture){
+				std::cout << "Loaded " << s << (texture ? "" : " (failed)") << std::endl;
+			}));
 		}
 
 		mesh = Mesh::create().withCube().build();
@@ -91,25 +95,52 @@ public:
 			ImGui::LabelText("png type", "Alpha");
 		}
 
-		ImGui::LabelText("Size", "%d x %d", textures[selection]->getWidth(), textures[selection]->getHeight());
-		ImGui::LabelText("Transparent", "%s", textures[selection]->isTransparent()?"true":"false");
+		auto texture = textures[selection].get();
+		if (!texture){
+			ImGui::LabelText("Status", "%s", textures[selection].isFailed() ? "Failed" : "Loading");
+			return;
+		}
+		ImGui::LabelText("Size", "%d x %d", texture->getWidth(), texture->getHeight());
+		ImGui::LabelText("Transparent", "%s", texture->isTransparent()?"true":"false");
 		const char* colorSpace;
-		if (textures[selection]->getSamplerColorSpace() == Texture::SamplerColorspace::Gamma){
+		if (texture->getSamplerColorSpace() == Texture::SamplerColorspace::Gamma){
 			colorSpace = "Gamma";
 		} else {
 			colorSpace = "Linear";
 		}
 		ImGui::LabelText("Colorspace", "%s", colorSpace);
 
-		material->setTexture(textures[selection]);
+		// CPU texture compression
+		const char* compressionNames[] = {"None", "BC1", "BC3", "BC5", "BC7", "ETC2 RGB", "ETC2 RGBA"};
+		if (ImGui::Combo("Compression", &compression, compressionNames, IM_ARRAYSIZE(compressionNames)) || compressedSelection != selection){
+			compressedTexture.reset();
+			compressedSelection = selection;
+			if (compression != 0){
+				compressedTexture = Texture::create()
+						.withFile(std::string("test_data/")+filenames[selection])
+						.withCompression((Texture::Compression)compression)
+						.withGenerateMipmaps(true)
+						.build();
+			}
+		}
+		ImGui::LabelText("GPU support", "%s", Texture::isCompressionSupported((Texture::Compression)compression)?"true":"false");
+		if (compressedTexture){
+			texture = compressedTexture;
+		}
+		ImGui::LabelText("Data size", "%i bytes", texture->getDataSize());
+
+		material->setTexture(texture);
 		renderPass.draw(mesh, glm::mat4(1), material);
     }
 private:    
 	std::vector<const char*> filenames;
-	std::vector<std::shared_ptr<sre::Texture>> textures;
+	std::vector<sre::AssetHandle<sre::Texture>> textures;
     SDLRenderer r;
     Camera camera;
 	int selection = 0;
+	int compression = 0;
+	int compressedSelection = -1;
+	std::shared_ptr<sre::Texture> compressedTexture;
 
 	std::shared_ptr<sre::Mesh> mesh;
 	std::shared_ptr<sre::Material> material;
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+#include "sre/Renderer.hpp"
+#include "sre/Material.hpp"
+#include "sre/SDLRenderer.hpp"
+#include "sre/Inspector.hpp"
+
+#include <glm/gtx/transform.hpp>
+
+using namespace sre;
+
+// Updates an animated video-like frame each frame using Texture::updateRegion(). Click and drag on the quad to paint
+// small regions into a second (heatmap) texture. Toggle the pixel buffers to compare direct uploads with uploads through
+// the double-buffered pixel buffer objects.
+class TextureUpdateTest {
+public:
+    TextureUpdateTest(){
+        r.setWindowSize({1024,512});                        // the quads fill the left and right half of the window
+        r.init();
+
+        camera.setOrthographicProjection(1,-2,2);
+        mesh = Mesh::create().withQuad(1).build();
+        frame.resize(frameWidth*frameHeight*4);
+        for (int i=0;i<2;i++){
+            frameTextures[i] = Texture::create()
+                    .withRGBAData(nullptr, frameWidth, frameHeight)
+                    .withFilterSampling(true)
+                    .withPixelBuffers(i == 1)
+                    .withName(i == 1 ? "Video frame (pixel buffers)" : "Video frame")
+                    .build();
+        }
+        std::vector<char> black(heatmapSize*heatmapSize*3, 0);
+        heatmap = Texture::create()
+                .withRGBData(black.data(), heatmapSize, heatmapSize)
+                .withGenerateMipmaps(true)
+                .withName("Heatmap")
+                .build();
+        frameMaterial = Shader::getUnlit()->createMaterial();
+        heatmapMaterial = Shader::getUnlit()->createMaterial();
+        heatmapMaterial->setTexture(heatmap);
+
+        r.frameRender = [&](){
+            render();
+        };
+        r.mouseEvent = [&](SDL_Event& e){
+            if (e.type == SDL_MOUSEMOTION && (e.motion.state & SDL_BUTTON_LMASK)){
+                paint(e.motion.x, e.motion.y);
+            }
+        };
+
+        r.startEventLoop();
+    }
+
+    void updateFrame(){
+        time += 0.016f;
+        for (int y=0;y<frameHeight;y++){
+            for (int x=0;x<frameWidth;x++){
+                float v = std::sin(x*0.01f + time) + std::sin(y*0.013f - time*1.3f) + std::sin((x+y)*0.007f + time*0.7f);
+                char* p = &frame[(y*frameWidth+x)*4];
+                p[0] = (char)(127 + 127*std::sin(v));
+                p[1] = (char)(127 + 127*std::sin(v + 2.094f));
+                p[2] = (char)(127 + 127*std::sin(v + 4.189f));
+                p[3] = (char)255;
+            }
+        }
+        frameTextures[usePixelBuffers?1:0]->updateRegion(0, 0, frameWidth, frameHeight, frame.data());
+    }
+
+    void paint(int mouseX, int mouseY){
+        auto windowSize = Renderer::instance->getWindowSize();
+        // map the mouse position to the heatmap quad (right half of the window)
+        float u = (mouseX - windowSize.x*0.5f) / (windowSize.x*0.5f);
+        float v = 1.0f - mouseY / (float)windowSize.y;
+        const int brush = 8;
+        int x = (int)(u*heatmapSize) - brush/2;
+        int y = (int)(v*heatmapSize) - brush/2;
+        if (x < 0 || y < 0 || x + brush > heatmapSize || y + brush > heatmapSize){
+            return;
+        }
+        std::vector<char> pixels(brush*brush*3);
+        for (int i=0;i<brush*brush;i++){
+            pixels[i*3+0] = (char)255;
+            pixels[i*3+1] = (char)(128 + (i%brush)*16);
+            pixels[i*3+2] = 0;
+        }
+        heatmap->updateRegion(x, y, brush, brush, pixels.data());
+    }
+
+    void render(){
+        updateFrame();
+        frameMaterial->setTexture(frameTextures[usePixelBuffers?1:0]);
+        auto renderPass = RenderPass::create()
+                .withCamera(camera)
+                .withClearColor(true, {0, 0, 0, 1})
+                .build();
+        renderPass.draw(mesh, glm::translate(glm::vec3(-1, 0, 0)), frameMaterial);
+        renderPass.draw(mesh, glm::translate(glm::vec3(1, 0, 0)), heatmapMaterial);
+
+        ImGui::Checkbox("Pixel buffers", &usePixelBuffers);
+        auto& stats = Renderer::instance->getRenderStats();
+        ImGui::LabelText("Updated","%.1f MB / frame",stats.textureBytesUpdated/1000000.0f);
+        ImGui::LabelText("Allocated","%.1f MB / frame",stats.textureBytesAllocated/1000000.0f);
+        inspector.update();
+        inspector.gui();
+    }
+private:
+    SDLRenderer r;
+    Camera camera;
+    Inspector inspector;
+    std::shared_ptr<Mesh> mesh;
+    std::shared_ptr<Texture> frameTextures[2];
+    std::shared_ptr<Texture> heatmap;
+    std::shared_ptr<Material> frameMaterial;
+    std::shared_ptr<Material> heatmapMaterial;
+    std::vector<char> frame;
+    const int frameWidth = 1024;
+    const int frameHeight = 512;
+    const int heatmapSize = 256;
+    bool usePixelBuffers = true;
+    float time = 0;
+};
+
+int main() {
+    new TextureUpdateTest();
+    return 0;
+}